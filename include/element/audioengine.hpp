@@ -19,6 +19,9 @@ class RootGraph;
 class AudioEngine final : public juce::ReferenceCountedObject {
 public:
     Signal<void()> sampleLatencyChanged;
+    /** Emitted on the message thread when the rendered graph changed, also
+        when a program change switched it. */
+    Signal<void (int)> activeGraphChanged;
     AudioEngine (Context&, RunMode mode = RunMode::Standalone);
     virtual ~AudioEngine() noexcept;
 
@@ -57,8 +57,10 @@ public:
 
         if (isNoteEvent()) {
             midi = juce::MidiMessage::noteOn (1, getEventId(), (uint8) 64);
-        } else if (isControllerEvent()) {
+        } else if (isControllerEvent() || isController14Event()) {
             midi = juce::MidiMessage::controllerEvent (1, getEventId(), 64);
+        } else if (isNrpnEvent()) {
+            midi = juce::MidiMessage::controllerEvent (1, 6, 64);
         }
 
         return midi;
@@ -66,6 +68,14 @@ public:
 
     bool isNoteEvent() const { return getProperty ("eventType").toString() == "note"; }
     bool isControllerEvent() const { return getProperty ("eventType").toString() == "controller"; }
+
+    /** A 14-bit controller. The event ID is the MSB controller, 0-31, and
+        the LSB is the controller 32 above it. */
+    bool isController14Event() const { return getProperty ("eventType").toString() == "controller14"; }
+
+    /** An NRPN. The event ID is the 14-bit parameter number. */
+    bool isNrpnEvent() const { return getProperty ("eventType").toString() == "nrpn"; }
+
     int getEventId() const { return (int) getProperty ("eventId", 0); }
 
     bool isMomentary() const { return (bool) getProperty ("momentary", false); }
@@ -122,6 +122,16 @@ public:
     /** called when the session loads or re-loads */
     void sessionReloaded();
 
+    /** Load or unload root graphs around the active one.
+
+        In setlist mode only the active graph, the graphs following it and
+        the ones used most recently stay loaded, up to the standby count in
+        Settings. Graphs which aren't loaded are still attached to the engine,
+        so they load in place when made active. Outside of setlist mode this
+        makes sure every graph is loaded.
+     */
+    void updateStandbyGraphs();
+
     /** replace a node with a given plugin */
     void replace (const Node&, const PluginDescription&);
 
@@ -129,11 +139,15 @@ public:
 
     Signal<void (const Node&)> sigNodeRemoved;
 
+    /** Emitted on the message thread as a root graph's nodes load. */
+    Signal<void (const Node& graph, int numLoaded, int numNodes)> sigGraphLoadProgress;
+
 private:
     friend struct RootGraphHolder;
     class RootGraphs;
     friend class RootGraphs;
     std::unique_ptr<RootGraphs> graphs;
+    SignalConnection activeGraphChangedConnection;
 
     friend class ChangeBroadcaster;
     Node addPlugin (GraphManager& controller, const PluginDescription& desc);
@@ -22,6 +22,10 @@ public:
 
     String nameForURI (const String& uri) const noexcept;
 
+    /** Returns the bundle directory of a plugin, or an empty string if the
+        plugin isn't known. */
+    String bundleForURI (const String& uri) const noexcept;
+
 private:
     class LV2;
     std::unique_ptr<LV2> lv2;
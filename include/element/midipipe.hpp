@@ -31,6 +31,14 @@ public:
     void clear (int startSample, int numSamples);
     void clear (int index, int startSample, int numSamples);
 
+    /** Multiply every timestamp by multiplier / divisor, rewriting the buffers
+        in place. Doesn't allocate and keeps events in order, so it is safe to
+        use on the audio thread, e.g. when a node runs oversampled. */
+    void scaleTimestamps (int multiplier, int divisor) noexcept;
+
+    /** Multiply every timestamp in a buffer by multiplier / divisor, in place. */
+    static void scaleTimestamps (juce::MidiBuffer& buffer, int multiplier, int divisor) noexcept;
+
 private:
     enum {
         maxReferencedBuffers = 64
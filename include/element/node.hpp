@@ -207,6 +207,20 @@ public:
     /** Change the mute status of inputs on this Node */
     void setMuteInput (bool);
 
+    /** Returns true if this Node skips processing while its inputs are silent */
+    bool sleepsWhenSilent() const { return (bool) getProperty (tags::sleepWhenSilent, false); }
+
+    /** Skip processing while the inputs are silent and the tail has rung out */
+    void setSleepWhenSilent (bool);
+
+    /** Returns the tail in seconds used before sleeping, negative if the
+        plugin's own tail is used */
+    double getSilenceTail() const { return (double) getProperty (tags::silenceTail, -1.0); }
+
+    /** Change the tail used before sleeping. Pass a negative value to use
+        the tail reported by the plugin */
+    void setSilenceTail (double seconds);
+
     //=========================================================================
     /** Returns the number of connections on this node */
     int getNumConnections() const;
@@ -386,6 +400,25 @@ public:
     /** Reads state property and applies to Processor */
     void restorePluginState();
 
+    /** A copy of the saved program and state of a plugin. */
+    struct PluginState
+    {
+        int program = -1;
+        MemoryBlock state;
+        MemoryBlock programState;
+
+        /** Apply to a processor. This only touches the processor, so can be
+            used from any thread the processor's format allows. */
+        void applyTo (Processor& object) const;
+    };
+
+    /** Returns a copy of the saved program and state of the plugin. */
+    PluginState getPluginState() const;
+
+    /** Applies settings like gain, bypass and MIDI channels to Processor,
+        but not the plugin's own state. */
+    void restoreSettings();
+
     //=========================================================================
     /** Get the number of factory presets */
     int getNumPrograms() const;
@@ -13,6 +13,17 @@ class Oversampler final {
 public:
     using ProcessorType = juce::dsp::Oversampling<SampleType>;
 
+    /** Filter choices, from cheapest to best sounding */
+    enum Quality {
+        /** Polyphase IIR, little latency but not phase linear */
+        lowLatency = 0,
+        /** Equiripple FIR, linear phase */
+        linearPhase,
+        /** Steepest FIR, for offline rendering */
+        maxQuality,
+        numQualities
+    };
+
     Oversampler() = default;
     ~Oversampler();
 
@@ -21,6 +32,11 @@ public:
 
     float getLatencySamples (int index) const;
     int getFactor (int index) const;
+
+    /** Change the filters used. Takes effect on the next call to prepare. */
+    void setQuality (Quality newQuality) noexcept { quality = newQuality; }
+    Quality getQuality() const noexcept { return quality; }
+
     void prepare (int numChannels, int blockSize);
     void reset();
 
@@ -30,6 +46,8 @@ private:
     };
     int channels = 0,
         buffer = 0;
+    Quality quality = lowLatency,
+            preparedQuality = lowLatency;
     juce::OwnedArray<ProcessorType> processors;
 };
 
@@ -148,10 +148,25 @@ public:
         virtual void audioPluginScanFinished() {}
         virtual void audioPluginScanProgress (const float progress) { juce::ignoreUnused (progress); }
         virtual void audioPluginScanStarted (const juce::String& name) {}
+
+        /** Called before audioPluginScanFinished when some scanner processes
+            gave no results, even after scanning their share again. */
+        virtual void audioPluginScanFailed (const juce::String& message) { juce::ignoreUnused (message); }
     };
 
+    /** Returns the file holding the combined results of the last scan. */
     static const juce::File& getWorkerPluginListFile();
 
+    /** Returns a sensible number of scanner processes for this machine. */
+    static int getDefaultNumWorkers();
+
+    /** Set the number of scanner processes used by the next scan. Plugin
+        files are split evenly between them. */
+    void setNumWorkers (int newNumWorkers) { numWorkers = juce::jmax (1, newNumWorkers); }
+
+    /** Returns the number of scanner processes used when scanning. */
+    int getNumWorkers() const noexcept { return numWorkers; }
+
     /** scan for plugins of type */
     void scanForAudioPlugins (const juce::String& formatName);
 
@@ -176,10 +191,15 @@ public:
 private:
     friend class PluginScannerCoordinator;
     friend class juce::Timer;
-    std::unique_ptr<PluginScannerCoordinator> master;
+    juce::OwnedArray<PluginScannerCoordinator> coordinators;
     juce::ListenerList<Listener> listeners;
     juce::StringArray failedIdentifiers;
     juce::KnownPluginList& list;
+    int numWorkers;
+    juce::StringArray formatsToScan;
+    juce::Array<int> retriedSlots;
+    void workerProgressChanged();
+    void workerFinished();
     void timerCallback() override;
 };
 
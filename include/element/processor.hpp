@@ -245,7 +245,9 @@ public:
     /** Returns true if the processor is suspended */
     bool isSuspended() const;
 
-    /** Suspend processing */
+    /** Suspend processing. Safe to call from the audio thread, in which
+        case rendering follows at once and listeners are told later on the
+        message thread. */
     void suspendProcessing (const bool);
 
     /** Get latency audio samples */
@@ -283,6 +285,18 @@ public:
      */
     GraphNode* getParentGraph() const;
 
+    /** Start measuring this node's levels. Meters call this when they begin
+        showing the node and unsubscribeFromLevels() when they stop. Nothing
+        is measured while there are no subscribers.
+     */
+    void subscribeToLevels() noexcept { ++levelSubscribers; }
+
+    /** Stop measuring levels for one subscriber. */
+    void unsubscribeFromLevels() noexcept;
+
+    /** Returns true if anything is showing this node's levels. */
+    bool isMeteringLevels() const noexcept { return levelSubscribers.get() > 0; }
+
     void setInputRMS (int chan, float val);
     float getInputRMS (int chan) const { return (chan < inRMS.size()) ? inRMS.getUnchecked (chan)->get() : 0.0f; }
     void setOutputRMS (int chan, float val);
@@ -299,6 +313,11 @@ public:
     /** Returns true if this node is enabled */
     inline bool isEnabled() const { return enabled.get() == 1; }
 
+    /** Returns the state last passed to setEnabled. It differs from
+        isEnabled() until the message thread has prepared or released
+        the node. */
+    inline bool isEnabledRequested() const { return enablement.requested.get() == 1; }
+
     //=========================================================================
     inline void setKeyRange (const int low, const int high)
     {
@@ -410,11 +429,31 @@ public:
     }
 
     //==========================================================================
+    /** Mute or unmute. Safe to call from the audio thread, see suspendProcessing. */
     void setMuted (bool muted);
     bool isMuted() const { return mute.get() == 1; }
     void setMuteInput (bool shouldMuteInput) { muteInput.set (shouldMuteInput ? 1 : 0); }
     bool isMutingInputs() const { return muteInput.get() == 1; }
 
+    //==========================================================================
+    /** Let the graph skip this node while its inputs are silent and its tail
+        has rung out. Off by default, leave it off for generators which make
+        sound without input.
+     */
+    void setSleepWhenSilent (bool shouldSleep) { sleepWhenSilent.set (shouldSleep ? 1 : 0); }
+    bool sleepsWhenSilent() const { return sleepWhenSilent.get() == 1; }
+
+    /** Set the tail in seconds to keep processing after the inputs go silent.
+        A negative value uses the tail reported by the plugin.
+     */
+    void setSilenceTail (double seconds);
+    double getSilenceTail() const { return silenceTail; }
+
+    /** Returns the number of silent samples to process before sleeping, or -1
+        if the tail is infinite and this node should never sleep.
+     */
+    int getSilenceTailSamples() const { return silenceTailSamples.get(); }
+
     //==========================================================================
     virtual void getState (MemoryBlock&) = 0;
     virtual void setState (const void*, int sizeInBytes) = 0;
@@ -423,6 +462,10 @@ public:
     void setOversamplingFactor (int osFactor);
     int getOversamplingFactor();
 
+    /** Change the oversampling filters, see Oversampler::Quality */
+    void setOversamplingQuality (int quality);
+    int getOversamplingQuality() const;
+
     //==========================================================================
     void setDelayCompensation (double delayMs);
     double getDelayCompensation() const;
@@ -504,6 +547,9 @@ private:
     Atomic<int> bypassed { 0 };
     Atomic<int> mute { 0 };
     Atomic<int> muteInput { 0 };
+    Atomic<int> sleepWhenSilent { 0 };
+    Atomic<int> silenceTailSamples { 0 };
+    double silenceTail = -1.0;
 
     double sampleRate = 0.0;
     int blockSize = 0;
@@ -515,6 +561,7 @@ private:
 
     Atomic<float> gain, lastGain, inputGain, lastInputGain;
     OwnedArray<AtomicValue<float>> inRMS, outRMS;
+    Atomic<int> levelSubscribers { 0 };
 
     Atomic<int> keyRangeLow { 0 };
     Atomic<int> keyRangeHigh { 127 };
@@ -532,8 +579,20 @@ private:
         ~EnablementUpdater() {}
         void handleAsyncUpdate() override;
         Processor& graph;
+        Atomic<int> requested { 1 };
+        bool applied = true; // message thread only
     } enablement;
 
+    void applyEnablement();
+
+    struct StateNotifier : public AsyncUpdater {
+        StateNotifier (Processor& n) : node (n) {}
+        ~StateNotifier() { cancelPendingUpdate(); }
+        void handleAsyncUpdate() override;
+        Processor& node;
+        Atomic<int> bypass { 0 }, mute { 0 };
+    } stateNotifier;
+
     struct MidiProgramLoader : public AsyncUpdater {
         MidiProgramLoader (Processor& n) : node (n) {}
         ~MidiProgramLoader() { cancelPendingUpdate(); }
@@ -561,6 +620,7 @@ private:
     void prepare (double sampleRate, int blockSize, GraphNode*, bool willBeEnabled = false);
     void unprepare();
     void resetPorts();
+    void updateSilenceTail();
 
     std::unique_ptr<Oversampler<float>> oversampler;
     int osPow = 0;
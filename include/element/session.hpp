@@ -102,6 +102,9 @@ public:
 
     /** Writes an encoded file */
     bool writeToFile (const File&) const;
+
+    /** Reads a session or graph file, binary, XML or gzipped.
+        Returns an invalid tree if the file couldn't be read. */
     static ValueTree readFromFile (const File&);
 
     Value getActiveGraphIndexObject (bool syncUpdate = false) const
@@ -50,6 +50,9 @@ public:
     static const char* updateKeyKey;
     static const char* updateKeyUserKey;
     static const char* transportStartStopContinue;
+    static const char* parallelRenderingKey;
+    static const char* setlistModeKey;
+    static const char* standbyGraphsKey;
 
     bool getBool (std::string_view key, bool fallback = false) const noexcept;
 
@@ -162,6 +165,25 @@ public:
     void setTransportRespondToStartStopContinue (bool shouldRespond);
     bool transportRespondToStartStopContinue() const;
 
+    /** Returns true if graphs should render on multiple cores. */
+    bool useParallelRendering() const;
+
+    /** Change multi-core graph rendering. */
+    void setUseParallelRendering (bool shouldUseParallel);
+
+    /** Returns true if graphs which aren't playing should be kept on standby
+        instead of rendering, with only the graphs near the active one loaded. */
+    bool useSetlistMode() const;
+
+    /** Change setlist mode. */
+    void setUseSetlistMode (bool shouldUseSetlist);
+
+    /** Returns how many graphs besides the active one stay loaded in setlist mode. */
+    int getNumStandbyGraphs() const;
+
+    /** Change how many graphs stay loaded in setlist mode. */
+    void setNumStandbyGraphs (int numGraphs);
+
 private:
     juce::PropertiesFile* getProps() const;
 };
@@ -4,28 +4,68 @@
 #pragma once
 
 #include <cstdint>
+#include <mutex>
 
 #include <lvtk/symbols.hpp>
 
 namespace element {
 
+/** Maps URIs to URIDs for the host and its plugins.
+
+    Plugins may map from any thread, several at once when their state is
+    restored on the node loading pool, so every call is serialized here.
+ */
 class SymbolMap final {
 public:
-    SymbolMap() noexcept {}
+    SymbolMap() noexcept
+    {
+        _map.handle = this;
+        _map.map = &SymbolMap::mapCallback;
+        _unmap.handle = this;
+        _unmap.unmap = &SymbolMap::unmapCallback;
+        _mapFeature.URI = LV2_URID__map;
+        _mapFeature.data = &_map;
+        _unmapFeature.URI = LV2_URID__unmap;
+        _unmapFeature.data = &_unmap;
+    }
+
     ~SymbolMap() {}
 
-    const uint32_t map (const char* str) noexcept { return _sym.map (str); }
-    const char* unmap (uint32_t urid) noexcept { return _sym.unmap (urid); }
+    const uint32_t map (const char* str) noexcept
+    {
+        std::lock_guard<std::mutex> sl (_lock);
+        return _sym.map (str);
+    }
+
+    const char* unmap (uint32_t urid) noexcept
+    {
+        std::lock_guard<std::mutex> sl (_lock);
+        return _sym.unmap (urid);
+    }
 
-    inline auto mapPtr() const noexcept { return (LV2_URID_Map*) _sym.map_feature()->data; }
-    inline auto mapFeature() const noexcept { return _sym.map_feature(); }
-    inline auto unmapPtr() const noexcept { return (LV2_URID_Unmap*) _sym.unmap_feature()->data; }
-    inline auto unmapFeature() const noexcept { return _sym.unmap_feature(); }
+    inline auto mapPtr() const noexcept { return const_cast<LV2_URID_Map*> (&_map); }
+    inline auto mapFeature() const noexcept { return &_mapFeature; }
+    inline auto unmapPtr() const noexcept { return const_cast<LV2_URID_Unmap*> (&_unmap); }
+    inline auto unmapFeature() const noexcept { return &_unmapFeature; }
 
     inline operator LV2_URID_Map*() const noexcept { return mapPtr(); }
 
 private:
     lvtk::Symbols _sym;
+    std::mutex _lock;
+    LV2_URID_Map _map;
+    LV2_URID_Unmap _unmap;
+    LV2_Feature _mapFeature, _unmapFeature;
+
+    static LV2_URID mapCallback (LV2_URID_Map_Handle handle, const char* uri)
+    {
+        return static_cast<SymbolMap*> (handle)->map (uri);
+    }
+
+    static const char* unmapCallback (LV2_URID_Unmap_Handle handle, LV2_URID urid)
+    {
+        return static_cast<SymbolMap*> (handle)->unmap (urid);
+    }
 };
 
 } // namespace element
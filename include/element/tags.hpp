@@ -113,12 +113,15 @@ static const juce::Identifier node = "node";
 static const juce::Identifier nodes = "nodes";
 static const juce::Identifier notes = "notes";
 static const juce::Identifier oversamplingFactor = "oversamplingFactor";
+static const juce::Identifier oversamplingQuality = "oversamplingQuality";
 static const juce::Identifier persistent = "persistent";
 static const juce::Identifier placeholder = "placeholder";
 static const juce::Identifier port = "port";
 static const juce::Identifier ports = "ports";
 static const juce::Identifier preset = "preset";
 static const juce::Identifier program = "program";
+static const juce::Identifier silenceTail = "silenceTail";
+static const juce::Identifier sleepWhenSilent = "sleepWhenSilent";
 static const juce::Identifier sourceNode = "sourceNode";
 static const juce::Identifier sourcePort = "sourcePort";
 static const juce::Identifier sourceChannel = "sourceChannel";
@@ -70,6 +70,9 @@ public:
         return (t1 - t0);
     }
 
+    /** Return the filtered time of the last update */
+    inline double time() const noexcept { return t0; }
+
 private:
     double samplerate, periodSize;
     double e2, t0, t1;
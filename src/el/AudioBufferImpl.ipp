@@ -196,6 +196,235 @@ static int audio_fade (lua_State* L)
     return 0;
 }
 
+//==============================================================================
+// Bulk operations. Optional ranges are trailing `start, count` arguments and
+// are clipped to the buffers involved.
+
+static Buffer* audio_checkbuffer (lua_State* L, int index)
+{
+    return *(Buffer**) luaL_checkudata (L, index, EL_MT_AUDIO_BUFFER_IMPL);
+}
+
+static int audio_checkchannel (lua_State* L, int index, const Buffer* buf)
+{
+    const auto channel = luaL_checkinteger (L, index);
+    luaL_argcheck (L, channel >= 1 && channel <= buf->getNumChannels(), index, "channel out of range");
+    return static_cast<int> (channel - 1);
+}
+
+static void audio_range (lua_State* L, int index, int length, int& start, int& count)
+{
+    start = 0;
+    count = length;
+    if (lua_isinteger (L, index))
+    {
+        start = juce::jlimit (0, length, static_cast<int> (lua_tointeger (L, index) - 1));
+        count = lua_isinteger (L, index + 1)
+                    ? juce::jlimit (0, length - start, static_cast<int> (lua_tointeger (L, index + 1)))
+                    : length - start;
+    }
+}
+
+// clip a range count to the samples a source buffer has from start
+static int audio_clip (const Buffer* src, int start, int count)
+{
+    return juce::jmin (count, juce::jmax (0, src->getNumSamples() - start));
+}
+
+static int audio_copy (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    const int channel = audio_checkchannel (L, 2, buf);
+    auto* src = audio_checkbuffer (L, 3);
+    const int srcChannel = audio_checkchannel (L, 4, src);
+    int start, count;
+    audio_range (L, 5, buf->getNumSamples(), start, count);
+    count = audio_clip (src, start, count);
+    if (count > 0)
+        buf->copyFrom (channel, start, *src, srcChannel, start, count);
+    return 0;
+}
+
+static int audio_add (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    const int channel = audio_checkchannel (L, 2, buf);
+    auto* src = audio_checkbuffer (L, 3);
+    const int srcChannel = audio_checkchannel (L, 4, src);
+    int start, count;
+    audio_range (L, 6, buf->getNumSamples(), start, count);
+    count = audio_clip (src, start, count);
+    if (count > 0)
+        buf->addFrom (channel, start, *src, srcChannel, start, count,
+                      static_cast<SampleType> (luaL_optnumber (L, 5, 1.0)));
+    return 0;
+}
+
+static int audio_mix (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    const int channel = audio_checkchannel (L, 2, buf);
+    auto* src = audio_checkbuffer (L, 3);
+    const int srcChannel = audio_checkchannel (L, 4, src);
+    int start, count;
+    audio_range (L, 7, buf->getNumSamples(), start, count);
+    count = audio_clip (src, start, count);
+    if (count > 0)
+        buf->addFromWithRamp (channel,
+                              start,
+                              src->getReadPointer (srcChannel, start),
+                              count,
+                              static_cast<SampleType> (lua_tonumber (L, 5)),
+                              static_cast<SampleType> (lua_tonumber (L, 6)));
+    return 0;
+}
+
+static int audio_multiply (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    const int channel = audio_checkchannel (L, 2, buf);
+    auto* src = audio_checkbuffer (L, 3);
+    const int srcChannel = audio_checkchannel (L, 4, src);
+    int start, count;
+    audio_range (L, 5, buf->getNumSamples(), start, count);
+    count = audio_clip (src, start, count);
+    if (count > 0)
+        juce::FloatVectorOperations::multiply (
+            buf->getWritePointer (channel, start),
+            src->getReadPointer (srcChannel, start),
+            count);
+    return 0;
+}
+
+static lua_Number audio_field (lua_State* L, int table, const char* name)
+{
+    lua_getfield (L, table, name);
+    const auto value = lua_tonumber (L, -1);
+    lua_pop (L, 1);
+    return value;
+}
+
+static int audio_biquad (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    const int channel = audio_checkchannel (L, 2, buf);
+    luaL_checktype (L, 3, LUA_TTABLE);
+    const auto b0 = audio_field (L, 3, "b0"), b1 = audio_field (L, 3, "b1"),
+               b2 = audio_field (L, 3, "b2"), a1 = audio_field (L, 3, "a1"),
+               a2 = audio_field (L, 3, "a2");
+    auto z1 = audio_field (L, 3, "z1"), z2 = audio_field (L, 3, "z2");
+
+    int start, count;
+    audio_range (L, 4, buf->getNumSamples(), start, count);
+    if (count <= 0)
+        return 0;
+    auto* data = buf->getWritePointer (channel, start);
+
+    // transposed direct form II
+    for (int i = 0; i < count; ++i)
+    {
+        const lua_Number in = data[i];
+        const lua_Number out = b0 * in + z1;
+        z1 = b1 * in - a1 * out + z2;
+        z2 = b2 * in - a2 * out;
+        data[i] = static_cast<SampleType> (out);
+    }
+
+    JUCE_SNAP_TO_ZERO (z1);
+    JUCE_SNAP_TO_ZERO (z2);
+
+    lua_pushnumber (L, z1);
+    lua_setfield (L, 3, "z1");
+    lua_pushnumber (L, z2);
+    lua_setfield (L, 3, "z2");
+    return 0;
+}
+
+static int audio_onepole (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    const int channel = audio_checkchannel (L, 2, buf);
+    luaL_checktype (L, 3, LUA_TTABLE);
+    const auto a = audio_field (L, 3, "a");
+    auto z = audio_field (L, 3, "z");
+
+    int start, count;
+    audio_range (L, 4, buf->getNumSamples(), start, count);
+    if (count <= 0)
+        return 0;
+    auto* data = buf->getWritePointer (channel, start);
+
+    for (int i = 0; i < count; ++i)
+    {
+        z += a * (data[i] - z);
+        data[i] = static_cast<SampleType> (z);
+    }
+
+    JUCE_SNAP_TO_ZERO (z);
+
+    lua_pushnumber (L, z);
+    lua_setfield (L, 3, "z");
+    return 0;
+}
+
+static int audio_peak (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    const int channel = audio_checkchannel (L, 2, buf);
+    int start, count;
+    audio_range (L, 3, buf->getNumSamples(), start, count);
+    lua_pushnumber (L, buf->getMagnitude (channel, start, count));
+    return 1;
+}
+
+static int audio_peakall (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    int start, count;
+    audio_range (L, 2, buf->getNumSamples(), start, count);
+    lua_pushnumber (L, buf->getMagnitude (start, count));
+    return 1;
+}
+
+static int audio_rms (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    const int channel = audio_checkchannel (L, 2, buf);
+    int start, count;
+    audio_range (L, 3, buf->getNumSamples(), start, count);
+    lua_pushnumber (L, count > 0 ? buf->getRMSLevel (channel, start, count) : 0.0);
+    return 1;
+}
+
+static int audio_rmsall (lua_State* L)
+{
+    // the level of all channels together
+    auto* buf = toclassref (L, 1);
+    int start, count;
+    audio_range (L, 2, buf->getNumSamples(), start, count);
+    lua_Number sum = 0.0;
+    const int nchans = buf->getNumChannels();
+    if (count > 0 && nchans > 0)
+    {
+        for (int c = 0; c < nchans; ++c)
+        {
+            const auto level = static_cast<lua_Number> (buf->getRMSLevel (c, start, count));
+            sum += level * level;
+        }
+        sum = std::sqrt (sum / nchans);
+    }
+
+    lua_pushnumber (L, sum);
+    return 1;
+}
+
+static int audio_raw (lua_State* L)
+{
+    auto* buf = toclassref (L, 1);
+    lua_pushlightuserdata (L, buf->getWritePointer (audio_checkchannel (L, 2, buf)));
+    return 1;
+}
+
 static int audio_free (lua_State* L)
 {
     auto** buf = (Buffer**) lua_touserdata (L, 1);
@@ -358,6 +587,105 @@ static const luaL_Reg buffer_methods[] = {
     // @number gain2 End gain
     // @function AudioBuffer:fade
     { "fade", audio_fade },
+
+    /// Copy a channel from another buffer.
+    // Both buffers must have the same precision.
+    // @int channel Channel to copy to
+    // @tparam el.AudioBuffer source Buffer to copy from, may be this one
+    // @int sourcechannel Channel to copy from
+    // @int[opt] start Sample to start at
+    // @int[opt] count Number of samples to copy
+    // @function AudioBuffer:copy
+    { "copy", audio_copy },
+
+    /// Add a channel from another buffer.
+    // @int channel Channel to add to
+    // @tparam el.AudioBuffer source Buffer to add from, may be this one
+    // @int sourcechannel Channel to add from
+    // @number[opt=1] gain Gain applied to the source
+    // @int[opt] start Sample to start at
+    // @int[opt] count Number of samples to add
+    // @function AudioBuffer:add
+    { "add", audio_add },
+
+    /// Add a channel from another buffer while ramping its gain.
+    // @int channel Channel to add to
+    // @tparam el.AudioBuffer source Buffer to add from
+    // @int sourcechannel Channel to add from
+    // @number gain1 Starting gain
+    // @number gain2 End gain
+    // @int[opt] start Sample to start at
+    // @int[opt] count Number of samples to mix
+    // @function AudioBuffer:mix
+    { "mix", audio_mix },
+
+    /// Multiply a channel by a channel of another buffer.
+    // Useful for applying an envelope or window rendered into a buffer.
+    // @int channel Channel to multiply
+    // @tparam el.AudioBuffer source Buffer holding the multipliers
+    // @int sourcechannel Channel holding the multipliers
+    // @int[opt] start Sample to start at
+    // @int[opt] count Number of samples to process
+    // @function AudioBuffer:multiply
+    { "multiply", audio_multiply },
+
+    /// Run a biquad filter over a channel.
+    // The filter is a table of coefficients `b0, b1, b2, a1, a2` (normalized
+    // so a0 is 1) and state `z1, z2`. The state is updated in place, so keep
+    // one table per channel between blocks.
+    // @int channel Channel to filter
+    // @tab filter Coefficients and state
+    // @int[opt] start Sample to start at
+    // @int[opt] count Number of samples to process
+    // @function AudioBuffer:biquad
+    // @usage
+    // local lp = { b0 = 0.2, b1 = 0.4, b2 = 0.2, a1 = -0.3, a2 = 0.1, z1 = 0, z2 = 0 }
+    // buf:biquad (1, lp)
+    { "biquad", audio_biquad },
+
+    /// Run a one pole lowpass over a channel.
+    // The filter is a table with coefficient `a` from 0 to 1 and state `z`,
+    // which is updated in place.
+    // @int channel Channel to filter
+    // @tab filter Coefficient and state
+    // @int[opt] start Sample to start at
+    // @int[opt] count Number of samples to process
+    // @function AudioBuffer:onepole
+    { "onepole", audio_onepole },
+
+    /// Returns the highest absolute sample value in one channel.
+    // @int channel Channel to scan
+    // @int[opt] start Sample to start at
+    // @int[opt] count Number of samples to scan
+    // @function AudioBuffer:peak
+    { "peak", audio_peak },
+
+    /// Returns the highest absolute sample value in all channels.
+    // @int[opt] start Sample to start at
+    // @int[opt] count Number of samples to scan
+    // @function AudioBuffer:peakall
+    { "peakall", audio_peakall },
+
+    /// Returns the RMS level of one channel.
+    // @int channel Channel to measure
+    // @int[opt] start Sample to start at
+    // @int[opt] count Number of samples to measure
+    // @function AudioBuffer:rms
+    { "rms", audio_rms },
+
+    /// Returns the RMS level of all channels together.
+    // @int[opt] start Sample to start at
+    // @int[opt] count Number of samples to measure
+    // @function AudioBuffer:rmsall
+    { "rmsall", audio_rmsall },
+
+    /// Returns a pointer to a channel's samples as light userdata.
+    // The pointer is only valid while the buffer is, which for buffers given
+    // to `process` is the current block. With LuaJIT it can be cast with
+    // `ffi.cast ("float*", ptr)`, or "double*" when `isDouble` is true.
+    // @int channel Channel to get
+    // @function AudioBuffer:raw
+    { "raw", audio_raw },
     { NULL, NULL }
 };
 
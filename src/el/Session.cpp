@@ -42,7 +42,7 @@ int luaopen_el_Session (lua_State* L)
         // @treturn string XML string of the session data.
         "toXmlString", [] (Session& self) -> std::string {
             auto tree = self.data().createCopy();
-            Node::sanitizeRuntimeProperties (tree, true);
+            Node::sanitizeProperties (tree, true);
             return tree.toXmlString().toStdString();
         },
 
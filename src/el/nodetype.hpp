@@ -98,7 +98,7 @@ inline static sol::table new_nodetype (lua_State* L, const char* name, Args&&...
         // @treturn string
         "toXmlString", [] (Node* self) -> std::string {
             auto copy = self->data().createCopy();
-            element::Node::sanitizeRuntimeProperties (copy, true);
+            element::Node::sanitizeProperties (copy, true);
             return copy.toXmlString().toStdString();
         },
 
@@ -6,11 +6,15 @@
 #include <element/context.hpp>
 #include <element/settings.hpp>
 
+#include "engine/graphbuilder.hpp"
 #include "engine/internalformat.hpp"
+#include "engine/mappingengine.hpp"
 #include "engine/midiclock.hpp"
 #include "engine/midichannelmap.hpp"
 #include "engine/midiengine.hpp"
+#include "engine/midiinputqueue.hpp"
 #include "engine/miditranspose.hpp"
+#include "engine/parallelrender.hpp"
 #include "engine/rootgraph.hpp"
 #include "engine/midipanic.hpp"
 #include "engine/trace.hpp"
@@ -19,6 +23,57 @@
 
 namespace element {
 
+/** Renders a root graph in to its own scratch buffers. Having separate
+    buffers for each graph lets them all render at the same time. */
+class RootGraphRenderOp : public GraphOp
+{
+public:
+    explicit RootGraphRenderOp (RootGraph& g)
+        : graph (g) {}
+
+    void prepareBuffers (const int numChans, const int numSamples)
+    {
+        audio.setSize (numChans, numSamples);
+    }
+
+    void releaseBuffers()
+    {
+        audio.setSize (1, 1);
+        midi.clear();
+    }
+
+    void render (const int numSamples)
+    {
+        if (dormant)
+            return;
+
+        RenderContext rc (audio, cv, midi, atom, numSamples);
+        const ScopedLock sl (graph.getPropertyLock());
+        if (graph.isSuspended())
+        {
+            graph.renderBypassed (rc);
+        }
+        else
+        {
+            graph.render (rc);
+        }
+    }
+
+    void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>&, const OwnedArray<AtomBuffer>&, const int numSamples) override
+    {
+        render (numSamples);
+    }
+
+    RootGraph& graph;
+    AudioSampleBuffer audio { 1, 1 }, cv;
+    MidiBuffer midi;
+    AtomBuffer atom;
+    bool dormant = false; ///< skipped this cycle, see RootGraphRender::setStandbyEnabled
+
+private:
+    JUCE_DECLARE_NON_COPYABLE (RootGraphRenderOp)
+};
+
 struct RootGraphRender : public AsyncUpdater
 {
     std::function<void()> onActiveGraphChanged;
@@ -26,6 +81,7 @@ struct RootGraphRender : public AsyncUpdater
     RootGraphRender()
     {
         graphs.ensureStorageAllocated (32);
+        renderOps.ensureStorageAllocated (32);
     }
 
     void handleAsyncUpdate() override
@@ -57,16 +113,19 @@ struct RootGraphRender : public AsyncUpdater
     {
         numInputChans = numIns;
         numOutputChans = numOuts;
-        audioTemp.setSize (jmax (numIns, numOuts), numSamples);
-        audioOut.setSize (audioTemp.getNumChannels(), audioTemp.getNumSamples());
+        blockSize = numSamples;
+        for (auto* op : renderOps)
+            op->prepareBuffers (jmax (numIns, numOuts), numSamples);
+        audioOut.setSize (jmax (numIns, numOuts), numSamples);
     }
 
     void releaseBuffers()
     {
         numInputChans = numOutputChans = 0;
+        blockSize = 0;
         midiOut.clear();
-        midiTemp.clear();
-        audioTemp.setSize (1, 1);
+        for (auto* op : renderOps)
+            op->releaseBuffers();
         audioOut.setSize (1, 1);
     }
 
@@ -74,6 +133,28 @@ struct RootGraphRender : public AsyncUpdater
     {
     }
 
+    /** When enabled, single graphs which are neither playing nor fading out
+        aren't rendered. They stay prepared, so switching to one is as quick
+        as switching to a graph which was rendering.
+
+        AudioEngine's callback should be locked when you call this
+     */
+    void setStandbyEnabled (const bool shouldUseStandby)
+    {
+        standby = shouldUseStandby;
+    }
+
+    /** not realtime safe! AudioEngine's callback should be locked when you call this */
+    void setRenderConcurrently (const bool shouldRenderConcurrently)
+    {
+        if (renderConcurrently == shouldRenderConcurrently)
+            return;
+        renderConcurrently = shouldRenderConcurrently;
+        if (renderConcurrently)
+            renderPool->start (RenderPool::getDefaultNumWorkers());
+        updateSchedule();
+    }
+
     void renderGraphs (AudioSampleBuffer& buffer, MidiBuffer& midi)
     {
         if (program.wasRequested())
@@ -104,15 +185,24 @@ struct RootGraphRender : public AsyncUpdater
         if (shouldProcess)
         {
             audioOut.setSize (numChans, numSamples, false, false, true);
-            audioTemp.setSize (numChans, numSamples, false, false, true);
 
             // clear the mixing area
             for (int i = numChans; --i >= 0;)
                 audioOut.clear (i, 0, numSamples);
             midiOut.clear();
 
-            for (auto* const graph : graphs)
+            for (auto* const op : renderOps)
             {
+                auto* const graph = &op->graph;
+                op->dormant = standby && graph->isSingle() && graph != current
+                              && ! (graphChanged && graph == last);
+                if (op->dormant)
+                    continue;
+
+                auto& audioTemp = op->audio;
+                auto& midiTemp = op->midi;
+                audioTemp.setSize (numChans, numSamples, false, false, true);
+
                 // copy inputs, clear outs if more than input count
                 for (int i = 0; i < numInputChans; ++i)
                     audioTemp.copyFrom (i, 0, buffer, i, 0, numSamples);
@@ -146,19 +236,24 @@ struct RootGraphRender : public AsyncUpdater
                     // current single graph or parallel graphs get MIDI always
                     midiTemp.addEvents (midi, 0, numSamples, 0);
                 }
+            }
 
-                {
-                    RenderContext rc (audioTemp, cvTemp, midiTemp, atomTemp, numSamples);
-                    const ScopedLock sl (graph->getPropertyLock());
-                    if (graph->isSuspended())
-                    {
-                        graph->renderBypassed (rc);
-                    }
-                    else
-                    {
-                        graph->render (rc);
-                    }
-                }
+            // graphs don't share buffers, so they can all render at the same time
+            if (schedule == nullptr
+                || ! renderPool->perform (*schedule, audioOut, noMidi, noAtom, numSamples))
+            {
+                for (auto* const op : renderOps)
+                    op->render (numSamples);
+            }
+
+            for (auto* const op : renderOps)
+            {
+                if (op->dormant)
+                    continue;
+
+                auto* const graph = &op->graph;
+                const auto& audioTemp = op->audio;
+                const auto& midiTemp = op->midi;
 
                 // clang-format off
                 if (graphChanged && ((current->isSingle() && graph == last) || 
@@ -220,8 +315,14 @@ struct RootGraphRender : public AsyncUpdater
     /** not realtime safe! */
     bool addGraph (RootGraph* graph)
     {
+        auto* op = new RootGraphRenderOp (*graph);
+        if (blockSize > 0)
+            op->prepareBuffers (jmax (numInputChans, numOutputChans), blockSize);
+
         graphs.add (graph);
+        renderOps.add (op);
         graph->engineIndex = graphs.size() - 1;
+        updateSchedule();
 
         if (graph->engineIndex == 0)
         {
@@ -236,9 +337,11 @@ struct RootGraphRender : public AsyncUpdater
     void removeGraph (RootGraph* graph)
     {
         jassert (graphs.contains (graph));
+        renderOps.remove (graphs.indexOf (graph));
         graphs.removeFirstMatchingValue (graph);
         graph->engineIndex = -1;
         updateIndexes();
+        updateSchedule();
         if (currentGraph >= graphs.size())
             currentGraph = graphs.size() - 1;
         if (lastGraph >= graphs.size())
@@ -252,6 +355,11 @@ struct RootGraphRender : public AsyncUpdater
 
 private:
     Array<RootGraph*> graphs;
+    OwnedArray<RootGraphRenderOp> renderOps;
+    std::unique_ptr<RenderSchedule> schedule;
+    SharedResourcePointer<RenderPool> renderPool;
+    bool renderConcurrently = false;
+    bool standby = false;
     int currentGraph = -1;
     int lastGraph = -1;
 
@@ -270,9 +378,11 @@ private:
 
     int numInputChans = -1;
     int numOutputChans = -1;
-    AudioSampleBuffer audioOut, audioTemp, cvTemp;
-    MidiBuffer midiOut, midiTemp;
-    AtomBuffer atomTemp;
+    int blockSize = 0;
+    AudioSampleBuffer audioOut;
+    MidiBuffer midiOut;
+    OwnedArray<MidiBuffer> noMidi;
+    OwnedArray<AtomBuffer> noAtom;
 
     void updateIndexes()
     {
@@ -280,6 +390,23 @@ private:
             graphs.getUnchecked (i)->engineIndex = i;
     }
 
+    void updateSchedule()
+    {
+        schedule.reset();
+        if (! renderConcurrently || renderOps.size() < 2)
+            return;
+
+        Array<void*> ops;
+        Array<int> ends;
+        for (auto* op : renderOps)
+        {
+            ops.add (op);
+            ends.add (ops.size());
+        }
+
+        schedule = std::make_unique<RenderSchedule> (ops, ends);
+    }
+
     int findGraphForProgram (const ProgramRequest& r) const
     {
         if (isPositiveAndBelow (program.program, 128))
@@ -368,6 +495,8 @@ public:
             auto graphs = session->data().getChildWithName (tags::graphs);
             graphs.setProperty (tags::active, currentGraph.get(), nullptr);
         }
+
+        engine.activeGraphChanged (currentGraph.get());
     }
 
     void audioDeviceIOCallbackWithContext (const float* const* inputChannelData,
@@ -450,7 +579,9 @@ public:
     void processCurrentGraph (AudioBuffer<float>& buffer, MidiBuffer& midi)
     {
         const int numSamples = buffer.getNumSamples();
+        midiInput.render (midi, numSamples, MidiInputQueue::now());
         messageCollector.removeNextBlockOfMessages (midi, numSamples);
+        engine.context().mapping().applyPendingChanges();
 
         extraMidi.clear();
 
@@ -555,6 +686,7 @@ public:
 
         midiClock.reset (sampleRate, blockSize);
         messageCollector.reset (sampleRate);
+        midiInput.prepare (sampleRate);
         keyboardState.addListener (&messageCollector);
         channels.calloc ((size_t) jmax (numChansIn, numChansOut) + 2);
 
@@ -597,7 +729,10 @@ public:
     {
         if (! message.isActiveSense() && ! message.isMidiClock())
             midiIOMonitor->received();
-        messageCollector.addMessageToQueue (message);
+
+        // long sysex, or a full queue, goes the slow way
+        if (! midiInput.push (message))
+            messageCollector.addMessageToQueue (message);
         const bool clockWanted = processMidiClock.get() > 0 && sessionWantsExternalClock.get() > 0;
         const bool doStartStop = startStopCont.get() != 0;
 
@@ -627,6 +762,7 @@ public:
     void addGraph (RootGraph* graph)
     {
         jassert (graph);
+        graph->setParallelRendering (parallelRendering);
         if (isPrepared)
             prepareGraph (graph, sampleRate, blockSize);
         ScopedLock sl (lock);
@@ -649,6 +785,24 @@ public:
             graph->releaseResources();
     }
 
+    void setStandbyEnabled (bool shouldUseStandby)
+    {
+        ScopedLock sl (lock);
+        graphs.setStandbyEnabled (shouldUseStandby);
+    }
+
+    /** not realtime safe! */
+    void setParallelRendering (bool shouldRenderInParallel)
+    {
+        if (parallelRendering == shouldRenderInParallel)
+            return;
+        parallelRendering = shouldRenderInParallel;
+        for (auto* graph : graphs.getGraphs())
+            graph->setParallelRendering (parallelRendering);
+        ScopedLock sl (lock);
+        graphs.setRenderConcurrently (parallelRendering);
+    }
+
     void connectSessionValues()
     {
         if (session)
@@ -730,12 +884,14 @@ private:
     double sampleRate = 44100.0;
     int blockSize = 1024;
     bool isPrepared = false;
+    bool parallelRendering = false;
     Atomic<int> currentGraph;
 
     int numInputChans, numOutputChans;
     HeapBlock<float*> channels;
     AudioSampleBuffer tempBuffer;
     MidiBuffer tempMidi, extraMidi;
+    MidiInputQueue midiInput;
     MidiMessageCollector messageCollector;
     MidiKeyboardState keyboardState;
 
@@ -858,6 +1014,8 @@ void AudioEngine::applySettings (Settings& settings)
     }
 
     priv->startStopCont.set (settings.transportRespondToStartStopContinue() ? 1 : 0);
+    priv->setParallelRendering (settings.useParallelRendering());
+    priv->setStandbyEnabled (settings.useSetlistMode());
 }
 
 bool AudioEngine::removeGraph (RootGraph* graph)
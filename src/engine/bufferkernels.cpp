@@ -0,0 +1,428 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define EL_KERNELS_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define EL_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+// AVX2 is compiled per function and only used when the CPU has it.
+#if EL_KERNELS_X86 && (defined(__GNUC__) || defined(__clang__))
+#define EL_KERNELS_AVX2 1
+#define EL_TARGET_AVX2 __attribute__ ((target ("avx2")))
+#endif
+
+#include "engine/bufferkernels.hpp"
+
+namespace element {
+
+//==============================================================================
+void BufferKernels::Scalar::copy (float* dst, const float* src, int n) noexcept
+{
+    if (n > 0 && dst != src)
+        std::memcpy (dst, src, sizeof (float) * (size_t) n);
+}
+
+void BufferKernels::Scalar::fill (float* dst, float value, int n) noexcept
+{
+    for (int i = 0; i < n; ++i)
+        dst[i] = value;
+}
+
+void BufferKernels::Scalar::add (float* dst, const float* src, int n) noexcept
+{
+    for (int i = 0; i < n; ++i)
+        dst[i] += src[i];
+}
+
+void BufferKernels::Scalar::addWithGain (float* dst, const float* src, float gain, int n) noexcept
+{
+    for (int i = 0; i < n; ++i)
+        dst[i] += src[i] * gain;
+}
+
+void BufferKernels::Scalar::addWithRamp (float* dst, const float* src, float start, float end, int n) noexcept
+{
+    const float inc = n > 0 ? (end - start) / (float) n : 0.f;
+    for (int i = 0; i < n; ++i)
+        dst[i] += src[i] * (start + inc * (float) i);
+}
+
+void BufferKernels::Scalar::copyWithRamp (float* dst, const float* src, float start, float end, int n) noexcept
+{
+    const float inc = n > 0 ? (end - start) / (float) n : 0.f;
+    for (int i = 0; i < n; ++i)
+        dst[i] = src[i] * (start + inc * (float) i);
+}
+
+void BufferKernels::Scalar::applyRamp (float* dst, float start, float end, int n) noexcept
+{
+    const float inc = n > 0 ? (end - start) / (float) n : 0.f;
+    for (int i = 0; i < n; ++i)
+        dst[i] *= start + inc * (float) i;
+}
+
+void BufferKernels::Scalar::fillRamp (float* dst, float start, float end, int n) noexcept
+{
+    const float inc = n > 0 ? (end - start) / (float) n : 0.f;
+    for (int i = 0; i < n; ++i)
+        dst[i] = start + inc * (float) i;
+}
+
+float BufferKernels::Scalar::applyRampAndSumSquares (float* dst, float start, float end, int n) noexcept
+{
+    const float inc = n > 0 ? (end - start) / (float) n : 0.f;
+    float sum = 0.f;
+    for (int i = 0; i < n; ++i)
+    {
+        dst[i] *= start + inc * (float) i;
+        sum += dst[i] * dst[i];
+    }
+    return sum;
+}
+
+bool BufferKernels::Scalar::isSilent (const float* src, float threshold, int n) noexcept
+{
+    for (int i = 0; i < n; ++i)
+        if (std::abs (src[i]) > threshold)
+            return false;
+    return true;
+}
+
+namespace {
+//==============================================================================
+// Each instruction set provides a vector type V with W lanes and these
+// helpers. The loops below are then the same for all of them, with the
+// scalar versions handling the remainder.
+#if EL_KERNELS_X86
+struct SSE
+{
+    using V = __m128;
+    static constexpr int W = 4;
+    static V load (const float* p) noexcept { return _mm_loadu_ps (p); }
+    static void store (float* p, V v) noexcept { _mm_storeu_ps (p, v); }
+    static V set (float x) noexcept { return _mm_set1_ps (x); }
+    static V add (V a, V b) noexcept { return _mm_add_ps (a, b); }
+    static V mul (V a, V b) noexcept { return _mm_mul_ps (a, b); }
+    static bool anyAbove (V v, V threshold) noexcept
+    {
+        return _mm_movemask_ps (_mm_cmpgt_ps (_mm_andnot_ps (_mm_set1_ps (-0.f), v), threshold)) != 0;
+    }
+    static float sum (V v) noexcept
+    {
+        alignas (16) float r[W];
+        _mm_store_ps (r, v);
+        return (r[0] + r[1]) + (r[2] + r[3]);
+    }
+    static V ramp (float start, float inc) noexcept
+    {
+        return _mm_setr_ps (start, start + inc, start + inc * 2.f, start + inc * 3.f);
+    }
+};
+#endif
+
+#if EL_KERNELS_AVX2
+struct AVX2
+{
+    using V = __m256;
+    static constexpr int W = 8;
+    EL_TARGET_AVX2 static V load (const float* p) noexcept { return _mm256_loadu_ps (p); }
+    EL_TARGET_AVX2 static void store (float* p, V v) noexcept { _mm256_storeu_ps (p, v); }
+    EL_TARGET_AVX2 static V set (float x) noexcept { return _mm256_set1_ps (x); }
+    EL_TARGET_AVX2 static V add (V a, V b) noexcept { return _mm256_add_ps (a, b); }
+    EL_TARGET_AVX2 static V mul (V a, V b) noexcept { return _mm256_mul_ps (a, b); }
+    EL_TARGET_AVX2 static bool anyAbove (V v, V threshold) noexcept
+    {
+        return _mm256_movemask_ps (_mm256_cmp_ps (_mm256_andnot_ps (_mm256_set1_ps (-0.f), v), threshold, _CMP_GT_OQ)) != 0;
+    }
+    EL_TARGET_AVX2 static float sum (V v) noexcept
+    {
+        alignas (32) float r[W];
+        _mm256_store_ps (r, v);
+        return ((r[0] + r[1]) + (r[2] + r[3])) + ((r[4] + r[5]) + (r[6] + r[7]));
+    }
+    EL_TARGET_AVX2 static V ramp (float start, float inc) noexcept
+    {
+        return _mm256_setr_ps (start, start + inc, start + inc * 2.f, start + inc * 3.f, start + inc * 4.f, start + inc * 5.f, start + inc * 6.f, start + inc * 7.f);
+    }
+};
+#endif
+
+#if EL_KERNELS_NEON
+struct NEON
+{
+    using V = float32x4_t;
+    static constexpr int W = 4;
+    static V load (const float* p) noexcept { return vld1q_f32 (p); }
+    static void store (float* p, V v) noexcept { vst1q_f32 (p, v); }
+    static V set (float x) noexcept { return vdupq_n_f32 (x); }
+    static V add (V a, V b) noexcept { return vaddq_f32 (a, b); }
+    static V mul (V a, V b) noexcept { return vmulq_f32 (a, b); }
+    static bool anyAbove (V v, V threshold) noexcept
+    {
+        const uint32x4_t m = vcgtq_f32 (vabsq_f32 (v), threshold);
+        const uint32x2_t r = vorr_u32 (vget_low_u32 (m), vget_high_u32 (m));
+        return (vget_lane_u32 (r, 0) | vget_lane_u32 (r, 1)) != 0;
+    }
+    static float sum (V v) noexcept
+    {
+        float r[W];
+        vst1q_f32 (r, v);
+        return (r[0] + r[1]) + (r[2] + r[3]);
+    }
+    static V ramp (float start, float inc) noexcept
+    {
+        const float r[4] = { start, start + inc, start + inc * 2.f, start + inc * 3.f };
+        return vld1q_f32 (r);
+    }
+};
+#endif
+
+// The kernel bodies, written once. The AVX2 instantiations are wrapped in
+// functions with the avx2 target so the helpers can be inlined.
+#define EL_DEFINE_KERNELS(Set, ATTR)                                                           \
+    ATTR void fill##Set (float* dst, float value, int n) noexcept                              \
+    {                                                                                          \
+        using K = Set;                                                                         \
+        const auto v = K::set (value);                                                         \
+        int i = 0;                                                                             \
+        for (; i + K::W <= n; i += K::W)                                                       \
+            K::store (dst + i, v);                                                             \
+        for (; i < n; ++i)                                                                     \
+            dst[i] = value;                                                                    \
+    }                                                                                          \
+    ATTR void add##Set (float* dst, const float* src, int n) noexcept                          \
+    {                                                                                          \
+        using K = Set;                                                                         \
+        int i = 0;                                                                             \
+        for (; i + K::W <= n; i += K::W)                                                       \
+            K::store (dst + i, K::add (K::load (dst + i), K::load (src + i)));                 \
+        for (; i < n; ++i)                                                                     \
+            dst[i] += src[i];                                                                  \
+    }                                                                                          \
+    ATTR void addWithGain##Set (float* dst, const float* src, float gain, int n) noexcept      \
+    {                                                                                          \
+        using K = Set;                                                                         \
+        const auto g = K::set (gain);                                                          \
+        int i = 0;                                                                             \
+        for (; i + K::W <= n; i += K::W)                                                       \
+            K::store (dst + i, K::add (K::load (dst + i), K::mul (K::load (src + i), g)));     \
+        for (; i < n; ++i)                                                                     \
+            dst[i] += src[i] * gain;                                                           \
+    }                                                                                          \
+    ATTR void addWithRamp##Set (float* dst, const float* src, float a, float b, int n) noexcept \
+    {                                                                                          \
+        using K = Set;                                                                         \
+        const float inc = n > 0 ? (b - a) / (float) n : 0.f;                                   \
+        auto g = K::ramp (a, inc);                                                             \
+        const auto step = K::set (inc * (float) K::W);                                         \
+        int i = 0;                                                                             \
+        for (; i + K::W <= n; i += K::W, g = K::add (g, step))                                 \
+            K::store (dst + i, K::add (K::load (dst + i), K::mul (K::load (src + i), g)));     \
+        for (; i < n; ++i)                                                                     \
+            dst[i] += src[i] * (a + inc * (float) i);                                          \
+    }                                                                                          \
+    ATTR void copyWithRamp##Set (float* dst, const float* src, float a, float b, int n) noexcept \
+    {                                                                                          \
+        using K = Set;                                                                         \
+        const float inc = n > 0 ? (b - a) / (float) n : 0.f;                                   \
+        auto g = K::ramp (a, inc);                                                             \
+        const auto step = K::set (inc * (float) K::W);                                         \
+        int i = 0;                                                                             \
+        for (; i + K::W <= n; i += K::W, g = K::add (g, step))                                 \
+            K::store (dst + i, K::mul (K::load (src + i), g));                                 \
+        for (; i < n; ++i)                                                                     \
+            dst[i] = src[i] * (a + inc * (float) i);                                           \
+    }                                                                                          \
+    ATTR void applyRamp##Set (float* dst, float a, float b, int n) noexcept                    \
+    {                                                                                          \
+        using K = Set;                                                                         \
+        const float inc = n > 0 ? (b - a) / (float) n : 0.f;                                   \
+        auto g = K::ramp (a, inc);                                                             \
+        const auto step = K::set (inc * (float) K::W);                                         \
+        int i = 0;                                                                             \
+        for (; i + K::W <= n; i += K::W, g = K::add (g, step))                                 \
+            K::store (dst + i, K::mul (K::load (dst + i), g));                                 \
+        for (; i < n; ++i)                                                                     \
+            dst[i] *= a + inc * (float) i;                                                     \
+    }                                                                                          \
+    ATTR void fillRamp##Set (float* dst, float a, float b, int n) noexcept                     \
+    {                                                                                          \
+        using K = Set;                                                                         \
+        const float inc = n > 0 ? (b - a) / (float) n : 0.f;                                   \
+        auto g = K::ramp (a, inc);                                                             \
+        const auto step = K::set (inc * (float) K::W);                                         \
+        int i = 0;                                                                             \
+        for (; i + K::W <= n; i += K::W, g = K::add (g, step))                                 \
+            K::store (dst + i, g);                                                             \
+        for (; i < n; ++i)                                                                     \
+            dst[i] = a + inc * (float) i;                                                      \
+    }                                                                                          \
+    ATTR float applyRampAndSumSquares##Set (float* dst, float a, float b, int n) noexcept      \
+    {                                                                                          \
+        using K = Set;                                                                         \
+        const float inc = n > 0 ? (b - a) / (float) n : 0.f;                                   \
+        auto g = K::ramp (a, inc);                                                             \
+        const auto step = K::set (inc * (float) K::W);                                         \
+        auto squares = K::set (0.f);                                                           \
+        int i = 0;                                                                             \
+        for (; i + K::W <= n; i += K::W, g = K::add (g, step))                                 \
+        {                                                                                      \
+            const auto v = K::mul (K::load (dst + i), g);                                      \
+            K::store (dst + i, v);                                                             \
+            squares = K::add (squares, K::mul (v, v));                                         \
+        }                                                                                      \
+        float sum = K::sum (squares);                                                          \
+        for (; i < n; ++i)                                                                     \
+        {                                                                                      \
+            dst[i] *= a + inc * (float) i;                                                     \
+            sum += dst[i] * dst[i];                                                            \
+        }                                                                                      \
+        return sum;                                                                            \
+    }                                                                                          \
+    ATTR bool isSilent##Set (const float* src, float threshold, int n) noexcept                \
+    {                                                                                          \
+        using K = Set;                                                                         \
+        const auto t = K::set (threshold);                                                     \
+        int i = 0;                                                                             \
+        for (; i + K::W <= n; i += K::W)                                                       \
+            if (K::anyAbove (K::load (src + i), t))                                            \
+                return false;                                                                  \
+        for (; i < n; ++i)                                                                     \
+            if (std::abs (src[i]) > threshold)                                                 \
+                return false;                                                                  \
+        return true;                                                                           \
+    }
+
+#define EL_NO_ATTR
+#if EL_KERNELS_X86
+EL_DEFINE_KERNELS (SSE, EL_NO_ATTR)
+#endif
+#if EL_KERNELS_AVX2
+EL_DEFINE_KERNELS (AVX2, EL_TARGET_AVX2)
+#endif
+#if EL_KERNELS_NEON
+EL_DEFINE_KERNELS (NEON, EL_NO_ATTR)
+#endif
+#undef EL_DEFINE_KERNELS
+#undef EL_NO_ATTR
+
+//==============================================================================
+struct KernelTable
+{
+    const char* name;
+    void (*fill) (float*, float, int) noexcept;
+    void (*add) (float*, const float*, int) noexcept;
+    void (*addWithGain) (float*, const float*, float, int) noexcept;
+    void (*addWithRamp) (float*, const float*, float, float, int) noexcept;
+    void (*copyWithRamp) (float*, const float*, float, float, int) noexcept;
+    void (*applyRamp) (float*, float, float, int) noexcept;
+    void (*fillRamp) (float*, float, float, int) noexcept;
+    float (*applyRampAndSumSquares) (float*, float, float, int) noexcept;
+    bool (*isSilent) (const float*, float, int) noexcept;
+};
+
+#define EL_KERNEL_TABLE(name, Set) \
+    { name, fill##Set, add##Set, addWithGain##Set, addWithRamp##Set, copyWithRamp##Set, applyRamp##Set, fillRamp##Set, applyRampAndSumSquares##Set, isSilent##Set }
+
+static KernelTable createTable() noexcept
+{
+#if EL_KERNELS_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports ("avx2"))
+        return EL_KERNEL_TABLE ("avx2", AVX2);
+#endif
+#if EL_KERNELS_X86
+    return EL_KERNEL_TABLE ("sse", SSE);
+#elif EL_KERNELS_NEON
+    return EL_KERNEL_TABLE ("neon", NEON);
+#else
+    using S = BufferKernels::Scalar;
+    return { "scalar", S::fill, S::add, S::addWithGain, S::addWithRamp, S::copyWithRamp, S::applyRamp, S::fillRamp, S::applyRampAndSumSquares, S::isSilent };
+#endif
+}
+
+#undef EL_KERNEL_TABLE
+
+static const KernelTable& table() noexcept
+{
+    static const KernelTable t = createTable();
+    return t;
+}
+} // namespace
+
+//==============================================================================
+void BufferKernels::copy (float* dst, const float* src, int n) noexcept
+{
+    // memcpy is already as fast as it gets for plain copies
+    Scalar::copy (dst, src, n);
+}
+
+void BufferKernels::fill (float* dst, float value, int n) noexcept { table().fill (dst, value, n); }
+void BufferKernels::add (float* dst, const float* src, int n) noexcept { table().add (dst, src, n); }
+
+void BufferKernels::addWithGain (float* dst, const float* src, float gain, int n) noexcept
+{
+    if (gain == 1.f)
+        table().add (dst, src, n);
+    else if (gain != 0.f)
+        table().addWithGain (dst, src, gain, n);
+}
+
+void BufferKernels::addWithRamp (float* dst, const float* src, float startGain, float endGain, int n) noexcept
+{
+    if (startGain == endGain)
+        addWithGain (dst, src, startGain, n);
+    else
+        table().addWithRamp (dst, src, startGain, endGain, n);
+}
+
+void BufferKernels::copyWithRamp (float* dst, const float* src, float startGain, float endGain, int n) noexcept
+{
+    if (startGain == endGain && startGain == 1.f)
+        copy (dst, src, n);
+    else
+        table().copyWithRamp (dst, src, startGain, endGain, n);
+}
+
+void BufferKernels::applyRamp (float* dst, float startGain, float endGain, int n) noexcept
+{
+    if (startGain == endGain && startGain == 0.f)
+        table().fill (dst, 0.f, n);
+    else if (startGain != endGain || startGain != 1.f)
+        table().applyRamp (dst, startGain, endGain, n);
+}
+
+void BufferKernels::fillRamp (float* dst, float startValue, float endValue, int n) noexcept
+{
+    if (startValue == endValue)
+        table().fill (dst, startValue, n);
+    else
+        table().fillRamp (dst, startValue, endValue, n);
+}
+
+float BufferKernels::applyRampAndSumSquares (float* dst, float startGain, float endGain, int n) noexcept
+{
+    if (startGain == endGain && startGain == 0.f)
+    {
+        table().fill (dst, 0.f, n);
+        return 0.f;
+    }
+
+    return table().applyRampAndSumSquares (dst, startGain, endGain, n);
+}
+
+bool BufferKernels::isSilent (const float* src, float threshold, int n) noexcept
+{
+    return table().isSilent (src, threshold, n);
+}
+
+const char* BufferKernels::getInstructionSet() noexcept { return table().name; }
+
+} // namespace element
@@ -0,0 +1,62 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+namespace element {
+
+/** Small vectorized loops used when routing and mixing graph buffers.
+
+    Each kernel has SSE, AVX2 and NEON versions. The best one for the running
+    CPU is picked once, the first time any kernel is used. Loads and stores
+    are unaligned, which costs nothing extra on aligned data with any CPU from
+    the last decade and keeps callers free of alignment rules.
+
+    Ramps match AudioBuffer::applyGainRamp: the gain for sample i is
+    start + i * (end - start) / numSamples.
+ */
+struct BufferKernels final
+{
+    /** dst = src */
+    static void copy (float* dst, const float* src, int numSamples) noexcept;
+    /** dst = value */
+    static void fill (float* dst, float value, int numSamples) noexcept;
+    /** dst += src */
+    static void add (float* dst, const float* src, int numSamples) noexcept;
+    /** dst += src * gain */
+    static void addWithGain (float* dst, const float* src, float gain, int numSamples) noexcept;
+    /** dst += src * ramp */
+    static void addWithRamp (float* dst, const float* src, float startGain, float endGain, int numSamples) noexcept;
+    /** dst = src * ramp */
+    static void copyWithRamp (float* dst, const float* src, float startGain, float endGain, int numSamples) noexcept;
+    /** dst *= ramp */
+    static void applyRamp (float* dst, float startGain, float endGain, int numSamples) noexcept;
+    /** dst = ramp */
+    static void fillRamp (float* dst, float startValue, float endValue, int numSamples) noexcept;
+    /** dst *= ramp, returning the sum of the squares of the result. Use this
+        to apply a gain and measure the RMS level in one pass. */
+    static float applyRampAndSumSquares (float* dst, float startGain, float endGain, int numSamples) noexcept;
+    /** Returns true if no sample is louder than threshold. Stops at the first
+        one that is, so this is cheap for anything but silence. */
+    static bool isSilent (const float* src, float threshold, int numSamples) noexcept;
+
+    /** Returns the name of the instruction set in use, e.g. "avx2". */
+    static const char* getInstructionSet() noexcept;
+
+    /** Plain loops, used as the fallback and for comparing in tests. */
+    struct Scalar final
+    {
+        static void copy (float* dst, const float* src, int numSamples) noexcept;
+        static void fill (float* dst, float value, int numSamples) noexcept;
+        static void add (float* dst, const float* src, int numSamples) noexcept;
+        static void addWithGain (float* dst, const float* src, float gain, int numSamples) noexcept;
+        static void addWithRamp (float* dst, const float* src, float startGain, float endGain, int numSamples) noexcept;
+        static void copyWithRamp (float* dst, const float* src, float startGain, float endGain, int numSamples) noexcept;
+        static void applyRamp (float* dst, float startGain, float endGain, int numSamples) noexcept;
+        static void fillRamp (float* dst, float startValue, float endValue, int numSamples) noexcept;
+        static float applyRampAndSumSquares (float* dst, float startGain, float endGain, int numSamples) noexcept;
+        static bool isSilent (const float* src, float threshold, int numSamples) noexcept;
+    };
+};
+
+} // namespace element
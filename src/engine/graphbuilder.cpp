@@ -1,10 +1,13 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <bitset>
+
 #include <element/atombuffer.hpp>
 #include <element/symbolmap.hpp>
 #include <element/processor.hpp>
 
+#include "engine/bufferkernels.hpp"
 #include "engine/miditranspose.hpp"
 #include "engine/graphnode.hpp"
 #include "engine/graphbuilder.hpp"
@@ -20,6 +23,26 @@ using SharedMidi = OwnedArray<MidiBuffer>;
 using SharedAtom = OwnedArray<AtomBuffer>;
 using SharedAudio = AudioSampleBuffer;
 
+/** Applies a gain ramp to every channel. The RMS levels of the first numMetered
+    channels are measured in the same pass and handed to setLevel. */
+template <typename SetLevel>
+static void applyGainRamp (AudioSampleBuffer& audio, int numSamples, float startGain, float endGain, int numMetered, SetLevel&& setLevel) noexcept
+{
+    for (int ch = 0; ch < audio.getNumChannels(); ++ch)
+    {
+        auto* const data = audio.getWritePointer (ch);
+        if (ch < numMetered)
+        {
+            const float squares = BufferKernels::applyRampAndSumSquares (data, startGain, endGain, numSamples);
+            setLevel (ch, std::sqrt (squares / (float) jmax (1, numSamples)));
+        }
+        else
+        {
+            BufferKernels::applyRamp (data, startGain, endGain, numSamples);
+        }
+    }
+}
+
 class ApplyParamToCVOp : public GraphOp
 {
 public:
@@ -32,9 +55,26 @@ public:
     void perform (AudioSampleBuffer& buffer, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int nframes) override
     {
         value.setTargetValue (param->getValue());
-        auto ptr = buffer.getWritePointer (cvIndex);
-        for (int f = 0; f < nframes; ++f)
-            ptr[f] = value.getNextValue();
+        const float start = value.getCurrentValue();
+        const float end = value.skip (nframes);
+        const float step = nframes > 0 ? (end - start) / (float) nframes : 0.f;
+        BufferKernels::fillRamp (buffer.getWritePointer (cvIndex), start + step, end + step, nframes);
+    }
+
+    void getBufferAccess (BufferAccess& access) const override
+    {
+        access.write (PortType::CV, cvIndex);
+    }
+
+    size_t getReuseKey() const noexcept override
+    {
+        return std::hash<const void*>() (param.get()) + (size_t) cvIndex + 1;
+    }
+
+    bool isEquivalentTo (const GraphOp& other) const noexcept override
+    {
+        auto op = dynamic_cast<const ApplyParamToCVOp*> (&other);
+        return op != nullptr && op->param == param && op->cvIndex == cvIndex;
     }
 
 private:
@@ -99,6 +139,20 @@ public:
         dst->add (*atom.getUnchecked (srcBufferNum));
     }
 
+    void getBufferAccess (BufferAccess& access) const override
+    {
+        access.read (PortType::Atom, srcBufferNum);
+        access.write (PortType::Atom, dstBufferNum);
+    }
+
+    bool compile (RenderInstruction& ins) const noexcept override
+    {
+        ins.code = RenderInstruction::copyAtom;
+        ins.src = srcBufferNum;
+        ins.dst = dstBufferNum;
+        return true;
+    }
+
 private:
     const int srcBufferNum, dstBufferNum;
 
@@ -120,6 +174,20 @@ public:
             ->add (*atom.getUnchecked (srcBufferNum)); // TODO: -> , 0, numSamples, 0);
     }
 
+    void getBufferAccess (BufferAccess& access) const override
+    {
+        access.read (PortType::Atom, srcBufferNum);
+        access.write (PortType::Atom, dstBufferNum);
+    }
+
+    bool compile (RenderInstruction& ins) const noexcept override
+    {
+        ins.code = RenderInstruction::addAtom;
+        ins.src = srcBufferNum;
+        ins.dst = dstBufferNum;
+        return true;
+    }
+
 private:
     const int srcBufferNum, dstBufferNum;
 
@@ -145,6 +213,19 @@ public:
     {
         atom.getUnchecked (bufferIdx)->clear (0, numSamples);
     }
+
+    void getBufferAccess (BufferAccess& access) const override
+    {
+        access.write (PortType::Atom, bufferIdx);
+    }
+
+    bool compile (RenderInstruction& ins) const noexcept override
+    {
+        ins.code = RenderInstruction::clearAtom;
+        ins.src = bufferIdx;
+        ins.dst = bufferIdx;
+        return true;
+    }
 };
 
 class MidiToAtomOp : public GraphOp
@@ -165,6 +246,12 @@ public:
         atom.getUnchecked (_atomIdx)->add (*midi.getUnchecked (_midiIdx));
     }
 
+    void getBufferAccess (BufferAccess& access) const override
+    {
+        access.read (PortType::Midi, _midiIdx);
+        access.write (PortType::Atom, _atomIdx);
+    }
+
 private:
     const int _midiIdx, _atomIdx;
 };
@@ -201,6 +288,12 @@ public:
         }
     }
 
+    void getBufferAccess (BufferAccess& access) const override
+    {
+        access.read (PortType::Atom, _atomIdx);
+        access.write (PortType::Midi, _midiIdx);
+    }
+
 private:
     const int _atomIdx, _midiIdx;
     const uint32_t midi_MidiEvent;
@@ -220,6 +313,19 @@ public:
         sharedBufferChans.clear (channelNum, 0, numSamples);
     }
 
+    void getBufferAccess (BufferAccess& access) const override
+    {
+        access.write (PortType::Audio, channelNum);
+    }
+
+    bool compile (RenderInstruction& ins) const noexcept override
+    {
+        ins.code = RenderInstruction::clearAudio;
+        ins.src = channelNum;
+        ins.dst = channelNum;
+        return true;
+    }
+
 private:
     const int channelNum;
 
@@ -237,7 +343,23 @@ public:
 
     void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int numSamples)
     {
-        sharedBufferChans.copyFrom (dstChannelNum, 0, sharedBufferChans, srcChannelNum, 0, numSamples);
+        BufferKernels::copy (sharedBufferChans.getWritePointer (dstChannelNum),
+                             sharedBufferChans.getReadPointer (srcChannelNum),
+                             numSamples);
+    }
+
+    void getBufferAccess (BufferAccess& access) const override
+    {
+        access.read (PortType::Audio, srcChannelNum);
+        access.write (PortType::Audio, dstChannelNum);
+    }
+
+    bool compile (RenderInstruction& ins) const noexcept override
+    {
+        ins.code = RenderInstruction::copyAudio;
+        ins.src = srcChannelNum;
+        ins.dst = dstChannelNum;
+        return true;
     }
 
 private:
@@ -257,7 +379,23 @@ public:
 
     void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int numSamples)
     {
-        sharedBufferChans.addFrom (dstChannelNum, 0, sharedBufferChans, srcChannelNum, 0, numSamples);
+        BufferKernels::add (sharedBufferChans.getWritePointer (dstChannelNum),
+                            sharedBufferChans.getReadPointer (srcChannelNum),
+                            numSamples);
+    }
+
+    void getBufferAccess (BufferAccess& access) const override
+    {
+        access.read (PortType::Audio, srcChannelNum);
+        access.write (PortType::Audio, dstChannelNum);
+    }
+
+    bool compile (RenderInstruction& ins) const noexcept override
+    {
+        ins.code = RenderInstruction::addAudio;
+        ins.src = srcChannelNum;
+        ins.dst = dstChannelNum;
+        return true;
     }
 
 private:
@@ -279,6 +417,19 @@ public:
         sharedMidiBuffers.getUnchecked (bufferNum)->clear();
     }
 
+    void getBufferAccess (BufferAccess& access) const override
+    {
+        access.write (PortType::Midi, bufferNum);
+    }
+
+    bool compile (RenderInstruction& ins) const noexcept override
+    {
+        ins.code = RenderInstruction::clearMidi;
+        ins.src = bufferNum;
+        ins.dst = bufferNum;
+        return true;
+    }
+
 private:
     const int bufferNum;
 
@@ -300,6 +451,20 @@ public:
         *sharedMidiBuffers.getUnchecked (dstBufferNum) = *sharedMidiBuffers.getUnchecked (srcBufferNum);
     }
 
+    void getBufferAccess (BufferAccess& access) const override
+    {
+        access.read (PortType::Midi, srcBufferNum);
+        access.write (PortType::Midi, dstBufferNum);
+    }
+
+    bool compile (RenderInstruction& ins) const noexcept override
+    {
+        ins.code = RenderInstruction::copyMidi;
+        ins.src = srcBufferNum;
+        ins.dst = dstBufferNum;
+        return true;
+    }
+
 private:
     const int srcBufferNum, dstBufferNum;
 
@@ -321,6 +486,20 @@ public:
             ->addEvents (*sharedMidiBuffers.getUnchecked (srcBufferNum), 0, numSamples, 0);
     }
 
+    void getBufferAccess (BufferAccess& access) const override
+    {
+        access.read (PortType::Midi, srcBufferNum);
+        access.write (PortType::Midi, dstBufferNum);
+    }
+
+    bool compile (RenderInstruction& ins) const noexcept override
+    {
+        ins.code = RenderInstruction::addMidi;
+        ins.src = srcBufferNum;
+        ins.dst = dstBufferNum;
+        return true;
+    }
+
 private:
     const int srcBufferNum, dstBufferNum;
 
@@ -332,37 +511,154 @@ class DelayChannelOp : public GraphOp
 public:
     DelayChannelOp (const int channel_, const int numSamplesDelay_)
         : channel (channel_),
-          bufferSize (numSamplesDelay_ + 1),
-          readIndex (0),
-          writeIndex (numSamplesDelay_)
+          bufferSize (jmax (0, numSamplesDelay_))
     {
-        buffer.calloc ((size_t) bufferSize);
+        buffer.calloc ((size_t) jmax (1, bufferSize));
+        scratch.calloc (maxChunkSize);
+    }
+
+    std::string traceStep() const noexcept override
+    {
+        String str;
+        str << "DelayChannelOp: channel " << channel << " by " << bufferSize << " samples";
+        return str.toStdString();
     }
 
     void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray<MidiBuffer>&, const SharedAtom&, const int numSamples)
     {
+        if (bufferSize <= 0)
+            return;
+
         float* data = sharedBufferChans.getWritePointer (channel, 0);
 
-        for (int i = numSamples; --i >= 0;)
+        // Swap chunks of the channel with the oldest samples in the ring.
+        // A chunk never exceeds the delay length so reads come before writes.
+        for (int done = 0; done < numSamples;)
         {
-            buffer[writeIndex] = *data;
-            *data++ = buffer[readIndex];
-
-            if (++readIndex >= bufferSize)
-                readIndex = 0;
-            if (++writeIndex >= bufferSize)
-                writeIndex = 0;
+            const int chunk = jmin (numSamples - done, bufferSize, (int) maxChunkSize);
+            const int first = jmin (chunk, bufferSize - position);
+            float* const block = data + done;
+
+            BufferKernels::copy (scratch, block, chunk);
+            BufferKernels::copy (block, buffer + position, first);
+            BufferKernels::copy (block + first, buffer, chunk - first);
+            BufferKernels::copy (buffer + position, scratch, first);
+            BufferKernels::copy (buffer, scratch + first, chunk - first);
+
+            position = (position + chunk) % bufferSize;
+            done += chunk;
         }
     }
 
+    void getBufferAccess (BufferAccess& access) const override
+    {
+        access.write (PortType::Audio, channel);
+    }
+
+    size_t getReuseKey() const noexcept override
+    {
+        return ((size_t) channel * 131071u) + (size_t) bufferSize + 1;
+    }
+
+    bool isEquivalentTo (const GraphOp& other) const noexcept override
+    {
+        auto op = dynamic_cast<const DelayChannelOp*> (&other);
+        return op != nullptr && op->channel == channel && op->bufferSize == bufferSize;
+    }
+
 private:
-    HeapBlock<float> buffer;
+    static constexpr size_t maxChunkSize = 256;
+    HeapBlock<float> buffer, scratch;
     const int channel, bufferSize;
-    int readIndex, writeIndex;
+    int position = 0;
 
     JUCE_DECLARE_NON_COPYABLE (DelayChannelOp)
 };
 
+/** Decides when a node which sleeps on silence can skip a block. Notes still
+    held, or a held sustain pedal, keep the node awake so instruments don't
+    get cut off in the middle of a long note.
+ */
+class SilenceDetector final
+{
+public:
+    /** Input samples quieter than this count as silence, about -120 dBFS. */
+    static constexpr float threshold = 1.0e-6f;
+
+    void reset() noexcept
+    {
+        silentSamples = 0;
+        notes.reset();
+        sustain = 0;
+    }
+
+    /** Returns true if the block can be skipped. Call once per block with the
+        node's inputs. A negative tail means the node never sleeps.
+     */
+    bool shouldSleep (const AudioSampleBuffer& audio, int numAudioIns, const MidiPipe& midi, int numSamples, int tailSamples) noexcept
+    {
+        bool silent = true;
+        for (int i = 0; i < midi.getNumBuffers(); ++i)
+        {
+            for (const auto m : *midi.getReadBuffer (i))
+            {
+                silent = false;
+                track (m.data, m.numBytes);
+            }
+        }
+
+        for (int ch = 0; silent && ch < numAudioIns; ++ch)
+            silent = BufferKernels::isSilent (audio.getReadPointer (ch), threshold, numSamples);
+
+        if (! silent || tailSamples < 0 || notes.any() || sustain != 0)
+        {
+            silentSamples = 0;
+            return false;
+        }
+
+        if (silentSamples >= tailSamples)
+            return true;
+
+        silentSamples += numSamples;
+        return false;
+    }
+
+private:
+    std::bitset<16 * 128> notes;
+    uint32 sustain = 0;
+    int silentSamples = 0;
+
+    void track (const uint8* data, int size) noexcept
+    {
+        if (size < 3)
+            return;
+
+        const int status = data[0] & 0xf0;
+        const int chan = data[0] & 0x0f;
+
+        if (status == 0x90 && data[2] > 0)
+        {
+            notes.set ((size_t) (chan * 128 + (data[1] & 0x7f)));
+        }
+        else if (status == 0x80 || status == 0x90)
+        {
+            notes.reset ((size_t) (chan * 128 + (data[1] & 0x7f)));
+        }
+        else if (status == 0xb0 && data[1] == 64)
+        {
+            if (data[2] >= 64)
+                sustain |= (1u << chan);
+            else
+                sustain &= ~(1u << chan);
+        }
+        else if (status == 0xb0 && (data[1] == 120 || data[1] == 123))
+        {
+            for (int note = 0; note < 128; ++note)
+                notes.reset ((size_t) (chan * 128 + note));
+        }
+    }
+};
+
 class ProcessBufferOp : public GraphOp
 {
 public:
@@ -381,6 +677,8 @@ public:
           totalCV (std::max (1, totalCV_)),
           numAudioIns (node_->getNumPorts (PortType::Audio, true)),
           numAudioOuts (node_->getNumPorts (PortType::Audio, false)),
+          numCVOuts (node_->getNumPorts (PortType::CV, false)),
+          numAtomOuts (node_->getNumPorts (PortType::Atom, false)),
           midiBufferToUse (midiBufferToUse_)
     {
         channels.calloc ((size_t) totalChans);
@@ -433,35 +731,28 @@ public:
         const bool muted = node->isMuted();
         const bool muteInput = node->isMutingInputs();
 
+        const bool metering = node->isMeteringLevels();
+        float startGain = node->getInputGain(), endGain = startGain;
+
         if (muted && muteInput)
         {
-            if (lastMute != muted)
-            {
-                // just became muted
-                context.audio.applyGainRamp (0, numSamples, node->getLastInputGain(), 0.0);
-            }
-            else
-            {
-                // normal mute processing
-                context.audio.applyGain (0, numSamples, 0.0);
-            }
+            // just became muted, or normal mute processing
+            startGain = lastMute != muted ? node->getLastInputGain() : 0.f;
+            endGain = 0.f;
         }
         else if (! muted && muteInput && muted != lastMute)
         {
             // just became unmuted
-            context.audio.applyGainRamp (0, numSamples, 0.0, node->getInputGain());
+            startGain = 0.f;
         }
         else if (node->getInputGain() != node->getLastInputGain())
         {
-            context.audio.applyGainRamp (0, numSamples, node->getLastInputGain(), node->getInputGain());
-        }
-        else
-        {
-            context.audio.applyGain (0, numSamples, node->getInputGain());
+            startGain = node->getLastInputGain();
         }
 
-        for (int i = numAudioIns; --i >= 0;)
-            node->setInputRMS (i, context.audio.getRMSLevel (i, 0, numSamples));
+        applyGainRamp (context.audio, numSamples, startGain, endGain, metering ? numAudioIns : 0, [this] (int ch, float rms) {
+            node->setInputRMS (ch, rms);
+        });
 
         // Begin MIDI filters
         {
@@ -515,6 +806,31 @@ public:
         tempMidi.clear();
         // End MIDI filters
 
+        // io nodes have no inputs of their own and must never sleep
+        if (! node->sleepsWhenSilent() || node->isAudioIONode() || node->isMidiIONode())
+        {
+            silence.reset();
+        }
+        else if (silence.shouldSleep (context.audio, numAudioIns, context.midi, numSamples, node->getSilenceTailSamples()))
+        {
+            for (int ch = 0; ch < numAudioOuts; ++ch)
+                context.audio.clear (ch, 0, numSamples);
+            // buffer zero is the shared empty buffer and is never written
+            for (int ch = 0; ch < jmin (numCVOuts, totalCV); ++ch)
+                if (cvChannelsToUse.getUnchecked (ch) != 0)
+                    context.cv.clear (ch, 0, numSamples);
+            for (int i = 0; i < jmin (numAtomOuts, atomChannelsToUse.size()); ++i)
+                if (atomChannelsToUse.getUnchecked (i) != 0)
+                    context.atom.writeBuffer (i)->clear();
+            if (metering)
+                for (int ch = 0; ch < numAudioOuts; ++ch)
+                    node->setOutputRMS (ch, 0.f);
+
+            node->updateGain();
+            lastMute = muted;
+            return;
+        }
+
         auto pluginProcessBlock = [this] (RenderContext& context, bool isSuspended) {
             if (node->wantsContext())
             {
@@ -557,21 +873,7 @@ public:
             for (int ch = 0; ch < totalChans; ++ch)
                 osData[ch] = osBlock.getChannelPointer (ch);
             context.audio.setDataToReferTo (osData, totalChans, static_cast<int> (osBlock.getNumSamples()));
-
-            tempMidi.clear();
-            for (int i = 0; i < context.midi.getNumBuffers(); ++i)
-            {
-                auto& mb = *context.midi.getWriteBuffer (i);
-                for (const MidiMessageMetadata msg : mb)
-                {
-                    tempMidi.addEvent (
-                        msg.data,
-                        msg.numBytes,
-                        msg.samplePosition * osFactor);
-                }
-                mb.swapWith (tempMidi);
-                tempMidi.clear();
-            }
+            context.midi.scaleTimestamps (osFactor, 1);
 
             pluginProcessBlock (context, node->isSuspended());
 
@@ -579,59 +881,83 @@ public:
             for (int ch = 0; ch < totalChans; ++ch)
                 osData[ch] = block.getChannelPointer (ch);
             context.audio.setDataToReferTo (osData, totalChans, numSamples);
-
-            tempMidi.clear();
-            for (int i = 0; i < context.midi.getNumBuffers(); ++i)
-            {
-                auto& mb = *context.midi.getWriteBuffer (i);
-                for (const MidiMessageMetadata msg : mb)
-                {
-                    tempMidi.addEvent (
-                        msg.data,
-                        msg.numBytes,
-                        msg.samplePosition / osFactor);
-                }
-                mb.swapWith (tempMidi);
-                tempMidi.clear();
-            }
+            context.midi.scaleTimestamps (1, osFactor);
         }
         else
         {
             pluginProcessBlock (context, node->isSuspended());
         }
 
+        startGain = endGain = node->getGain();
+
         if (muted && ! muteInput)
         {
-            if (lastMute != muted)
-            {
-                // just became muted
-                context.audio.applyGainRamp (0, numSamples, node->getLastGain(), 0.0);
-            }
-            else
-            {
-                // normal mute processing
-                context.audio.applyGain (0, numSamples, 0.0);
-            }
+            // just became muted, or normal mute processing
+            startGain = lastMute != muted ? node->getLastGain() : 0.f;
+            endGain = 0.f;
         }
         else if (! muted && ! muteInput && muted != lastMute)
         {
             // just became unmuted
-            context.audio.applyGainRamp (0, numSamples, 0.0, node->getGain());
+            startGain = 0.f;
         }
         else if (node->getGain() != node->getLastGain())
         {
-            context.audio.applyGainRamp (0, numSamples, node->getLastGain(), node->getGain());
-        }
-        else
-        {
-            context.audio.applyGain (0, numSamples, node->getGain());
+            startGain = node->getLastGain();
         }
 
+        applyGainRamp (context.audio, numSamples, startGain, endGain, metering ? numAudioOuts : 0, [this] (int ch, float rms) {
+            node->setOutputRMS (ch, rms);
+        });
+
         node->updateGain();
         lastMute = muted;
+    }
 
-        for (int i = 0; i < numAudioOuts; ++i)
-            node->setOutputRMS (i, context.audio.getRMSLevel (i, 0, numSamples));
+    void getBufferAccess (BufferAccess& access) const override
+    {
+        // audio buffer zero is the read-only empty buffer given to unconnected inputs
+        for (int i = 0; i < totalChans; ++i)
+        {
+            const int buf = audioChannelsToUse.getUnchecked (i);
+            if (buf == 0)
+                access.read (PortType::Audio, buf);
+            else
+                access.write (PortType::Audio, buf);
+        }
+
+        for (int i = 0; i < totalCV; ++i)
+        {
+            const int buf = cvChannelsToUse.getUnchecked (i);
+            if (buf == 0)
+                access.read (PortType::CV, buf);
+            else
+                access.write (PortType::CV, buf);
+        }
+
+        for (const auto buf : midiChannelsToUse)
+            access.write (PortType::Midi, buf);
+        for (const auto buf : atomChannelsToUse)
+            access.write (PortType::Atom, buf);
+
+        if (node->isAudioIONode() || node->isMidiIONode())
+            access.writes.addIfNotAlreadyThere (BufferAccess::graphIOKey);
+    }
+
+    size_t getReuseKey() const noexcept override
+    {
+        return std::hash<const void*>() (node.get()) | 1;
+    }
+
+    bool isEquivalentTo (const GraphOp& other) const noexcept override
+    {
+        auto op = dynamic_cast<const ProcessBufferOp*> (&other);
+        return op != nullptr && op->node == node
+               && op->totalChans == totalChans && op->totalCV == totalCV
+               && op->audioChannelsToUse == audioChannelsToUse
+               && op->cvChannelsToUse == cvChannelsToUse
+               && op->midiChannelsToUse == midiChannelsToUse
+               && op->atomChannelsToUse == atomChannelsToUse;
     }
 
     const ProcessorPtr node;
@@ -645,11 +971,12 @@ private:
 
     HeapBlock<float*> channels;
     HeapBlock<float*> cv;
-    int totalChans, totalCV, numAudioIns, numAudioOuts;
+    int totalChans, totalCV, numAudioIns, numAudioOuts, numCVOuts, numAtomOuts;
     int midiBufferToUse;
     bool lastMute = false;
     MidiTranspose transpose;
     MidiBuffer tempMidi;
+    SilenceDetector silence;
 
     std::unique_ptr<float*> osChans;
     int osChanSize = 0;
@@ -658,9 +985,11 @@ private:
 
 GraphBuilder::GraphBuilder (GraphNode& graph_,
                             const Array<void*>& orderedNodes_,
-                            Array<void*>& renderingOps)
+                            Array<void*>& renderingOps,
+                            bool forParallelRendering)
     : graph (graph_),
       orderedNodes (orderedNodes_),
+      parallel (forParallelRendering),
       midi_MidiEvent (graph.symbols().map (LV2_MIDI__MidiEvent)),
       totalLatency (0)
 {
@@ -675,7 +1004,9 @@ GraphBuilder::GraphBuilder (GraphNode& graph_,
         createRenderingOpsForNode ((Processor*) orderedNodes.getUnchecked (i),
                                    renderingOps,
                                    i);
-        markUnusedBuffersFree (i);
+        nodeOpEnds.add (renderingOps.size());
+        if (! parallel)
+            markUnusedBuffersFree (i);
     }
 
 #if EL_TRACE_GRAPH_OPS
@@ -1113,6 +1444,28 @@ void GraphBuilder::createRenderingOpsForNode (Processor* const node,
     if (node->isAudioIONode() && node->getNumPorts (PortType::Audio, false) == 0)
         totalLatency = maxLatency;
 
+    if (parallel)
+    {
+        // Nodes without MIDI or Atom ports are still handed a buffer when
+        // rendered. Give each one its own so concurrently rendered nodes
+        // never write to the same one.
+        if (channelsToUse[PortType::Midi].isEmpty())
+        {
+            const int bufIndex = getFreeBuffer (PortType::Midi);
+            markBufferAsContaining (bufIndex, PortType::Midi, anonymousNodeID, 0);
+            renderingOps.add (new ClearMidiBufferOp (bufIndex));
+            channelsToUse[PortType::Midi].add (bufIndex);
+        }
+
+        if (channelsToUse[PortType::Atom].isEmpty())
+        {
+            const int bufIndex = getFreeBuffer (PortType::Atom);
+            markBufferAsContaining (bufIndex, PortType::Atom, anonymousNodeID, 0);
+            renderingOps.add (new ClearAtomBufferOp (bufIndex));
+            channelsToUse[PortType::Atom].add (bufIndex);
+        }
+    }
+
     int totalChans = jmax (node->getNumPorts (PortType::Audio, true),
                            node->getNumPorts (PortType::Audio, false));
     int totalCV = jmax (node->getNumPorts (PortType::CV, true),
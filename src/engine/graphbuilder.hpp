@@ -11,6 +11,55 @@ class AtomBuffer;
 class GraphNode;
 class Processor;
 
+/** Records which shared buffers a GraphOp reads and writes.  The parallel
+    renderer uses this to find ops which can run at the same time.
+ */
+struct BufferAccess
+{
+    /** Key used for state outside of the shared buffers, e.g. the parent
+        graph's IO buffers used by IONodes. */
+    static constexpr int graphIOKey = -1;
+
+    /** Returns a unique key for a shared buffer. CV uses audio buffers. */
+    static int key (PortType type, int index) noexcept
+    {
+        const int typeId = type == PortType::CV ? (int) PortType::Audio : (int) type.id();
+        return (typeId << 24) | (index & 0x00ffffff);
+    }
+
+    void read (PortType type, int index) { reads.addIfNotAlreadyThere (key (type, index)); }
+    void write (PortType type, int index) { writes.addIfNotAlreadyThere (key (type, index)); }
+
+    Array<int> reads, writes;
+};
+
+class GraphOp;
+
+/** One step of a compiled RenderProgram. Routing ops compile to plain data
+    which is run without a virtual call, everything else to `perform`.
+ */
+struct RenderInstruction
+{
+    enum Code : uint8
+    {
+        clearAudio,
+        copyAudio,
+        addAudio,
+        clearMidi,
+        copyMidi,
+        addMidi,
+        clearAtom,
+        copyAtom,
+        addAtom,
+        perform
+    };
+
+    Code code = perform;
+    int src = 0;
+    int dst = 0;
+    GraphOp* op = nullptr;
+};
+
 class GraphOp
 {
 public:
@@ -19,6 +68,25 @@ public:
 
     virtual std::string traceStep() const noexcept { return {}; }
 
+    /** Subclasses should report every shared buffer touched in perform. */
+    virtual void getBufferAccess (BufferAccess&) const {}
+
+    /** Returns a key used to find an equivalent op when the rendering
+        sequence is rebuilt, or zero if this op keeps no state between blocks.
+     */
+    virtual size_t getReuseKey() const noexcept { return 0; }
+
+    /** Returns true if this op does exactly the same work as another op with
+        the same reuse key. Equivalent ops are kept alive across rebuilds so
+        their state (delay lines, ramps, smoothing) carries on without a click.
+     */
+    virtual bool isEquivalentTo (const GraphOp&) const noexcept { return false; }
+
+    /** Routing ops fill in the instruction and return true. Ops which return
+        false are called through perform.
+     */
+    virtual bool compile (RenderInstruction&) const noexcept { return false; }
+
     virtual void perform (juce::AudioSampleBuffer& sharedBufferChans,
                           const juce::OwnedArray<MidiBuffer>& sharedMidiBuffers,
                           const juce::OwnedArray<AtomBuffer>& sharedAtomBuffers,
@@ -33,17 +101,29 @@ private:
 class GraphBuilder
 {
 public:
+    /** Builds the ops.
+
+        When building for parallel rendering, shared buffers are never
+        recycled between nodes. This uses more memory but avoids false
+        dependencies between otherwise independent branches of the graph.
+     */
     GraphBuilder (GraphNode& graph_,
                   const Array<void*>& orderedNodes_,
-                  Array<void*>& renderingOps);
+                  Array<void*>& renderingOps,
+                  bool forParallelRendering = false);
 
     int buffersNeeded (PortType type);
     int getTotalLatencySamples() const { return totalLatency; }
 
+    /** Returns the end index in the op list for each rendered node. */
+    const Array<int>& getNodeOpEnds() const noexcept { return nodeOpEnds; }
+
 private:
     //==============================================================================
     GraphNode& graph;
     const Array<void*>& orderedNodes;
+    const bool parallel;
+    Array<int> nodeOpEnds;
     Array<uint32> allNodes[PortType::Unknown];
     Array<uint32> allPorts[PortType::Unknown];
     const uint32_t midi_MidiEvent;
@@ -261,6 +261,108 @@ private:
     [[maybe_unused]] UndoManager* undo = nullptr;
 };
 
+//==============================================================================
+/** Creates the processors of a graph's nodes. Formats which allow it get
+    created, and have their plugin state restored, on a pool of threads while
+    the message thread creates the rest one at a time.
+ */
+class GraphManager::NodeLoader final
+{
+public:
+    struct Item
+    {
+        Node node;
+        PluginDescription desc;
+        Node::PluginState state;
+        ProcessorPtr object;
+        bool stateRestored = false;
+    };
+
+    NodeLoader (GraphManager& m) : manager (m) {}
+
+    /** Returns true if a format's plugins can load off the message thread.
+        Element's LV2 host serializes its use of lilv, the plugins themselves
+        don't need the message thread to instantiate or restore state. */
+    static bool canLoadOnPool (const PluginDescription& desc)
+    {
+        return desc.pluginFormatName == "LV2";
+    }
+
+    /** Create a processor for every node, returns once all are done. */
+    void load (const ValueTree& nodes)
+    {
+        for (int i = 0; i < nodes.getNumChildren(); ++i)
+        {
+            auto* item = items.add (new Item());
+            item->node = Node (nodes.getChild (i), false);
+            item->desc = manager.pluginManager.findDescriptionFor (item->node);
+            if (canLoadOnPool (item->desc))
+                item->state = item->node.getPluginState();
+        }
+
+        for (auto* item : items)
+        {
+            if (! canLoadOnPool (item->desc))
+                continue;
+            ++numPending;
+            pool->addJob ([this, item]() { loadOnPool (*item); });
+        }
+
+        for (auto* item : items)
+        {
+            if (canLoadOnPool (item->desc))
+                continue;
+            item->object = manager.createProcessor (item->desc);
+            reportProgress (++numLoaded);
+        }
+
+        // no nested message loop here, the graph isn't built yet
+        while (numPending.load() > 0)
+            finished.wait (50);
+
+        reportProgress (numLoaded.load());
+    }
+
+    const OwnedArray<Item>& getItems() const noexcept { return items; }
+
+private:
+    struct Pool : public ThreadPool
+    {
+        Pool() : ThreadPool (jlimit (1, 8, SystemStats::getNumCpus())) {}
+    };
+
+    GraphManager& manager;
+    SharedResourcePointer<Pool> pool;
+    OwnedArray<Item> items;
+    std::atomic<int> numPending { 0 }, numLoaded { 0 };
+    WaitableEvent finished;
+
+    void loadOnPool (Item& item)
+    {
+        item.object = manager.createProcessor (item.desc);
+        if (item.object != nullptr)
+        {
+            item.state.applyTo (*item.object);
+            item.stateRestored = true;
+        }
+
+        reportProgress (++numLoaded);
+        if (--numPending == 0)
+            finished.signal();
+    }
+
+    /** Queue progress for the message thread (any thread). It arrives once
+        load() returns, after which the last report is the complete one. */
+    void reportProgress (int loaded)
+    {
+        if (manager.onLoadProgress == nullptr)
+            return;
+        MessageManager::callAsync ([callback = manager.onLoadProgress, loaded, total = items.size()]() {
+            callback (loaded, total);
+        });
+    }
+};
+
 //==============================================================================
 GraphManager::GraphManager (GraphNode& pg, PluginManager& pm)
     : pluginManager (pm), processor (pg), lastUID (0)
@@ -315,11 +417,11 @@ bool GraphManager::contains (const uint32 nodeId) const
     return processor.getNodeForId (nodeId) != nullptr;
 }
 
-Processor* GraphManager::createFilter (const PluginDescription* desc, double x, double y, uint32 nodeId)
+Processor* GraphManager::createProcessor (const PluginDescription& desc)
 {
     String errorMessage;
     auto node = std::unique_ptr<Processor> (
-        pluginManager.createGraphNode (*desc, errorMessage));
+        pluginManager.createGraphNode (desc, errorMessage));
 
     if (errorMessage.isNotEmpty())
     {
@@ -333,7 +435,13 @@ Processor* GraphManager::createFilter (const PluginDescription* desc, double x,
         errorMessage = "Could not find node";
     }
 
-    return node != nullptr ? processor.addNode (node.release(), nodeId) : nullptr;
+    return node.release();
+}
+
+Processor* GraphManager::createFilter (const PluginDescription* desc, double x, double y, uint32 nodeId)
+{
+    auto* node = createProcessor (*desc);
+    return node != nullptr ? processor.addNode (node, nodeId) : nullptr;
 }
 
 Processor* GraphManager::createPlaceholder (const Node& node)
@@ -513,7 +621,7 @@ void GraphManager::removeNode (const uint32 uid)
             auto data = node.data();
             nodes.removeChild (data, nullptr);
             // clear all referecnce counted objects
-            Node::sanitizeProperties (data, true);
+            Node::sanitizeRuntimeProperties (data, true);
             // finally delete the node + plugin instance.
             obj = nullptr;
         }
@@ -614,14 +722,19 @@ void GraphManager::setNodeModel (const Node& node)
 
     graph.setProperty (tags::updater, new NodeModelUpdater (*this, graph, &processor), nullptr);
 
+    // create everything first, then add to the graph in the model's order
+    NodeLoader loader (*this);
+    loader.load (nodes);
+
     Array<ValueTree> failed;
-    for (int i = 0; i < nodes.getNumChildren(); ++i)
+    for (auto* item : loader.getItems())
     {
-        Node node (nodes.getChild (i), false);
-        const PluginDescription desc (pluginManager.findDescriptionFor (node));
-        if (ProcessorPtr obj = createFilter (&desc, 0, 0, node.getNodeId()))
+        auto& node = item->node;
+        ProcessorPtr obj = item->object != nullptr ? processor.addNode (item->object.get(), node.getNodeId())
+                                                   : nullptr;
+        if (obj != nullptr)
         {
-            setupNode (node.data(), obj);
+            setupNode (node.data(), obj, ! item->stateRestored);
             obj->setEnabled (node.isEnabled());
             node.setProperty (tags::enabled, obj->isEnabled());
         }
@@ -712,6 +825,28 @@ void GraphManager::savePluginStates()
     }
 }
 
+void GraphManager::unloadNodes()
+{
+    if (! loaded)
+        return;
+
+    savePluginStates();
+    loaded = false;
+
+    if (graph.hasProperty (tags::updater))
+    {
+        graph.setProperty (tags::updater, (NodeModelUpdater*) nullptr, nullptr);
+        graph.removeProperty (tags::updater, nullptr);
+    }
+
+    bindings.clear();
+    processor.clear();
+    for (int i = 0; i < nodes.getNumChildren(); ++i)
+        Node::sanitizeRuntimeProperties (nodes.getChild (i), true);
+
+    changed();
+}
+
 void GraphManager::clear()
 {
     loaded = false;
@@ -763,7 +898,7 @@ void GraphManager::processorArcsChanged()
     changed();
 }
 
-void GraphManager::setupNode (const ValueTree& data, ProcessorPtr obj)
+void GraphManager::setupNode (const ValueTree& data, ProcessorPtr obj, bool restoreState)
 {
     jassert (obj && data.hasType (types::Node));
     Node node (data, false);
@@ -837,7 +972,10 @@ void GraphManager::setupNode (const ValueTree& data, ProcessorPtr obj)
         resetPorts = true;
     }
 
-    node.restorePluginState();
+    if (restoreState)
+        node.restorePluginState();
+    else
+        node.restoreSettings();
     node.resetPorts();
     if (node.isA ("Element", EL_NODE_ID_MIDI_INPUT_DEVICE) || node.isA ("Element", EL_NODE_ID_MIDI_OUTPUT_DEVICE))
     {
@@ -856,9 +994,4 @@ RootGraphManager::RootGraphManager (RootGraph& graph, PluginManager& plugins)
 
 RootGraphManager::~RootGraphManager() {}
 
-void RootGraphManager::unloadGraph()
-{
-    getRootGraph().clear();
-}
-
 } // namespace element
@@ -83,6 +83,10 @@ public:
 
     void savePluginStates();
 
+    /** Saves plugin states then deletes every node, keeping the model so
+        setNodeModel can load it again. */
+    void unloadNodes();
+
     /** Rebuilds the arcs model according to the GraphNode */
     inline void syncArcsModel()
     {
@@ -92,6 +96,10 @@ public:
 
     inline bool isLoaded() const { return loaded; }
 
+    /** Called on the message thread as setNodeModel creates nodes. The
+        calls are queued, so most arrive after setNodeModel returns. */
+    std::function<void (int numLoaded, int numNodes)> onLoadProgress;
+
 private:
     PluginManager& pluginManager;
     GraphNode& processor;
@@ -104,12 +112,15 @@ private:
     friend class Binding;
     OwnedArray<Binding> bindings;
 
+    class NodeLoader;
+
     uint32 getNextUID() noexcept;
     inline void changed() { sendChangeMessage(); }
+    Processor* createProcessor (const PluginDescription& desc);
     Processor* createFilter (const PluginDescription* desc, double x = 0.0f, double y = 0.0f, uint32 nodeId = 0);
     Processor* createPlaceholder (const Node& node);
 
-    void setupNode (const ValueTree& data, ProcessorPtr object);
+    void setupNode (const ValueTree& data, ProcessorPtr object, bool restoreState = true);
 
     void processorArcsChanged();
 
@@ -126,7 +137,7 @@ public:
     RootGraph& getRootGraph() const { return root; }
 
     /** Unload graph nodes without clearing the model */
-    void unloadGraph();
+    void unloadGraph() { unloadNodes(); }
 
 private:
     RootGraph& root;
@@ -1,6 +1,9 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <queue>
+#include <unordered_map>
+
 #include <element/audioengine.hpp>
 #include <element/midipipe.hpp>
 #include <element/node.hpp>
@@ -10,6 +13,8 @@
 
 #include "engine/graphbuilder.hpp"
 #include "engine/ionode.hpp"
+#include "engine/parallelrender.hpp"
+#include "engine/rendersequence.hpp"
 #include "nodes/audioprocessor.hpp"
 #include "engine/miditranspose.hpp"
 #include "nodes/nodetypes.hpp"
@@ -31,7 +36,6 @@ GraphNode::GraphNode (Context& c)
                      .toPortList()),
       _context (c),
       lastNodeId (0),
-      renderingBuffers (1, 1),
       currentAudioInputBuffer (nullptr),
       currentAudioOutputBuffer (1, 1),
       currentMidiInputBuffer (nullptr)
@@ -46,6 +50,7 @@ GraphNode::~GraphNode()
     renderingSequenceChanged.disconnect_all_slots();
     clearRenderingSequence();
     clear();
+    reclaimer->reclaim (renderingHazard);
 }
 
 void GraphNode::clear()
@@ -357,23 +362,133 @@ void GraphNode::setVelocityCurveMode (const VelocityCurve::Mode mode) noexcept
     velocityCurve.setMode (mode);
 }
 
-static void deleteRenderOpArray (Array<void*>& ops)
+/** Swaps newly built ops for equivalent ops from the live sequence so their
+    state carries on through a rebuild. The duplicates are deleted right away.
+    Indexes of the reused ops in oldOps are added to reused so they aren't
+    deleted with the rest of the old sequence.
+ */
+static void reuseEquivalentOps (Array<void*>& newOps, const Array<void*>& oldOps, Array<int>& reused)
 {
-    for (int i = ops.size(); --i >= 0;)
-        delete static_cast<GraphOp*> (ops.getUnchecked (i));
-    ops.clearQuick();
+    std::unordered_multimap<size_t, int> available;
+    available.reserve ((size_t) oldOps.size());
+    for (int i = 0; i < oldOps.size(); ++i)
+        if (const auto key = static_cast<GraphOp*> (oldOps.getUnchecked (i))->getReuseKey())
+            available.emplace (key, i);
+
+    if (available.empty())
+        return;
+
+    for (int i = 0; i < newOps.size(); ++i)
+    {
+        auto* const op = static_cast<GraphOp*> (newOps.getUnchecked (i));
+        const auto key = op->getReuseKey();
+        if (key == 0)
+            continue;
+
+        const auto range = available.equal_range (key);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            auto* const old = static_cast<GraphOp*> (oldOps.getUnchecked (it->second));
+            if (! op->isEquivalentTo (*old))
+                continue;
+
+            reused.add (it->second);
+            newOps.set (i, old);
+            available.erase (it);
+            delete op;
+            break;
+        }
+    }
 }
 
-void GraphNode::clearRenderingSequence()
-{
-    Array<void*> oldOps;
+/** Sorts nodes so every node comes after the nodes feeding it. This is Kahn's
+    algorithm over an adjacency index built once per call, O((V + E) log V).
+    Unrelated nodes keep the order they were added in. Feedback loops can't be
+    sorted, so when only looped nodes are left the earliest added one goes next.
+ */
+static void sortNodesForRendering (const ReferenceCountedArray<Processor>& nodes,
+                                   const OwnedArray<GraphNode::Connection>& connections,
+                                   Array<int>& order)
+{
+    const int numNodes = nodes.size();
+    order.clearQuick();
+    order.ensureStorageAllocated (numNodes);
+
+    std::unordered_map<uint32, int> indexes;
+    indexes.reserve ((size_t) numNodes);
+    for (int i = 0; i < numNodes; ++i)
+        indexes[nodes.getUnchecked (i)->nodeId] = i;
+
+    // outgoing edges per node, stored contiguously
+    Array<int> numInputs, firstEdge, edges;
+    numInputs.insertMultiple (0, 0, numNodes);
+    firstEdge.insertMultiple (0, 0, numNodes + 1);
+
+    Array<int> sources, dests;
+    sources.ensureStorageAllocated (connections.size());
+    dests.ensureStorageAllocated (connections.size());
+    for (const auto* c : connections)
+    {
+        const auto src = indexes.find (c->sourceNode);
+        const auto dst = indexes.find (c->destNode);
+        if (src == indexes.end() || dst == indexes.end())
+            continue;
+        sources.add (src->second);
+        dests.add (dst->second);
+        firstEdge.getReference (src->second + 1) += 1;
+        numInputs.getReference (dst->second) += 1;
+    }
 
+    for (int i = 0; i < numNodes; ++i)
+        firstEdge.getReference (i + 1) += firstEdge.getUnchecked (i);
+
+    edges.insertMultiple (0, 0, sources.size());
     {
-        const ScopedLock sl (seqLock);
-        renderingOps.swapWith (oldOps);
+        Array<int> fill (firstEdge);
+        for (int i = 0; i < sources.size(); ++i)
+            edges.set (fill.getReference (sources.getUnchecked (i))++, dests.getUnchecked (i));
     }
 
-    deleteRenderOpArray (oldOps);
+    std::priority_queue<int, std::vector<int>, std::greater<int>> ready;
+    for (int i = 0; i < numNodes; ++i)
+        if (numInputs.getUnchecked (i) == 0)
+            ready.push (i);
+
+    Array<bool> visited;
+    visited.insertMultiple (0, false, numNodes);
+    int nextUnvisited = 0;
+
+    while (order.size() < numNodes)
+    {
+        if (ready.empty())
+        {
+            // only feedback loops left
+            while (visited.getUnchecked (nextUnvisited))
+                ++nextUnvisited;
+            numInputs.set (nextUnvisited, 0);
+            ready.push (nextUnvisited);
+        }
+
+        const int node = ready.top();
+        ready.pop();
+        if (visited.getUnchecked (node))
+            continue;
+
+        visited.set (node, true);
+        order.add (node);
+
+        for (int e = firstEdge.getUnchecked (node); e < firstEdge.getUnchecked (node + 1); ++e)
+        {
+            const int dest = edges.getUnchecked (e);
+            if (! visited.getUnchecked (dest) && --numInputs.getReference (dest) == 0)
+                ready.push (dest);
+        }
+    }
+}
+
+void GraphNode::clearRenderingSequence()
+{
+    reclaimer->retire (renderingSequence.exchange (nullptr), renderingHazard);
 }
 
 bool GraphNode::isAnInputTo (const uint32 possibleInputId,
@@ -398,7 +513,9 @@ bool GraphNode::isAnInputTo (const uint32 possibleInputId,
 
 void GraphNode::buildRenderingSequence()
 {
-    Array<void*> newRenderingOps;
+    auto newSequence = std::make_unique<RenderSequence>();
+    auto* const oldSequence = renderingSequence.load();
+    Array<int> reusedOps;
     int numRenderingBuffersNeeded = 2;
     int numMidiBuffersNeeded = 1;
     int numAtomBuffersNeeded = 1;
@@ -410,22 +527,20 @@ void GraphNode::buildRenderingSequence()
         Array<void*> orderedNodes;
 
         {
-            const LookupTable table (connections);
-
-            for (int i = 0; i < nodes.size(); ++i)
-            {
-                Processor* const node = nodes.getUnchecked (i);
-
-                int j = 0;
-                for (; j < orderedNodes.size(); ++j)
-                    if (table.isAnInputTo (node->nodeId, ((Processor*) orderedNodes.getUnchecked (j))->nodeId))
-                        break;
-
-                orderedNodes.insert (j, node);
-            }
+            Array<int> order;
+            sortNodesForRendering (nodes, connections, order);
+            orderedNodes.ensureStorageAllocated (order.size());
+            for (const auto index : order)
+                orderedNodes.add (nodes.getUnchecked (index));
         }
 
-        GraphBuilder builder (*this, orderedNodes, newRenderingOps);
+        auto& newRenderingOps = newSequence->ops;
+        GraphBuilder builder (*this, orderedNodes, newRenderingOps, parallelRendering);
+        if (oldSequence != nullptr)
+            reuseEquivalentOps (newRenderingOps, oldSequence->ops, reusedOps);
+        newSequence->program.compile (newRenderingOps);
+        if (parallelRendering)
+            newSequence->schedule = std::make_unique<RenderSchedule> (newRenderingOps, builder.getNodeOpEnds());
         numRenderingBuffersNeeded = builder.buffersNeeded (PortType::Audio);
         numMidiBuffersNeeded = builder.buffersNeeded (PortType::Midi);
         numAtomBuffersNeeded = builder.buffersNeeded (PortType::Atom);
@@ -433,49 +548,52 @@ void GraphNode::buildRenderingSequence()
     }
 
     {
-        // swap over to the new rendering sequence..
+        // Buffers are shared with the live sequence while they're big enough,
+        // so chains which weren't touched by the edit keep rendering without a
+        // gap. When more are needed the new sequence gets a fresh, larger set
+        // and nothing published is ever resized.
+        auto buffers = oldSequence != nullptr ? oldSequence->buffers : nullptr;
+        if (buffers == nullptr || ! buffers->canHold (numRenderingBuffersNeeded, numMidiBuffersNeeded, numAtomBuffersNeeded))
         {
-            const ScopedLock sl (getPropertyLock());
-            renderingBuffers.setSize (numRenderingBuffersNeeded, 4096);
-            renderingBuffers.clear();
-            for (auto ab : atomBuffers)
-                ab->clear();
-            for (int i = midiBuffers.size(); --i >= 0;)
-                midiBuffers.getUnchecked (i)->clear();
-
-            while (midiBuffers.size() < numMidiBuffersNeeded)
-                midiBuffers.add (new MidiBuffer());
-            while (atomBuffers.size() < numAtomBuffersNeeded)
+            auto bigger = std::make_shared<RenderBuffers>();
+            if (buffers != nullptr)
             {
-                auto ab = atomBuffers.add (new AtomBuffer());
-                ab->setTypes (_context.symbols());
+                numRenderingBuffersNeeded = jmax (numRenderingBuffersNeeded, buffers->audio.getNumChannels());
+                numMidiBuffersNeeded = jmax (numMidiBuffersNeeded, buffers->midi.size());
+                numAtomBuffersNeeded = jmax (numAtomBuffersNeeded, buffers->atom.size());
             }
+
+            bigger->audio.setSize (numRenderingBuffersNeeded, 4096);
+            bigger->audio.clear();
+            while (bigger->midi.size() < numMidiBuffersNeeded)
+                bigger->midi.add (new MidiBuffer());
+            while (bigger->atom.size() < numAtomBuffersNeeded)
+                bigger->atom.add (new AtomBuffer())->setTypes (_context.symbols());
+            buffers = std::move (bigger);
         }
 
-        ScopedLock sl (seqLock);
-        renderingOps.swapWith (newRenderingOps);
+        newSequence->buffers = std::move (buffers);
+        renderingSequence.store (newSequence.release());
     }
 
-    // delete the old ones..
-    deleteRenderOpArray (newRenderingOps);
+    // the old ones get deleted once the audio thread lets go of them, except
+    // for those carried over in to the new sequence..
+    if (oldSequence != nullptr)
+    {
+        oldSequence->released.swapWith (reusedOps);
+        reclaimer->retire (oldSequence, renderingHazard);
+    }
 
     renderingSequenceChanged();
 }
 
 void GraphNode::getOrderedNodes (ReferenceCountedArray<Processor>& orderedNodes)
 {
-    const LookupTable table (connections);
-    for (int i = 0; i < nodes.size(); ++i)
-    {
-        Processor* const node = nodes.getUnchecked (i);
-
-        int j = 0;
-        for (; j < orderedNodes.size(); ++j)
-            if (table.isAnInputTo (node->nodeId, ((Processor*) orderedNodes.getUnchecked (j))->nodeId))
-                break;
-
-        orderedNodes.insert (j, node);
-    }
+    Array<int> order;
+    sortNodesForRendering (nodes, connections, order);
+    orderedNodes.ensureStorageAllocated (orderedNodes.size() + order.size());
+    for (const auto index : order)
+        orderedNodes.add (nodes.getUnchecked (index));
 }
 
 void GraphNode::handleAsyncUpdate()
@@ -513,9 +631,7 @@ void GraphNode::releaseResources()
         nodes.getUnchecked (i)->unprepare();
 
     _prepared = false;
-
-    renderingBuffers.setSize (1, 1);
-    midiBuffers.clear();
+    clearRenderingSequence();
 
     currentAudioInputBuffer = nullptr;
     currentAudioOutputBuffer.setSize (1, 1);
@@ -570,15 +686,18 @@ void GraphNode::render (RenderContext& rc)
 
     currentMidiOutputBuffer.clear();
 
+    if (auto* const seq = RenderSequence::acquire (renderingSequence, renderingHazard))
     {
-        ScopedLock sl (seqLock);
-        for (auto ptr : renderingOps)
+        auto& buffers = *seq->buffers;
+        if (seq->schedule == nullptr
+            || ! renderPool->perform (*seq->schedule, buffers.audio, buffers.midi, buffers.atom, numSamples))
         {
-            GraphOp* const op = static_cast<GraphOp*> (ptr);
-            op->perform (renderingBuffers, midiBuffers, atomBuffers, numSamples);
+            seq->program.run (buffers.audio, buffers.midi, buffers.atom, numSamples);
         }
     }
 
+    RenderSequence::release (renderingHazard);
+
     for (int i = 0; i < rc.audio.getNumChannels(); ++i)
         rc.audio.copyFrom (i, 0, currentAudioOutputBuffer, i, 0, numSamples);
 
@@ -662,4 +781,24 @@ void GraphNode::rebuild() noexcept
     handleAsyncUpdate();
 }
 
+void GraphNode::getRenderingOps (Array<const GraphOp*>& ops) const
+{
+    if (auto* const sequence = renderingSequence.load())
+        for (auto* op : sequence->ops)
+            ops.add (static_cast<const GraphOp*> (op));
+}
+
+void GraphNode::setParallelRendering (bool shouldRenderInParallel)
+{
+    if (parallelRendering == shouldRenderInParallel)
+        return;
+
+    parallelRendering = shouldRenderInParallel;
+    if (parallelRendering)
+        renderPool->start (RenderPool::getDefaultNumWorkers());
+
+    if (prepared())
+        rebuild();
+}
+
 } // namespace element
@@ -12,6 +12,11 @@
 namespace element {
 
 class Context;
+class GraphOp;
+class RenderPool;
+class RenderSchedule;
+struct RenderSequence;
+class RenderSequenceReclaimer;
 class SymbolMap;
 
 class GraphNode : public Processor,
@@ -189,6 +194,20 @@ public:
     /** Rebuild rendering ops immediately. */
     void rebuild() noexcept;
 
+    /** Adds the ops of the current rendering sequence to the array. The ops
+        belong to the graph, so only use this on the message thread. */
+    void getRenderingOps (Array<const GraphOp*>& ops) const;
+
+    /** Render independent nodes on multiple cores.
+
+        Nested graphs are rendered as a single node of the graph containing
+        them.  This rebuilds the rendering sequence if prepared.
+     */
+    void setParallelRendering (bool shouldRenderInParallel);
+
+    /** Returns true if rendering on multiple cores. */
+    bool isRenderingInParallel() const noexcept { return parallelRendering; }
+
 protected:
     //==========================================================================
     virtual void preRenderNodes() {}
@@ -215,10 +234,11 @@ private:
     uint32 ioNodes[10];
 
     uint32 lastNodeId;
-    AudioSampleBuffer renderingBuffers;
-    OwnedArray<MidiBuffer> midiBuffers;
-    OwnedArray<AtomBuffer> atomBuffers;
-    Array<void*> renderingOps;
+    std::atomic<RenderSequence*> renderingSequence { nullptr };
+    std::atomic<RenderSequence*> renderingHazard { nullptr };
+    SharedResourcePointer<RenderSequenceReclaimer> reclaimer;
+    SharedResourcePointer<RenderPool> renderPool;
+    bool parallelRendering = false;
     bool _prepared = false;
 
     AudioSampleBuffer* currentAudioInputBuffer;
@@ -235,7 +255,6 @@ private:
     bool customPortsSet = false;
     PortList userPorts;
 
-    CriticalSection seqLock;
     friend class ScriptNode; // workaround so parameter connections work when params change.
     void handleAsyncUpdate() override;
     void clearRenderingSequence();
@@ -1,6 +1,9 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include <array>
+#include <unordered_map>
+
 #include <element/processor.hpp>
 #include "engine/mappingengine.hpp"
 #include "engine/midiengine.hpp"
@@ -15,8 +18,157 @@ public:
     ControllerMapHandler() {}
     virtual ~ControllerMapHandler() {}
 
-    virtual bool wants (const MidiMessage& message) const = 0;
-    virtual void perform (const MidiMessage& message) = 0;
+    /** The events a handler wants, used to build an input's routing table. */
+    struct Route
+    {
+        enum Type
+        {
+            controller,
+            note,
+            controller14,
+            nrpn
+        };
+
+        Type type = controller;
+        int number = 0;
+        int channel = 0; // 0 is omni
+    };
+
+    virtual Route getRoute() const = 0;
+
+    /** Handle a 7-bit controller or a note (MIDI thread). Returns true if a
+        value was held back for applyPendingValue and the handler should be
+        queued. */
+    virtual bool perform (const MidiMessage& message) = 0;
+
+    /** Handle a 14-bit controller or NRPN value (MIDI thread). */
+    virtual bool perform14 (int value)
+    {
+        ignoreUnused (value);
+        return false;
+    }
+
+    /** Apply the latest value held back by perform (audio thread). */
+    virtual void applyPendingValue() {}
+
+    /** Called on the message thread when getRoute() changes. */
+    std::function<void()> onRouteChanged;
+
+protected:
+    void routeChanged()
+    {
+        if (onRouteChanged)
+            onRouteChanged();
+    }
+};
+
+/** The latest value for a parameter or toggle. A burst of controller
+    events is applied once per block. */
+class PendingValue
+{
+public:
+    /** Returns true if nothing was pending and the caller should queue it. */
+    bool set (float newValue) noexcept
+    {
+        value.store (newValue, std::memory_order_relaxed);
+        return ! pending.exchange (true, std::memory_order_acq_rel);
+    }
+
+    /** Returns the value waiting to be applied, or fallback if there isn't one. */
+    float getLatest (float fallback) const noexcept
+    {
+        return pending.load (std::memory_order_acquire) ? value.load (std::memory_order_relaxed) : fallback;
+    }
+
+    /** Take the pending value (audio thread). Returns false if there wasn't one. */
+    bool take (float& result) noexcept
+    {
+        if (! pending.exchange (false, std::memory_order_acq_rel))
+            return false;
+        result = value.load (std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    std::atomic<float> value { 0.f };
+    std::atomic<bool> pending { false };
+};
+
+/** Enable, bypass and mute as a toggle state: enabled, suspended or muted. */
+struct NodeToggle
+{
+    static bool isToggle (int index) noexcept
+    {
+        return index == Processor::EnabledParameter || index == Processor::BypassParameter || index == Processor::MuteParameter;
+    }
+
+    /** Returns the state for a control which is on. On is not bypassed. */
+    static bool fromOn (int index, bool on) noexcept
+    {
+        return index == Processor::BypassParameter ? ! on : on;
+    }
+
+    static bool get (const Processor& node, int index)
+    {
+        if (index == Processor::EnabledParameter)
+            return node.isEnabledRequested();
+        if (index == Processor::BypassParameter)
+            return node.isSuspended();
+        return node.isMuted();
+    }
+
+    /** Set a state (audio thread). Bypass, mute and disabling render from
+        this block. Enabling has to prepare the plugin, and disabling
+        releases it, so the processor finishes those on the message thread. */
+    static void set (Processor& node, int index, bool state)
+    {
+        if (index == Processor::EnabledParameter)
+            node.setEnabled (state);
+        else if (index == Processor::BypassParameter)
+            node.suspendProcessing (state);
+        else if (index == Processor::MuteParameter)
+            node.setMuted (state);
+    }
+
+    /** Apply a pending value to a parameter, or else to a toggle (audio
+        thread). Returns true if a toggle was set and the model needs a sync. */
+    static bool apply (PendingValue& pending, Parameter* parameter, Processor& node, int index)
+    {
+        float value = 0.f;
+        if (! pending.take (value))
+            return false;
+
+        if (parameter != nullptr)
+        {
+            parameter->beginChangeGesture();
+            parameter->setValueNotifyingHost (value);
+            parameter->endChangeGesture();
+            return false;
+        }
+
+        set (node, index, value >= 0.5f);
+        return true;
+    }
+
+    /** Update the model to match the processor (message thread). */
+    static void sync (Node model, const Processor& node, int index)
+    {
+        if (index == Processor::EnabledParameter)
+        {
+            if (model.isEnabled() != node.isEnabled())
+                model.setProperty (tags::enabled, node.isEnabled());
+        }
+        else if (index == Processor::BypassParameter)
+        {
+            if (model.isBypassed() != node.isSuspended())
+                model.setProperty (tags::bypass, node.isSuspended());
+        }
+        else if (index == Processor::MuteParameter)
+        {
+            if (model.isMuted() != node.isMuted())
+                model.setMuted (node.isMuted());
+        }
+    }
 };
 
 struct MidiNoteControllerMap : public ControllerMapHandler,
@@ -61,98 +213,47 @@ struct MidiNoteControllerMap : public ControllerMapHandler,
         channelObject.removeListener (this);
     }
 
-    bool checkNoteAndChannel (const MidiMessage& message) const
-    {
-        return message.getNoteNumber() == noteNumber && (channel.get() == 0 || (channel.get() > 0 && message.getChannel() == channel.get()));
-    }
+    Route getRoute() const override { return { Route::note, noteNumber, channel.get() }; }
 
-    bool wants (const MidiMessage& message) const override
+    bool perform (const MidiMessage& message) override
     {
-        bool wants = momentary.get() == 0
-                         ? message.isNoteOn() && checkNoteAndChannel (message)
-                         : message.isNoteOnOrOff() && checkNoteAndChannel (message);
-        return wants;
-    }
+        if (momentary.get() == 0 && ! message.isNoteOn())
+            return false;
 
-    void perform (const MidiMessage& message) override
-    {
+        jassert (message.isNoteOnOrOff());
         const bool isInverse = inverse.get() == 1;
+        const bool isOn = isInverse ? message.isNoteOff() : message.isNoteOn();
 
+        if (parameter != nullptr)
         {
-            SpinLock::ScopedLockType sl (eventLock);
-            lastEvent = message;
+            if (momentary.get() == 0)
+                return pendingValue.set (pendingValue.getLatest (parameter->getValue()) < 0.5f ? 1.f : 0.f);
+            return pendingValue.set (isOn ? 1.f : 0.f);
         }
 
-        jassert (message.isNoteOnOrOff());
+        if (! NodeToggle::isToggle (parameterIndex))
+            return false;
 
-        if (parameter != nullptr)
+        bool state = NodeToggle::fromOn (parameterIndex, isOn);
+        if (momentary.get() == 0)
         {
-            parameter->beginChangeGesture();
-            if (momentary.get() == 0)
-            {
-                parameter->setValueNotifyingHost (parameter->getValue() < 0.5 ? 1.f : 0.f);
-            }
-            else
-            {
-                const bool onOrOff = isInverse ? message.isNoteOff() : message.isNoteOn();
-                parameter->setValueNotifyingHost (onOrOff ? 1.f : 0.f);
-            }
-
-            parameter->endChangeGesture();
+            // toggle from what the audio thread will see next
+            const auto current = NodeToggle::get (*node, parameterIndex) ? 1.f : 0.f;
+            state = pendingValue.getLatest (current) < 0.5f;
         }
-        else if (parameterIndex == Processor::EnabledParameter || parameterIndex == Processor::BypassParameter || parameterIndex == Processor::MuteParameter)
-        {
+
+        return pendingValue.set (state ? 1.f : 0.f);
+    }
+
+    void applyPendingValue() override
+    {
+        if (NodeToggle::apply (pendingValue, parameter.get(), *node, parameterIndex))
             triggerAsyncUpdate();
-        }
     }
 
     void handleAsyncUpdate() override
     {
-        MidiMessage event;
-
-        {
-            SpinLock::ScopedLockType sl (eventLock);
-            event = lastEvent;
-        }
-
-        if (momentary.get() == 0)
-        {
-            if (parameterIndex == Processor::EnabledParameter)
-            {
-                node->setEnabled (! node->isEnabled());
-                model.setProperty (tags::enabled, node->isEnabled());
-            }
-            else if (parameterIndex == Processor::BypassParameter)
-            {
-                node->suspendProcessing (! node->isSuspended());
-                model.setProperty (tags::bypass, node->isSuspended());
-            }
-            else if (parameterIndex == Processor::MuteParameter)
-            {
-                model.setMuted (! model.isMuted());
-            }
-        }
-        else
-        {
-            jassert (event.isNoteOnOrOff());
-            // DBG("async note off: " << (int) event.isNoteOff());
-            const bool isInverse = inverse.get() == 1;
-
-            if (parameterIndex == Processor::EnabledParameter)
-            {
-                node->setEnabled (isInverse ? event.isNoteOff() : event.isNoteOn());
-                model.setProperty (tags::enabled, node->isEnabled());
-            }
-            else if (parameterIndex == Processor::BypassParameter)
-            {
-                node->suspendProcessing (isInverse ? event.isNoteOn() : event.isNoteOff());
-                model.setProperty (tags::bypass, node->isSuspended());
-            }
-            else if (parameterIndex == Processor::MuteParameter)
-            {
-                model.setMuted (isInverse ? event.isNoteOff() : event.isNoteOn());
-            }
-        }
+        NodeToggle::sync (model, *node, parameterIndex);
     }
 
 private:
@@ -172,15 +273,14 @@ private:
     Atomic<int> inverse { 0 };
 
     const int noteNumber;
-
-    SpinLock eventLock;
-    MidiMessage lastEvent;
+    PendingValue pendingValue;
 
     void valueChanged (Value& value) override
     {
         if (channelObject.refersToSameSourceAs (value))
         {
             channel.set (jlimit (0, 16, (int) channelObject.getValue()));
+            routeChanged();
         }
         else if (momentaryObject.refersToSameSourceAs (value))
         {
@@ -241,22 +341,18 @@ struct MidiCCControllerMapHandler : public ControllerMapHandler,
         channelObject.removeListener (this);
     }
 
-    bool wants (const MidiMessage& message) const override
-    {
-        return message.isController() && message.getControllerNumber() == controllerNumber && (channel.get() == 0 || (channel.get() > 0 && message.getChannel() == channel.get()));
-    }
+    Route getRoute() const override { return { Route::controller, controllerNumber, channel.get() }; }
 
-    void perform (const MidiMessage& message) override
+    bool perform (const MidiMessage& message) override
     {
         const auto ccValue = message.getControllerValue();
+        bool queue = false;
 
         if (nullptr != parameter)
         {
-            parameter->beginChangeGesture();
-            parameter->setValueNotifyingHost (static_cast<float> (ccValue) / 127.f);
-            parameter->endChangeGesture();
+            queue = pendingValue.set (static_cast<float> (ccValue) / 127.f);
         }
-        else if (parameterIndex == Processor::EnabledParameter || parameterIndex == Processor::BypassParameter || parameterIndex == Processor::MuteParameter)
+        else if (NodeToggle::isToggle (parameterIndex))
         {
             const auto currentToggleState = desiredToggleState.get();
             const auto mode = toggleMode.get();
@@ -311,36 +407,28 @@ struct MidiCCControllerMapHandler : public ControllerMapHandler,
             }
 
             if (currentToggleState != desiredToggleState.get())
-                triggerAsyncUpdate();
+            {
+                const int stateToCompare = mode != Control::toggleEquals
+                                               ? (inverseToggle.get() == 1 ? 0 : 1) // inverse on, then compare false
+                                               : 1; // equals mode always compare true
+                const bool on = desiredToggleState.get() == stateToCompare;
+                queue = pendingValue.set (NodeToggle::fromOn (parameterIndex, on) ? 1.f : 0.f);
+            }
         }
 
         lastControllerValue = ccValue;
+        return queue;
     }
 
-    void handleAsyncUpdate() override
+    void applyPendingValue() override
     {
-        const auto mode = toggleMode.get();
-        const int stateToCompare = mode != Control::toggleEquals
-                                       ? (inverseToggle.get() == 1 ? 0 : 1) // inverse on, then compare false
-                                       : 1; // equals mode always compare true
+        if (NodeToggle::apply (pendingValue, parameter.get(), *node, parameterIndex))
+            triggerAsyncUpdate();
+    }
 
-        if (parameterIndex == Processor::EnabledParameter)
-        {
-            node->setEnabled (desiredToggleState.get() == stateToCompare);
-            if (model.isEnabled() != node->isEnabled())
-                model.setProperty (tags::enabled, node->isEnabled());
-        }
-        else if (parameterIndex == Processor::BypassParameter)
-        {
-            // inverted because UI displays bypass as inactive (or active for not bypassed)
-            node->suspendProcessing (! (desiredToggleState.get() == stateToCompare));
-            if (model.isBypassed() != node->isSuspended())
-                model.setProperty (tags::bypass, node->isSuspended());
-        }
-        else if (parameterIndex == Processor::MuteParameter)
-        {
-            model.setMuted (desiredToggleState.get() == stateToCompare);
-        }
+    void handleAsyncUpdate() override
+    {
+        NodeToggle::sync (model, *node, parameterIndex);
     }
 
 private:
@@ -352,6 +440,7 @@ private:
     const int controllerNumber { -1 };
     const int parameterIndex { -1 };
     int lastControllerValue = 0;
+    PendingValue pendingValue;
 
     Value toggleValueObject;
     Atomic<int> toggleValue { 64 };
@@ -385,6 +474,96 @@ private:
         else if (channelObject.refersToSameSourceAs (value))
         {
             channel.set (jlimit (0, 16, (int) channelObject.getValue()));
+            routeChanged();
+        }
+    }
+};
+
+/** Maps a 14-bit controller or an NRPN. Parameters follow the full
+    resolution, toggles are on in the upper half of the range. */
+struct MidiHighResControllerMapHandler : public ControllerMapHandler,
+                                         public AsyncUpdater,
+                                         private Value::Listener
+{
+    MidiHighResControllerMapHandler (const Control& ctl,
+                                     const Node& _node,
+                                     const int _parameter)
+        : control (ctl),
+          model (_node),
+          node (_node.getObject()),
+          type (ctl.isNrpnEvent() ? Route::nrpn : Route::controller14),
+          number (jlimit (0, type == Route::nrpn ? 16383 : 31, ctl.getEventId())),
+          parameterIndex (_parameter)
+    {
+        jassert (node != nullptr);
+
+        channelObject = control.getPropertyAsValue (tags::midiChannel);
+        channelObject.addListener (this);
+        valueChanged (channelObject);
+
+        if (isPositiveAndBelow (parameterIndex, node->getParameters().size()))
+        {
+            parameter = node->getParameters()[parameterIndex];
+            jassert (nullptr != parameter);
+        }
+    }
+
+    ~MidiHighResControllerMapHandler()
+    {
+        channelObject.removeListener (this);
+    }
+
+    Route getRoute() const override { return { type, number, channel.get() }; }
+
+    bool perform (const MidiMessage&) override { return false; }
+
+    bool perform14 (int value) override
+    {
+        if (nullptr != parameter)
+            return pendingValue.set (static_cast<float> (value) / 16383.f);
+
+        if (! NodeToggle::isToggle (parameterIndex))
+            return false;
+
+        const int on = value >= 8192 ? 1 : 0;
+        if (desiredToggleState.exchange (on) == on)
+            return false;
+        return pendingValue.set (NodeToggle::fromOn (parameterIndex, on == 1) ? 1.f : 0.f);
+    }
+
+    void applyPendingValue() override
+    {
+        if (NodeToggle::apply (pendingValue, parameter.get(), *node, parameterIndex))
+            triggerAsyncUpdate();
+    }
+
+    void handleAsyncUpdate() override
+    {
+        NodeToggle::sync (model, *node, parameterIndex);
+    }
+
+private:
+    Control control;
+    Node model;
+    ProcessorPtr node { nullptr };
+    ParameterPtr parameter { nullptr };
+
+    const Route::Type type;
+    const int number;
+    const int parameterIndex;
+    PendingValue pendingValue;
+
+    Value channelObject;
+    Atomic<int> channel { 0 };
+
+    Atomic<int> desiredToggleState { -1 };
+
+    void valueChanged (Value& value) override
+    {
+        if (channelObject.refersToSameSourceAs (value))
+        {
+            channel.set (jlimit (0, 16, (int) channelObject.getValue()));
+            routeChanged();
         }
     }
 };
@@ -395,6 +574,7 @@ public:
     explicit ControllerMapInput (MappingEngine& owner, MidiEngine& m, const Controller& device)
         : midi (m), mapping (owner), controllerDevice (device)
     {
+        routes.reset (new Routes());
     }
 
     ~ControllerMapInput()
@@ -404,19 +584,19 @@ public:
 
     void handleIncomingMidiMessage (MidiInput*, const MidiMessage& message)
     {
-        if ((! message.isController() || ! controllerNumbers[message.getControllerNumber()]) && (! message.isNoteOnOrOff() || ! noteNumbers[message.getNoteNumber()]))
-            return;
+        const SpinLock::ScopedLockType sl (routesLock);
 
-        // DBG("[element] handle mapped MIDI: " << message.getControllerNumber()
-        //     << " : " << message.getControllerValue());
-        if (message.isNoteOn())
-            mapping.captureNextEvent (*this, notes[message.getNoteNumber()], message);
-        else if (message.isController())
-            mapping.captureNextEvent (*this, controls[message.getControllerNumber()], message);
-
-        for (auto* handler : handlers)
-            if (handler->wants (message))
-                handler->perform (message);
+        if (message.isController())
+        {
+            handleController (message);
+        }
+        else if (message.isNoteOnOrOff())
+        {
+            const auto number = message.getNoteNumber();
+            if (message.isNoteOn() && routes->noteControls[(size_t) number].isValid())
+                mapping.captureNextEvent (*this, routes->noteControls[(size_t) number], message);
+            dispatch (routes->notes, message.getChannel(), number, message);
+        }
     }
 
     bool close()
@@ -428,22 +608,7 @@ public:
     bool open()
     {
         close();
-
-        for (int i = controllerDevice.getNumControls(); --i >= 0;)
-        {
-            const auto control (controllerDevice.getControl (i));
-            const auto midi (control.getMidiMessage());
-            if (midi.isController())
-            {
-                controllerNumbers.setBit (midi.getControllerNumber(), true);
-                controls.set (midi.getControllerNumber(), control);
-            }
-            else if (midi.isNoteOn())
-            {
-                noteNumbers.setBit (midi.getNoteNumber(), true);
-                notes.set (midi.getNoteNumber(), control);
-            }
-        }
+        updateRoutes();
 
         const auto deviceId = controllerDevice.getInputDevice().toString();
         midi.addMidiInputCallback (deviceId, this, true);
@@ -475,17 +640,244 @@ public:
     {
         stop();
         handlers.add (handler);
+        handler->onRouteChanged = [this]() { updateRoutes(); };
+        resizePending();
         start();
     }
 
+    /** Apply values held back by handlers (audio thread). */
+    void applyPendingValues()
+    {
+        pendingFifo.read (pendingFifo.getNumReady()).forEach ([this] (int index) {
+            pending[index]->applyPendingValue();
+        });
+    }
+
 private:
     MidiEngine& midi;
     MappingEngine& mapping;
     Controller controllerDevice;
-    std::unique_ptr<MidiInput> midiInput;
     OwnedArray<ControllerMapHandler> handlers;
-    BigInteger controllerNumbers, noteNumbers;
-    HashMap<int, Control> controls, notes;
+
+    /** Handlers by channel and event number, rebuilt when the mappings
+        change so an event only visits the handlers which want it. Channel
+        0 holds the omni handlers. */
+    struct Routes
+    {
+        using Handlers = Array<ControllerMapHandler*>;
+        static constexpr int numChannels = 17;
+
+        static size_t slot (int channel, int number, int numNumbers) noexcept
+        {
+            return (size_t) (channel * numNumbers + number);
+        }
+
+        std::vector<Handlers> controllers = std::vector<Handlers> (numChannels * 128);
+        std::vector<Handlers> notes = std::vector<Handlers> (numChannels * 128);
+        std::vector<Handlers> controllers14 = std::vector<Handlers> (numChannels * 32);
+        std::unordered_map<int, Handlers> nrpns; // by slot (channel, parameter)
+
+        // controls for learning, by event number
+        std::array<Control, 128> controls, noteControls;
+        std::unordered_map<int, Control> nrpnControls;
+    };
+
+    SpinLock routesLock;
+    std::unique_ptr<Routes> routes;
+
+    /** 14-bit and NRPN parsing, by channel. Only the MIDI thread uses this. */
+    struct ChannelState
+    {
+        uint8 msb[32] = {};
+        uint32 sawLsb = 0; // bit per controller, a LSB means wait for it
+        int nrpnMsb = -1, nrpnLsb = -1;
+        int dataMsb = 0;
+        bool sawDataLsb = false;
+    };
+
+    std::array<ChannelState, 16> channels;
+
+    // handlers with a value for the audio thread. each is queued at most
+    // once, so this never holds more than there are handlers.
+    AbstractFifo pendingFifo { 1 };
+    HeapBlock<ControllerMapHandler*> pending { 1 };
+
+    void updateRoutes()
+    {
+        std::unique_ptr<Routes> newRoutes (new Routes());
+
+        for (int i = controllerDevice.getNumControls(); --i >= 0;)
+        {
+            const auto control (controllerDevice.getControl (i));
+            const auto number = control.getEventId();
+
+            if (control.isNrpnEvent())
+                newRoutes->nrpnControls[number] = control;
+            else if (! isPositiveAndBelow (number, 128))
+                continue;
+            else if (control.isControllerEvent() || control.isController14Event())
+                newRoutes->controls[(size_t) number] = control;
+            else if (control.isNoteEvent())
+                newRoutes->noteControls[(size_t) number] = control;
+        }
+
+        for (auto* handler : handlers)
+        {
+            const auto route = handler->getRoute();
+            const auto channel = jlimit (0, 16, route.channel);
+
+            switch (route.type)
+            {
+                case ControllerMapHandler::Route::controller:
+                    if (isPositiveAndBelow (route.number, 128))
+                        newRoutes->controllers[Routes::slot (channel, route.number, 128)].add (handler);
+                    break;
+                case ControllerMapHandler::Route::note:
+                    if (isPositiveAndBelow (route.number, 128))
+                        newRoutes->notes[Routes::slot (channel, route.number, 128)].add (handler);
+                    break;
+                case ControllerMapHandler::Route::controller14:
+                    if (isPositiveAndBelow (route.number, 32))
+                        newRoutes->controllers14[Routes::slot (channel, route.number, 32)].add (handler);
+                    break;
+                case ControllerMapHandler::Route::nrpn:
+                    newRoutes->nrpns[(int) Routes::slot (channel, route.number, 16384)].add (handler);
+                    break;
+            }
+        }
+
+        {
+            const SpinLock::ScopedLockType sl (routesLock);
+            routes.swap (newRoutes);
+        }
+    }
+
+    /** Call with the input stopped and the engine's change lock held. */
+    void resizePending()
+    {
+        // keep what's queued, those handlers won't queue themselves again
+        Array<ControllerMapHandler*> queued;
+        pendingFifo.read (pendingFifo.getNumReady()).forEach ([this, &queued] (int index) {
+            queued.add (pending[index]);
+        });
+
+        pending.realloc ((size_t) handlers.size() + 1);
+        pendingFifo.setTotalSize (handlers.size() + 1);
+
+        for (auto* handler : queued)
+            queue (handler);
+    }
+
+    void queue (ControllerMapHandler* handler) noexcept
+    {
+        pendingFifo.write (1).forEach ([this, handler] (int index) {
+            pending[index] = handler;
+        });
+    }
+
+    void dispatch (const std::vector<Routes::Handlers>& slots, int channel, int number, const MidiMessage& message)
+    {
+        const auto numNumbers = (int) slots.size() / Routes::numChannels;
+        for (auto* handler : slots[Routes::slot (0, number, numNumbers)])
+            if (handler->perform (message))
+                queue (handler);
+        for (auto* handler : slots[Routes::slot (channel, number, numNumbers)])
+            if (handler->perform (message))
+                queue (handler);
+    }
+
+    void dispatch14 (const Routes::Handlers& handlers14, int value)
+    {
+        for (auto* handler : handlers14)
+            if (handler->perform14 (value))
+                queue (handler);
+    }
+
+    void dispatchNrpn (int channel, int parameter, int value)
+    {
+        for (const auto ch : { 0, channel })
+        {
+            auto iter = routes->nrpns.find ((int) Routes::slot (ch, parameter, 16384));
+            if (iter != routes->nrpns.end())
+                dispatch14 (iter->second, value);
+        }
+    }
+
+    void handleController (const MidiMessage& message)
+    {
+        const auto channel = message.getChannel();
+        const auto number = message.getControllerNumber();
+        const auto value = message.getControllerValue();
+        auto& state = channels[(size_t) channel - 1];
+
+        if (routes->controls[(size_t) number].isValid())
+            mapping.captureNextEvent (*this, routes->controls[(size_t) number], message);
+
+        dispatch (routes->controllers, channel, number, message);
+
+        if (number < 32)
+        {
+            // senders without a LSB are followed at 7 bits
+            state.msb[number] = (uint8) value;
+            if ((state.sawLsb & (1u << number)) == 0)
+            {
+                dispatch14 (routes->controllers14[Routes::slot (0, number, 32)], value << 7);
+                dispatch14 (routes->controllers14[Routes::slot (channel, number, 32)], value << 7);
+            }
+        }
+        else if (number < 64)
+        {
+            const auto msbNumber = number - 32;
+            state.sawLsb |= 1u << msbNumber;
+            const auto value14 = (state.msb[msbNumber] << 7) | value;
+            dispatch14 (routes->controllers14[Routes::slot (0, msbNumber, 32)], value14);
+            dispatch14 (routes->controllers14[Routes::slot (channel, msbNumber, 32)], value14);
+        }
+
+        switch (number)
+        {
+            case 99:
+                state.nrpnMsb = value;
+                state.sawDataLsb = false;
+                break;
+            case 98:
+                state.nrpnLsb = value;
+                state.sawDataLsb = false;
+                break;
+            case 101:
+            case 100:
+                // an RPN was selected, data entry isn't for us
+                state.nrpnMsb = state.nrpnLsb = -1;
+                break;
+            case 6:
+            case 38: {
+                if (state.nrpnMsb < 0 || state.nrpnLsb < 0)
+                    break;
+
+                const auto parameter = (state.nrpnMsb << 7) | state.nrpnLsb;
+                if (number == 6)
+                {
+                    state.dataMsb = value;
+                    if (state.sawDataLsb)
+                        break;
+                }
+                else
+                {
+                    state.sawDataLsb = true;
+                }
+
+                const auto value14 = (state.dataMsb << 7) | (number == 38 ? value : 0);
+                auto control = routes->nrpnControls.find (parameter);
+                if (control != routes->nrpnControls.end())
+                    mapping.captureNextEvent (*this, control->second, message);
+                dispatchNrpn (channel, parameter, value14);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ControllerMapInput)
 };
 
@@ -578,6 +970,7 @@ MappingEngine::MappingEngine()
 
 MappingEngine::~MappingEngine()
 {
+    const ScopedLock sl (changesLock);
     inputs->clear();
     inputs = nullptr;
 }
@@ -591,6 +984,7 @@ bool MappingEngine::addInput (const Controller& controller, MidiEngine& midi)
     input.reset (new ControllerMapInput (*this, midi, controller));
 
     DBG ("[element] MappingEngine: added input handler for controller: " << controller.getName().toString());
+    const ScopedLock sl (changesLock);
     return inputs->add (input.release());
 }
 
@@ -610,13 +1004,16 @@ bool MappingEngine::addHandler (const Control& control,
             const auto message (control.getMidiMessage());
             std::unique_ptr<ControllerMapHandler> handler;
 
-            if (message.isController())
+            if (control.isController14Event() || control.isNrpnEvent())
+                handler.reset (new MidiHighResControllerMapHandler (control, node, parameter));
+            else if (message.isController())
                 handler.reset (new MidiCCControllerMapHandler (control, message, node, parameter));
             else if (message.isNoteOn())
                 handler.reset (new MidiNoteControllerMap (control, message, node, parameter));
 
             if (nullptr != handler)
             {
+                const ScopedLock sl (changesLock);
                 input->addHandler (handler.release());
                 return true;
             }
@@ -629,6 +1026,7 @@ bool MappingEngine::removeInput (const Controller& controller)
 {
     if (! inputs->containsInputFor (controller))
         return true;
+    const ScopedLock sl (changesLock);
     return inputs->remove (controller);
 }
 
@@ -650,9 +1048,20 @@ bool MappingEngine::refreshInput (const Controller& device)
 void MappingEngine::clear()
 {
     stopMapping();
+    const ScopedLock sl (changesLock);
     inputs->clear();
 }
 
+void MappingEngine::applyPendingChanges()
+{
+    const ScopedTryLock sl (changesLock);
+    if (! sl.isLocked())
+        return; // mappings are changing, values wait for the next block
+
+    for (auto* input : *inputs)
+        input->applyPendingValues();
+}
+
 void MappingEngine::startMapping()
 {
     stopMapping();
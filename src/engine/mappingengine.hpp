@@ -32,6 +32,12 @@ public:
     void startMapping();
     void stopMapping();
 
+    /** Apply the latest value of every mapped parameter, enable, bypass or
+        mute which moved since the last call (audio thread). A burst of
+        controller events is applied once per block, and doesn't wait on
+        the message thread. */
+    void applyPendingChanges();
+
     void capture (const bool start = true) { capturedEvent.capture.set (start); }
     MidiMessage getCapturedMidiMessage() const { return capturedEvent.message; }
     Control getCapturedControl() const { return capturedEvent.control; }
@@ -41,6 +47,7 @@ private:
     friend class ControllerMapInput;
     class Inputs;
     std::unique_ptr<Inputs> inputs;
+    CriticalSection changesLock; // held while inputs or handlers change
 
     class CapturedEvent : public AsyncUpdater
     {
@@ -57,7 +57,7 @@ void MidiEngine::writeSettings (Settings& settings)
         ValueTree input (tags::input);
         input.setProperty (tags::name, holder->input->getName(), nullptr)
             .setProperty (tags::identifier, holder->input->getIdentifier(), nullptr)
-            .setProperty (tags::active, holder->active, nullptr);
+            .setProperty (tags::active, holder->active.load(), nullptr);
         data.appendChild (input, nullptr);
     }
 
@@ -155,10 +155,11 @@ void MidiEngine::MidiInputHolder::handleIncomingMidiMessage (MidiInput* source,
         return;
 
     jassert (source == input.get());
-    const ScopedLock sl (engine.midiCallbackLock);
+    const bool isActive = active.load (std::memory_order_relaxed);
+    const ScopedLock sl (lock);
 
-    for (auto& mc : engine.midiCallbacks)
-        if ((active || mc.consumer) && (mc.device.isEmpty() || mc.device == input->getIdentifier()))
+    for (auto& mc : callbacks)
+        if (isActive || mc.consumer)
             mc.callback->handleIncomingMidiMessage (input.get(), message);
 }
 
@@ -205,8 +206,10 @@ MidiEngine::MidiInputHolder* MidiEngine::getMidiInput (const String& identifier,
         if (auto midiIn = MidiInput::openDevice (identifier, holder.get()))
         {
             holder->input.reset (midiIn.release());
-            holder->input->start();
-            return openMidiInputs.add (holder.release());
+            auto* const opened = openMidiInputs.add (holder.release());
+            updateInputCallbacks();
+            opened->input->start();
+            return opened;
         }
     }
 
@@ -271,8 +274,12 @@ void MidiEngine::addMidiInputCallback (const MidiDeviceInfo& device, MidiInputCa
         mc.callback = callbackToAdd;
         mc.consumer = consumer;
 
-        const ScopedLock sl (midiCallbackLock);
-        midiCallbacks.add (mc);
+        {
+            const ScopedLock sl (midiCallbackLock);
+            midiCallbacks.add (mc);
+        }
+
+        updateInputCallbacks();
     }
 }
 
@@ -288,6 +295,8 @@ void MidiEngine::removeMidiInputCallback (const MidiDeviceInfo& device, MidiInpu
             midiCallbacks.remove (i);
         }
     }
+
+    updateInputCallbacks();
 }
 
 void MidiEngine::removeMidiInputCallback (MidiInputCallback* callbackToRemove)
@@ -302,6 +311,28 @@ void MidiEngine::removeMidiInputCallback (MidiInputCallback* callbackToRemove)
             midiCallbacks.remove (i);
         }
     }
+
+    updateInputCallbacks();
+}
+
+void MidiEngine::updateInputCallbacks()
+{
+    for (auto* const holder : openMidiInputs)
+    {
+        if (holder->input == nullptr)
+            continue;
+
+        Array<MidiCallbackInfo> wanted;
+        {
+            const ScopedLock sl (midiCallbackLock);
+            for (const auto& mc : midiCallbacks)
+                if (mc.device.isEmpty() || mc.device == holder->input->getIdentifier())
+                    wanted.add (mc);
+        }
+
+        const ScopedLock sl (holder->lock);
+        holder->callbacks.swapWith (wanted);
+    }
 }
 
 void MidiEngine::handleIncomingMidiMessageInt (MidiInput* source, const MidiMessage& message)
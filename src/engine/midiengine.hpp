@@ -123,12 +123,19 @@ private:
             : engine (e) {}
 
         std::unique_ptr<MidiInput> input;
-        bool active = false; // if true, then will feed to audio engine
+        std::atomic<bool> active { false }; // if true, then will feed to audio engine
 
         void handleIncomingMidiMessage (MidiInput* source, const MidiMessage& message) override;
 
     private:
+        friend class MidiEngine;
         MidiEngine& engine;
+
+        // callbacks wanting this device. only this device's thread and
+        // updateInputCallbacks take the lock, so devices don't wait on
+        // each other.
+        CriticalSection lock;
+        Array<MidiCallbackInfo> callbacks;
     };
 
     StringArray midiInsFromXml;
@@ -143,6 +150,7 @@ private:
     std::unique_ptr<CallbackHandler> callbackHandler;
 
     MidiInputHolder* getMidiInput (const String& identifier, bool openIfNotAlready);
+    void updateInputCallbacks();
     void handleIncomingMidiMessageInt (juce::MidiInput*, const juce::MidiMessage&);
 };
 
@@ -0,0 +1,159 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+#include <cmath>
+
+#include <element/juce/audio_basics.hpp>
+
+#include "delaylockedloop.hpp"
+
+namespace element {
+
+/** Carries MIDI from device threads to the audio thread without locking.
+
+    Any number of device threads push, only the audio thread reads. Events
+    keep the device timestamp and are placed in the block by where they
+    fall in the previous audio period, measured against a delay-locked loop
+    following the audio callbacks. That costs one period of latency, the
+    same as juce::MidiMessageCollector, but the offsets follow the smoothed
+    period instead of the jittery callback times.
+ */
+class MidiInputQueue final
+{
+public:
+    /** Bytes a message can have and still be queued. Longer SysEx is
+        rejected by push so the caller can deliver it another way. */
+    static constexpr int maxMessageSize = 44;
+
+    explicit MidiInputQueue (int capacity = 2048)
+    {
+        const auto size = (size_t) juce::nextPowerOfTwo (juce::jmax (2, capacity));
+        cells.reset (new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; ++i)
+            cells[i].sequence.store (i, std::memory_order_relaxed);
+    }
+
+    /** Returns the timestamp clock, in seconds, used by MIDI devices. */
+    static double now() noexcept { return juce::Time::getMillisecondCounterHiRes() * 0.001; }
+
+    /** Queue a message (device threads). The message's timestamp should be
+        in seconds on the same clock as now(). Returns false if the message
+        is too long or the queue is full. */
+    bool push (const juce::MidiMessage& message) noexcept
+    {
+        const auto size = message.getRawDataSize();
+        if (size <= 0 || size > maxMessageSize)
+            return false;
+
+        auto pos = writePos.load (std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        for (;;)
+        {
+            cell = &cells[pos & mask];
+            const auto seq = cell->sequence.load (std::memory_order_acquire);
+            const auto diff = (std::ptrdiff_t) seq - (std::ptrdiff_t) pos;
+            if (diff == 0)
+            {
+                if (writePos.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                pos = writePos.load (std::memory_order_relaxed);
+            }
+        }
+
+        cell->time = message.getTimeStamp();
+        cell->size = (juce::uint16) size;
+        std::memcpy (cell->data, message.getRawData(), (size_t) size);
+        cell->sequence.store (pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Prepare for playback (audio thread, or with the audio callback stopped). */
+    void prepare (double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+        blockSize = 0; // resync on the next block
+    }
+
+    /** Move the events which arrived during the last period into a block
+        (audio thread). Call once per block with the time the callback
+        started; events newer than that stay queued for the next block. */
+    void render (juce::MidiBuffer& midi, int numSamples, double callbackTime) noexcept
+    {
+        if (numSamples <= 0 || sampleRate <= 0.0)
+            return;
+
+        const double period = (double) numSamples / sampleRate;
+
+        // first block, the device changed its period, or the loop lost
+        // track after a dropout
+        if (numSamples != blockSize || std::abs (callbackTime - periodEnd) > period * 4.0)
+        {
+            blockSize = numSamples;
+            dll.reset (callbackTime, (double) blockSize, sampleRate);
+            dll.setParams (dllBandwidth, 1.0 / period);
+            periodEnd = dll.time();
+            periodStart = periodEnd - period;
+        }
+        else
+        {
+            periodStart = periodEnd;
+            dll.update (callbackTime);
+            periodEnd = dll.time();
+        }
+
+        const double scale = (double) numSamples / juce::jmax (1.0e-9, periodEnd - periodStart);
+
+        for (;;)
+        {
+            auto& cell = cells[readPos & mask];
+            if (cell.sequence.load (std::memory_order_acquire) != readPos + 1)
+                break; // empty
+
+            // belongs to the next period. anything far ahead has a bad
+            // timestamp and goes out now rather than holding up the queue.
+            if (cell.time >= periodEnd && cell.time < periodEnd + 1.0)
+                break;
+
+            const auto offset = juce::jlimit (0, numSamples - 1, (int) ((cell.time - periodStart) * scale));
+            midi.addEvent (cell.data, (int) cell.size, offset);
+            cell.sequence.store (readPos + mask + 1, std::memory_order_release);
+            ++readPos;
+        }
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence { 0 };
+        double time = 0.0;
+        juce::uint16 size = 0;
+        juce::uint8 data[maxMessageSize] = {};
+    };
+
+    static constexpr double dllBandwidth = 1.0;
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+    alignas (64) std::atomic<size_t> writePos { 0 };
+    alignas (64) size_t readPos = 0;
+
+    DelayLockedLoop dll;
+    double sampleRate = 0.0;
+    int blockSize = 0;
+    double periodStart = 0.0, periodEnd = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE (MidiInputQueue)
+};
+
+} // namespace element
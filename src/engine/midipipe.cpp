@@ -90,6 +90,29 @@ void MidiPipe::clear (int channel, int startSample, int numSamples)
         buffer->clear (startSample, numSamples);
 }
 
+void MidiPipe::scaleTimestamps (int multiplier, int divisor) noexcept
+{
+    for (int i = 0; i < size; ++i)
+        scaleTimestamps (*referencedBuffers[i], multiplier, divisor);
+}
+
+void MidiPipe::scaleTimestamps (MidiBuffer& buffer, int multiplier, int divisor) noexcept
+{
+    jassert (multiplier > 0 && divisor > 0);
+    if (multiplier == divisor)
+        return;
+
+    // events are stored as { int32 time, uint16 size, data[size] }
+    auto* d = buffer.data.begin();
+    auto* const end = buffer.data.end();
+    while (d < end)
+    {
+        const auto time = (int64) readUnaligned<int32> (d);
+        writeUnaligned<int32> (d, (int32) (time * multiplier / divisor));
+        d += sizeof (int32) + sizeof (uint16) + readUnaligned<uint16> (d + sizeof (int32));
+    }
+}
+
 LuaMidiPipe::LuaMidiPipe() {}
 LuaMidiPipe::~LuaMidiPipe()
 {
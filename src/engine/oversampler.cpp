@@ -32,15 +32,21 @@ template <typename T>
 void Oversampler<T>::prepare (int numChannels, int blockSize)
 {
     numChannels = juce::jmax (1, numChannels);
-    const bool procSpecChanged = channels != numChannels || buffer != blockSize;
+    const bool procSpecChanged = channels != numChannels || buffer != blockSize || preparedQuality != quality;
     channels = numChannels;
     buffer = blockSize;
+    preparedQuality = quality;
 
     if (processors.size() <= 0 || procSpecChanged)
     {
+        const auto filter = quality == lowLatency ? ProcessorType::FilterType::filterHalfBandPolyphaseIIR
+                                                  : ProcessorType::FilterType::filterHalfBandFIREquiripple;
+        const bool steep = quality != linearPhase;
+
+        // integer latency lets graphs compensate it exactly
         processors.clear();
         for (int f = 0; f < maxProc; ++f)
-            processors.add (new ProcessorType (channels, f + 1, ProcessorType::FilterType::filterHalfBandPolyphaseIIR));
+            processors.add (new ProcessorType (channels, f + 1, filter, steep, true));
     }
 
     for (auto* proc : processors)
@@ -0,0 +1,385 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <thread>
+#include <unordered_map>
+
+#include <element/atombuffer.hpp>
+
+#include "engine/graphbuilder.hpp"
+#include "engine/parallelrender.hpp"
+
+namespace element {
+
+//==============================================================================
+/** Bounded lock-free multi-producer/multi-consumer queue of task indexes.
+    Based on Dmitry Vyukov's bounded MPMC queue. Each task is pushed at most
+    once per block, so a capacity of the number of tasks is always enough.
+ */
+class RenderSchedule::TaskQueue final
+{
+public:
+    explicit TaskQueue (int minCapacity)
+    {
+        size_t capacity = 2;
+        while (capacity < (size_t) minCapacity)
+            capacity <<= 1;
+
+        mask = capacity - 1;
+        cells.reset (new Cell[capacity]);
+        for (size_t i = 0; i < capacity; ++i)
+            cells[i].sequence.store (i, std::memory_order_relaxed);
+    }
+
+    bool push (int value) noexcept
+    {
+        Cell* cell = nullptr;
+        size_t pos = enqueuePos.load (std::memory_order_relaxed);
+
+        for (;;)
+        {
+            cell = &cells[pos & mask];
+            const auto seq = cell->sequence.load (std::memory_order_acquire);
+            const auto diff = (intptr_t) seq - (intptr_t) pos;
+
+            if (diff == 0)
+            {
+                if (enqueuePos.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = enqueuePos.load (std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = value;
+        cell->sequence.store (pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop (int& value) noexcept
+    {
+        Cell* cell = nullptr;
+        size_t pos = dequeuePos.load (std::memory_order_relaxed);
+
+        for (;;)
+        {
+            cell = &cells[pos & mask];
+            const auto seq = cell->sequence.load (std::memory_order_acquire);
+            const auto diff = (intptr_t) seq - (intptr_t) (pos + 1);
+
+            if (diff == 0)
+            {
+                if (dequeuePos.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = dequeuePos.load (std::memory_order_relaxed);
+            }
+        }
+
+        value = cell->value;
+        cell->sequence.store (pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence { 0 };
+        int value = -1;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+    alignas (64) std::atomic<size_t> enqueuePos { 0 };
+    alignas (64) std::atomic<size_t> dequeuePos { 0 };
+};
+
+//==============================================================================
+RenderSchedule::RenderSchedule (const Array<void*>& ops_, const Array<int>& nodeOpEnds)
+    : ops (ops_)
+{
+    struct Usage
+    {
+        int writer = -1;
+        Array<int> readers;
+    };
+
+    std::unordered_map<int, Usage> usage;
+    Array<SortedSet<int>> dependencies;
+    int begin = 0;
+
+    for (const auto end : nodeOpEnds)
+    {
+        if (end <= begin)
+            continue;
+
+        BufferAccess access;
+        for (int i = begin; i < end; ++i)
+            static_cast<GraphOp*> (ops.getUnchecked (i))->getBufferAccess (access);
+
+        // a buffer both read and written by a task is treated as written
+        for (const auto key : access.writes)
+            access.reads.removeFirstMatchingValue (key);
+
+        const int index = tasks.size();
+        Task task;
+        task.begin = begin;
+        task.end = end;
+        tasks.add (task);
+
+        SortedSet<int> deps;
+
+        for (const auto key : access.reads)
+        {
+            auto& u = usage[key];
+            if (u.writer >= 0)
+                deps.add (u.writer);
+            u.readers.add (index);
+        }
+
+        for (const auto key : access.writes)
+        {
+            auto& u = usage[key];
+            if (u.writer >= 0)
+                deps.add (u.writer);
+            for (const auto reader : u.readers)
+                if (reader != index)
+                    deps.add (reader);
+            u.writer = index;
+            u.readers.clearQuick();
+        }
+
+        dependencies.add (deps);
+        begin = end;
+    }
+
+    // invert the dependency lists so finished tasks can trigger their dependents
+    Array<Array<int>> outgoing;
+    outgoing.resize (tasks.size());
+    for (int i = 0; i < tasks.size(); ++i)
+    {
+        tasks.getReference (i).numDependencies = dependencies.getReference (i).size();
+        for (const auto dep : dependencies.getReference (i))
+            outgoing.getReference (dep).add (i);
+        if (dependencies.getReference (i).isEmpty())
+            roots.add (i);
+    }
+
+    for (int i = 0; i < tasks.size(); ++i)
+    {
+        auto& task = tasks.getReference (i);
+        task.firstDependent = dependents.size();
+        task.numDependents = outgoing.getReference (i).size();
+        dependents.addArray (outgoing.getReference (i));
+    }
+
+    pending.reset (new std::atomic<int>[(size_t) jmax (1, tasks.size())]);
+    ready = std::make_unique<TaskQueue> (tasks.size());
+}
+
+RenderSchedule::~RenderSchedule() {}
+
+void RenderSchedule::begin (AudioSampleBuffer& audioBuffers,
+                            const OwnedArray<MidiBuffer>& midiBuffers,
+                            const OwnedArray<AtomBuffer>& atomBuffers,
+                            int nframes)
+{
+    audio = &audioBuffers;
+    midi = &midiBuffers;
+    atom = &atomBuffers;
+    numSamples = nframes;
+
+    for (int i = tasks.size(); --i >= 0;)
+        pending[(size_t) i].store (tasks.getReference (i).numDependencies, std::memory_order_relaxed);
+    remaining.store (tasks.size(), std::memory_order_release);
+
+    for (const auto root : roots)
+        ready->push (root);
+}
+
+bool RenderSchedule::processNextTask (Semaphore& wakeup)
+{
+    int index = -1;
+    if (! ready->pop (index))
+        return false;
+
+    while (index >= 0)
+    {
+        const auto& task = tasks.getReference (index);
+        for (int i = task.begin; i < task.end; ++i)
+            static_cast<GraphOp*> (ops.getUnchecked (i))->perform (*audio, *midi, *atom, numSamples);
+
+        // keep the first dependent that becomes ready for this thread and
+        // hand the rest to the pool.
+        int next = -1;
+        for (int i = 0; i < task.numDependents; ++i)
+        {
+            const int dependent = dependents.getUnchecked (task.firstDependent + i);
+            if (pending[(size_t) dependent].fetch_sub (1, std::memory_order_acq_rel) != 1)
+                continue;
+
+            if (next < 0)
+            {
+                next = dependent;
+            }
+            else
+            {
+                ready->push (dependent);
+                wakeup.post();
+            }
+        }
+
+        remaining.fetch_sub (1, std::memory_order_acq_rel);
+        index = next;
+    }
+
+    return true;
+}
+
+//==============================================================================
+class RenderPool::Worker : public Thread
+{
+public:
+    Worker (RenderPool& p, int index)
+        : Thread ("element: render " + String (index + 1)),
+          pool (p) {}
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            pool.wakeup.wait();
+            if (threadShouldExit())
+                break;
+            pool.work();
+        }
+    }
+
+private:
+    RenderPool& pool;
+};
+
+RenderPool::RenderPool() {}
+
+RenderPool::~RenderPool()
+{
+    stop();
+}
+
+int RenderPool::getDefaultNumWorkers()
+{
+    return jmax (1, SystemStats::getNumPhysicalCpus() - 1);
+}
+
+void RenderPool::start (int numWorkers)
+{
+    if (workers.size() > 0)
+        return;
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto worker = workers.add (new Worker (*this, i));
+        if (! worker->startRealtimeThread (Thread::RealtimeOptions {}))
+            worker->startThread (Thread::Priority::highest);
+    }
+}
+
+void RenderPool::stop()
+{
+    for (const auto& slot : slots)
+        jassert (! slot.claimed.load());
+
+    for (auto* worker : workers)
+        worker->signalThreadShouldExit();
+    for (int i = workers.size(); --i >= 0;)
+        wakeup.post();
+    for (auto* worker : workers)
+        worker->stopThread (1000);
+
+    workers.clear();
+}
+
+bool RenderPool::help (const Slot* skip)
+{
+    bool didSomething = false;
+
+    for (auto& slot : slots)
+    {
+        if (&slot == skip)
+            continue;
+
+        // Register before looking at the schedule, perform() waits for
+        // busy helpers before letting the schedule go.
+        slot.numBusy.fetch_add (1);
+        if (auto* schedule = slot.schedule.load())
+            while (schedule->processNextTask (wakeup))
+                didSomething = true;
+        slot.numBusy.fetch_sub (1);
+    }
+
+    return didSomething;
+}
+
+void RenderPool::work()
+{
+    ScopedNoDenormals denormals;
+    while (help (nullptr))
+        continue;
+}
+
+bool RenderPool::perform (RenderSchedule& schedule,
+                          AudioSampleBuffer& audio,
+                          const OwnedArray<MidiBuffer>& midi,
+                          const OwnedArray<AtomBuffer>& atom,
+                          int numSamples)
+{
+    if (workers.isEmpty())
+        return false;
+
+    Slot* slot = nullptr;
+    for (auto& s : slots)
+    {
+        bool expected = false;
+        if (s.claimed.compare_exchange_strong (expected, true))
+        {
+            slot = &s;
+            break;
+        }
+    }
+
+    if (slot == nullptr)
+        return false;
+
+    schedule.begin (audio, midi, atom, numSamples);
+    slot->schedule.store (&schedule);
+
+    for (int i = jmin (workers.size(), schedule.getNumRootTasks() - 1); --i >= 0;)
+        wakeup.post();
+
+    // while waiting on tasks other threads are running, help with nested
+    // schedules instead of spinning. They may be what's holding this one up.
+    while (! schedule.isFinished())
+        if (! schedule.processNextTask (wakeup) && ! help (slot))
+            std::this_thread::yield();
+
+    slot->schedule.store (nullptr);
+    while (slot->numBusy.load() > 0)
+        std::this_thread::yield();
+
+    slot->claimed.store (false);
+    return true;
+}
+
+} // namespace element
@@ -0,0 +1,134 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include "ElementApp.h"
+#include "semaphore.hpp"
+
+namespace element {
+
+class AtomBuffer;
+class RenderPool;
+
+/** A dependency graph of rendering ops.
+
+    Ops are grouped in to one task per rendered node. A task depends on every
+    earlier task that touches the same shared buffers in a conflicting way, so
+    tasks without a path between them can run at the same time. Built on the
+    message thread, performed by a RenderPool on the audio thread.
+ */
+class RenderSchedule final
+{
+public:
+    /** Create a schedule.
+
+        @param ops          The ops to render. These are not owned.
+        @param nodeOpEnds   End index in ops for each rendered node.
+        @see GraphBuilder::getNodeOpEnds
+     */
+    RenderSchedule (const Array<void*>& ops, const Array<int>& nodeOpEnds);
+    ~RenderSchedule();
+
+    /** Returns the number of tasks in this schedule. */
+    int getNumTasks() const noexcept { return tasks.size(); }
+
+    /** Returns the number of tasks which can start right away. */
+    int getNumRootTasks() const noexcept { return roots.size(); }
+
+private:
+    friend class RenderPool;
+
+    struct Task
+    {
+        int begin = 0, end = 0;
+        int numDependencies = 0;
+        int firstDependent = 0, numDependents = 0;
+    };
+
+    class TaskQueue;
+
+    Array<void*> ops;
+    Array<Task> tasks;
+    Array<int> dependents;
+    Array<int> roots;
+    std::unique_ptr<std::atomic<int>[]> pending;
+    std::atomic<int> remaining { 0 };
+    std::unique_ptr<TaskQueue> ready;
+
+    AudioSampleBuffer* audio = nullptr;
+    const OwnedArray<MidiBuffer>* midi = nullptr;
+    const OwnedArray<AtomBuffer>* atom = nullptr;
+    int numSamples = 0;
+
+    void begin (AudioSampleBuffer&, const OwnedArray<MidiBuffer>&, const OwnedArray<AtomBuffer>&, int);
+    bool processNextTask (Semaphore& wakeup);
+    bool isFinished() const noexcept { return remaining.load (std::memory_order_acquire) <= 0; }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderSchedule)
+};
+
+/** A pool of realtime threads which help the audio thread perform
+    RenderSchedules. One instance is shared by all graphs.
+
+    Schedules can nest: a task which renders a graph may perform that graph's
+    schedule while the outer one is still running. Each running schedule
+    takes a slot, and idle workers and waiting performers take tasks from
+    whichever slot has some ready.
+ */
+class RenderPool final
+{
+public:
+    RenderPool();
+    ~RenderPool();
+
+    /** Returns a sensible number of workers for this machine. */
+    static int getDefaultNumWorkers();
+
+    /** Start the worker threads if not already running. */
+    void start (int numWorkers);
+
+    /** Stop all worker threads. */
+    void stop();
+
+    /** Returns the number of running workers. */
+    int getNumWorkers() const noexcept { return workers.size(); }
+
+    /** Perform a schedule with the help of the workers. This does not
+        allocate or lock and returns when every task has been rendered. It
+        may be called from inside a task of another schedule.
+
+        Returns false without rendering anything if there are no workers or
+        every slot is taken. The caller should then render the ops one after
+        the other.
+     */
+    bool perform (RenderSchedule& schedule,
+                  AudioSampleBuffer& audio,
+                  const OwnedArray<MidiBuffer>& midi,
+                  const OwnedArray<AtomBuffer>& atom,
+                  int numSamples);
+
+private:
+    class Worker;
+    OwnedArray<Worker> workers;
+    Semaphore wakeup;
+
+    struct Slot
+    {
+        std::atomic<bool> claimed { false };
+        std::atomic<RenderSchedule*> schedule { nullptr };
+        std::atomic<int> numBusy { 0 };
+    };
+
+    static constexpr int maxSchedules = 16;
+    Slot slots[maxSchedules];
+
+    void work();
+    bool help (const Slot* skip);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderPool)
+};
+
+} // namespace element
@@ -14,6 +14,7 @@
 #include "nodes/mididevice.hpp"
 #include "nodes/placeholder.hpp"
 #include "engine/rootgraph.hpp"
+#include "session/sessionfile.hpp"
 
 namespace element {
 
@@ -21,6 +22,7 @@ Processor::Processor (const PortList& portList)
     : nodeId (0),
       isPrepared (false),
       enablement (*this),
+      stateNotifier (*this),
       midiProgramLoader (*this),
       portResetter (*this)
 {
@@ -38,6 +40,7 @@ Processor::Processor (const uint32 nodeId_) noexcept
     : nodeId (nodeId_),
       isPrepared (false),
       enablement (*this),
+      stateNotifier (*this),
       midiProgramLoader (*this),
       portResetter (*this)
 {
@@ -195,6 +198,19 @@ bool Processor::isMidiDeviceNode() const
 int Processor::getNumAudioInputs() const { return ports.size (PortType::Audio, true); }
 int Processor::getNumAudioOutputs() const { return ports.size (PortType::Audio, false); }
 
+void Processor::unsubscribeFromLevels() noexcept
+{
+    jassert (levelSubscribers.get() > 0);
+    if (--levelSubscribers > 0)
+        return;
+
+    // don't leave stale levels for the next meter
+    for (auto* rms : inRMS)
+        rms->set (0.f);
+    for (auto* rms : outRMS)
+        rms->set (0.f);
+}
+
 void Processor::setInputRMS (int chan, float val)
 {
     if (chan < inRMS.size())
@@ -217,6 +233,18 @@ void Processor::suspendProcessing (const bool shouldBeSuspended)
     const bool wasSuspeneded = isSuspended();
     const int iShouldBeSuspended = static_cast<int> (shouldBeSuspended);
 
+    if (! MessageManager::getInstance()->isThisTheMessageThread())
+    {
+        // rendering reads the flag, the plugin and listeners follow later
+        if (bypassed.get() != iShouldBeSuspended)
+        {
+            bypassed.set (iShouldBeSuspended);
+            stateNotifier.bypass.set (1);
+            stateNotifier.triggerAsyncUpdate();
+        }
+        return;
+    }
+
     if (auto* proc = getAudioProcessor())
     {
         if (wasSuspeneded != shouldBeSuspended)
@@ -309,6 +337,7 @@ void Processor::prepare (const double newSampleRate,
     sampleRate = newSampleRate;
     blockSize = newBlockSize;
     parent = parentGraph;
+    updateSilenceTail();
 
     if ((willBeEnabled || enabled.get() == 1) && ! isPrepared)
     {
@@ -359,16 +388,29 @@ void Processor::unprepare()
 
 void Processor::setEnabled (const bool shouldBeEnabled)
 {
-    if (shouldBeEnabled == isEnabled())
-        return;
+    enablement.requested.set (shouldBeEnabled ? 1 : 0);
 
     if (! MessageManager::getInstance()->isThisTheMessageThread())
     {
-        enablement.cancelPendingUpdate();
+        // stop rendering from the next block. preparing and releasing the
+        // plugin can't happen here, the message thread finishes it.
+        if (! shouldBeEnabled)
+            enabled.set (0);
         enablement.triggerAsyncUpdate();
         return;
     }
 
+    enablement.cancelPendingUpdate();
+    applyEnablement();
+}
+
+void Processor::applyEnablement()
+{
+    const bool shouldBeEnabled = enablement.requested.get() == 1;
+    const bool wasEnabled = enablement.applied;
+    if (shouldBeEnabled == wasEnabled && shouldBeEnabled == isEnabled())
+        return;
+
     if (shouldBeEnabled)
     {
         if (parent)
@@ -387,12 +429,28 @@ void Processor::setEnabled (const bool shouldBeEnabled)
         unprepare();
     }
 
-    enablementChanged (this);
+    enablement.applied = isEnabled();
+    if (enablement.applied != wasEnabled)
+        enablementChanged (this);
 }
 
 void Processor::EnablementUpdater::handleAsyncUpdate()
 {
-    graph.setEnabled (! graph.isEnabled());
+    graph.applyEnablement();
+}
+
+void Processor::StateNotifier::handleAsyncUpdate()
+{
+    if (bypass.compareAndSetBool (0, 1))
+    {
+        if (auto* proc = node.getAudioProcessor())
+            if (proc->isSuspended() != node.isSuspended())
+                proc->suspendProcessing (node.isSuspended());
+        node.bypassChanged (&node);
+    }
+
+    if (mute.compareAndSetBool (0, 1))
+        node.muteChanged (&node);
 }
 
 //=============================================================================
@@ -498,11 +556,9 @@ void Processor::MidiProgramLoader::handleAsyncUpdate()
         if (programFile.existsAsFile())
         {
             const auto programData = Node::parse (programFile);
-            auto data = programData.getProperty (tags::state).toString().trim();
-            if (data.isNotEmpty())
+            if (StateBlob::isState (programData.getProperty (tags::state)))
             {
-                MemoryBlock state;
-                state.fromBase64Encoding (data);
+                const auto state = StateBlob::decode (programData.getProperty (tags::state));
                 if (state.getSize() > 0)
                 {
                     node.lastMidiProgram.set (requestedProgram);
@@ -705,8 +761,18 @@ void Processor::setMuted (bool muted)
 {
     bool wasMuted = isMuted();
     mute.set (muted ? 1 : 0);
-    if (wasMuted != isMuted())
+    if (wasMuted == isMuted())
+        return;
+
+    if (MessageManager::getInstance()->isThisTheMessageThread())
+    {
         muteChanged (this);
+    }
+    else
+    {
+        stateNotifier.mute.set (1);
+        stateNotifier.triggerAsyncUpdate();
+    }
 }
 
 //==============================================================================
@@ -750,6 +816,28 @@ void Processor::setOversamplingFactor (int osFactor)
         g->triggerAsyncUpdate();
 }
 
+void Processor::setOversamplingQuality (int quality)
+{
+    const auto newQuality = (Oversampler<float>::Quality) jlimit (0, (int) Oversampler<float>::numQualities - 1, quality);
+    if (newQuality == oversampler->getQuality())
+        return;
+
+    {
+        const auto wasEnabled = isEnabled();
+        setEnabled (false);
+        oversampler->setQuality (newQuality); // rebuilt when prepared again
+        setEnabled (wasEnabled);
+    }
+
+    if (auto* g = getParentGraph())
+        g->triggerAsyncUpdate();
+}
+
+int Processor::getOversamplingQuality() const
+{
+    return (int) oversampler->getQuality();
+}
+
 int Processor::getOversamplingFactor()
 {
     if (osPow > 0)
@@ -774,6 +862,28 @@ void Processor::setDelayCompensation (double delayMs)
 double Processor::getDelayCompensation() const { return delayCompMillis; }
 int Processor::getDelayCompensationSamples() const { return delayCompSamples; }
 
+//==============================================================================
+void Processor::setSilenceTail (double seconds)
+{
+    silenceTail = seconds;
+    updateSilenceTail();
+}
+
+void Processor::updateSilenceTail()
+{
+    double seconds = silenceTail;
+    if (seconds < 0.0)
+    {
+        auto* const proc = getAudioProcessor();
+        seconds = proc != nullptr ? proc->getTailLengthSeconds() : 0.0;
+    }
+
+    const double samples = seconds * sampleRate;
+    silenceTailSamples.set (std::isfinite (samples) && samples < (double) std::numeric_limits<int>::max()
+                                ? jmax (0, roundToInt (samples))
+                                : -1);
+}
+
 //=========================================================================
 struct ChannelConnectionMap
 {
@@ -853,7 +963,10 @@ void Processor::triggerPortReset()
 //=========================================================================
 int Processor::getLatencySamples() const
 {
-    return latencySamples + delayCompSamples + roundToInt (osLatency);
+    // an oversampled node reports latency at the higher rate
+    const int nodeLatency = osPow > 0 ? roundToInt ((double) latencySamples / (double) (1 << osPow))
+                                      : latencySamples;
+    return nodeLatency + delayCompSamples + roundToInt (osLatency);
 }
 
 void Processor::setLatencySamples (int latency)
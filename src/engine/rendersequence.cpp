@@ -0,0 +1,251 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <unordered_map>
+
+#include <element/atombuffer.hpp>
+
+#include "engine/bufferkernels.hpp"
+#include "engine/graphbuilder.hpp"
+#include "engine/parallelrender.hpp"
+#include "engine/rendersequence.hpp"
+
+namespace element {
+
+static int bufferKey (RenderInstruction::Code code, int index) noexcept
+{
+    switch (code)
+    {
+        case RenderInstruction::clearAudio:
+        case RenderInstruction::copyAudio:
+        case RenderInstruction::addAudio:
+            return BufferAccess::key (PortType::Audio, index);
+        case RenderInstruction::clearMidi:
+        case RenderInstruction::copyMidi:
+        case RenderInstruction::addMidi:
+            return BufferAccess::key (PortType::Midi, index);
+        case RenderInstruction::clearAtom:
+        case RenderInstruction::copyAtom:
+        case RenderInstruction::addAtom:
+            return BufferAccess::key (PortType::Atom, index);
+        case RenderInstruction::perform:
+            break;
+    }
+
+    return BufferAccess::graphIOKey;
+}
+
+void RenderProgram::compile (const Array<void*>& ops)
+{
+    code.clear();
+    code.reserve ((size_t) ops.size());
+
+    // buffer key -> index of a clear nothing has touched since
+    std::unordered_map<int, size_t> cleared;
+    std::vector<bool> removed;
+    removed.reserve ((size_t) ops.size());
+
+    for (auto* ptr : ops)
+    {
+        auto* const op = static_cast<GraphOp*> (ptr);
+        RenderInstruction ins;
+        ins.op = op;
+
+        if (! op->compile (ins))
+        {
+            ins.code = RenderInstruction::perform;
+            BufferAccess access;
+            op->getBufferAccess (access);
+            for (const auto key : access.reads)
+                cleared.erase (key);
+            for (const auto key : access.writes)
+                cleared.erase (key);
+        }
+        else
+        {
+            const int dst = bufferKey (ins.code, ins.dst);
+            const int src = bufferKey (ins.code, ins.src);
+
+            switch (ins.code)
+            {
+                case RenderInstruction::clearAudio:
+                case RenderInstruction::clearMidi:
+                case RenderInstruction::clearAtom: {
+                    cleared[dst] = code.size();
+                    break;
+                }
+
+                case RenderInstruction::addAudio:
+                case RenderInstruction::addMidi:
+                case RenderInstruction::addAtom: {
+                    auto it = cleared.find (dst);
+                    if (it != cleared.end() && src != dst)
+                    {
+                        // clear + add = copy
+                        removed[it->second] = true;
+                        ins.code = ins.code == RenderInstruction::addAudio  ? RenderInstruction::copyAudio
+                                   : ins.code == RenderInstruction::addMidi ? RenderInstruction::copyMidi
+                                                                            : RenderInstruction::copyAtom;
+                    }
+                    cleared.erase (src);
+                    cleared.erase (dst);
+                    break;
+                }
+
+                default: {
+                    cleared.erase (src);
+                    cleared.erase (dst);
+                    break;
+                }
+            }
+        }
+
+        code.push_back (ins);
+        removed.push_back (false);
+    }
+
+    size_t n = 0;
+    for (size_t i = 0; i < code.size(); ++i)
+        if (! removed[i])
+            code[n++] = code[i];
+    code.resize (n);
+}
+
+void RenderProgram::run (AudioSampleBuffer& audio,
+                         const OwnedArray<MidiBuffer>& midi,
+                         const OwnedArray<AtomBuffer>& atom,
+                         const int numSamples) const noexcept
+{
+    for (const auto& ins : code)
+    {
+        switch (ins.code)
+        {
+            case RenderInstruction::clearAudio:
+                audio.clear (ins.dst, 0, numSamples);
+                break;
+            case RenderInstruction::copyAudio:
+                BufferKernels::copy (audio.getWritePointer (ins.dst), audio.getReadPointer (ins.src), numSamples);
+                break;
+            case RenderInstruction::addAudio:
+                BufferKernels::add (audio.getWritePointer (ins.dst), audio.getReadPointer (ins.src), numSamples);
+                break;
+
+            case RenderInstruction::clearMidi:
+                midi.getUnchecked (ins.dst)->clear();
+                break;
+            case RenderInstruction::copyMidi:
+                *midi.getUnchecked (ins.dst) = *midi.getUnchecked (ins.src);
+                break;
+            case RenderInstruction::addMidi:
+                midi.getUnchecked (ins.dst)->addEvents (*midi.getUnchecked (ins.src), 0, numSamples, 0);
+                break;
+
+            case RenderInstruction::clearAtom:
+                atom.getUnchecked (ins.dst)->clear (0, numSamples);
+                break;
+            case RenderInstruction::copyAtom: {
+                auto* const dst = atom.getUnchecked (ins.dst);
+                dst->clear();
+                dst->add (*atom.getUnchecked (ins.src));
+                break;
+            }
+            case RenderInstruction::addAtom:
+                atom.getUnchecked (ins.dst)->add (*atom.getUnchecked (ins.src));
+                break;
+
+            case RenderInstruction::perform:
+                ins.op->perform (audio, midi, atom, numSamples);
+                break;
+        }
+    }
+}
+
+//==============================================================================
+RenderSequence::~RenderSequence()
+{
+    schedule.reset();
+    for (const auto index : released)
+        ops.set (index, nullptr);
+    for (int i = ops.size(); --i >= 0;)
+        delete static_cast<GraphOp*> (ops.getUnchecked (i));
+    ops.clearQuick();
+}
+
+//==============================================================================
+RenderSequenceReclaimer::RenderSequenceReclaimer()
+    : Thread ("element: reclaimer")
+{
+    startThread (Thread::Priority::low);
+}
+
+RenderSequenceReclaimer::~RenderSequenceReclaimer()
+{
+    stopThread (1000);
+    collect (nullptr, true);
+}
+
+void RenderSequenceReclaimer::retire (RenderSequence* sequence, const std::atomic<RenderSequence*>& hazard)
+{
+    if (sequence == nullptr)
+        return;
+    const ScopedLock sl (lock);
+    retired.add ({ sequence, &hazard });
+    notify();
+}
+
+void RenderSequenceReclaimer::reclaim (const std::atomic<RenderSequence*>& hazard)
+{
+    collect (&hazard, true);
+}
+
+void RenderSequenceReclaimer::run()
+{
+    while (! threadShouldExit())
+    {
+        collect (nullptr, false);
+        wait (50);
+    }
+}
+
+void RenderSequenceReclaimer::collect (const std::atomic<RenderSequence*>* onlyHazard, bool block)
+{
+    Array<RenderSequence*> garbage;
+
+    {
+        const ScopedLock sl (lock);
+
+        // oldest first. Ops carried over by a rebuild belong to the newer
+        // sequence, so it must outlive every older one the renderer may hold.
+        Array<const std::atomic<RenderSequence*>*> busy;
+        for (int i = 0; i < retired.size();)
+        {
+            const auto item = retired.getUnchecked (i);
+            if ((onlyHazard != nullptr && item.hazard != onlyHazard) || busy.contains (item.hazard))
+            {
+                ++i;
+                continue;
+            }
+
+            if (block)
+            {
+                // the renderer holds a sequence for at most one block
+                while (item.hazard->load() == item.sequence)
+                    Thread::yield();
+            }
+            else if (item.hazard->load() == item.sequence)
+            {
+                busy.add (item.hazard);
+                ++i;
+                continue;
+            }
+
+            garbage.add (item.sequence);
+            retired.remove (i);
+        }
+    }
+
+    for (auto* seq : garbage)
+        delete seq;
+}
+
+} // namespace element
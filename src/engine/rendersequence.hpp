@@ -0,0 +1,157 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include <element/atombuffer.hpp>
+
+#include "ElementApp.h"
+#include "engine/graphbuilder.hpp"
+
+namespace element {
+
+class RenderSchedule;
+
+/** A rendering sequence flattened in to one contiguous array of instructions.
+
+    Routing ops are run by a switch instead of virtual calls, and a clear
+    followed by an add to the same buffer is fused in to a copy.
+ */
+class RenderProgram final
+{
+public:
+    RenderProgram() = default;
+
+    /** Compile a list of GraphOps. The ops are not owned and must outlive
+        this program. Not realtime safe. */
+    void compile (const Array<void*>& ops);
+
+    /** Returns the number of instructions. */
+    int size() const noexcept { return (int) code.size(); }
+
+    /** Returns an instruction. */
+    const RenderInstruction& operator[] (int index) const noexcept { return code[(size_t) index]; }
+
+    /** Run the program. Realtime safe. */
+    void run (AudioSampleBuffer& audio,
+              const OwnedArray<MidiBuffer>& midi,
+              const OwnedArray<AtomBuffer>& atom,
+              int numSamples) const noexcept;
+
+private:
+    std::vector<RenderInstruction> code;
+    JUCE_DECLARE_NON_COPYABLE (RenderProgram)
+};
+
+/** The scratch buffers a graph renders with. Sequences share one set until a
+    rebuild needs more buffers than it has, then the new sequence gets a
+    larger set of its own. Buffers are never resized once published.
+ */
+struct RenderBuffers final
+{
+    AudioSampleBuffer audio { 1, 1 };
+    OwnedArray<MidiBuffer> midi;
+    OwnedArray<AtomBuffer> atom;
+
+    /** Returns true if there are at least this many buffers of each type. */
+    bool canHold (int numAudio, int numMidi, int numAtom) const noexcept
+    {
+        return audio.getNumChannels() >= numAudio && midi.size() >= numMidi && atom.size() >= numAtom;
+    }
+};
+
+/** An immutable snapshot of a graph's rendering ops.
+
+    A graph publishes its sequence through an atomic pointer. The audio thread
+    marks the sequence it is rendering in a hazard slot, and replaced
+    sequences are handed to a RenderSequenceReclaimer which deletes them once
+    the audio thread has moved on. Neither side ever waits on the other.
+ */
+struct RenderSequence final
+{
+    RenderSequence() = default;
+    ~RenderSequence();
+
+    /** The ops to perform in order. Owned unless listed in released. */
+    Array<void*> ops;
+
+    /** The ops compiled for rendering on a single thread. */
+    RenderProgram program;
+
+    /** Optional schedule for rendering the ops in parallel. */
+    std::unique_ptr<RenderSchedule> schedule;
+
+    /** The buffers to render with, possibly shared with older sequences. */
+    std::shared_ptr<RenderBuffers> buffers;
+
+    /** Indexes of ops which were moved in to a newer sequence. Only touched
+        on the message thread. */
+    Array<int> released;
+
+    /** Returns the sequence a renderer should use and marks it in the hazard
+        slot. Call release() when done. Realtime safe. */
+    static RenderSequence* acquire (const std::atomic<RenderSequence*>& current,
+                                    std::atomic<RenderSequence*>& hazard) noexcept
+    {
+        auto* seq = current.load();
+        for (;;)
+        {
+            hazard.store (seq);
+            auto* const check = current.load();
+            if (check == seq)
+                return seq;
+            seq = check;
+        }
+    }
+
+    /** Clears the hazard slot after rendering. Realtime safe. */
+    static void release (std::atomic<RenderSequence*>& hazard) noexcept
+    {
+        hazard.store (nullptr, std::memory_order_release);
+    }
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderSequence)
+};
+
+/** Deletes retired RenderSequences on a background thread once no renderer
+    refers to them. One instance is shared by all graphs.
+ */
+class RenderSequenceReclaimer final : private Thread
+{
+public:
+    RenderSequenceReclaimer();
+    ~RenderSequenceReclaimer();
+
+    /** Hand over a sequence which has been replaced. The sequence is deleted
+        when the hazard slot no longer points to it, and not before the
+        sequences retired earlier with the same slot. An older sequence may
+        still be rendering ops which this one took over. Not realtime safe.
+     */
+    void retire (RenderSequence* sequence, const std::atomic<RenderSequence*>& hazard);
+
+    /** Deletes every sequence retired with this hazard slot, waiting for the
+        renderer if needed. Call this before the hazard slot goes away.
+     */
+    void reclaim (const std::atomic<RenderSequence*>& hazard);
+
+private:
+    struct Retired
+    {
+        RenderSequence* sequence;
+        const std::atomic<RenderSequence*>* hazard;
+    };
+
+    CriticalSection lock;
+    Array<Retired> retired;
+
+    void run() override;
+    void collect (const std::atomic<RenderSequence*>* onlyHazard, bool block);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderSequenceReclaimer)
+};
+
+} // namespace element
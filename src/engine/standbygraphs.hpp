@@ -0,0 +1,99 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce.hpp>
+
+namespace element {
+
+/** Decides which root graphs stay loaded in setlist mode.
+
+    Keeps the active graph, the graphs following it in the set, up to half
+    the standby count, and the graphs used most recently, up to the rest.
+    Graphs which can't stand by are always kept.
+ */
+template <class GraphType>
+class StandbyGraphs final
+{
+public:
+    StandbyGraphs() = default;
+
+    /** Mark a graph as the most recently used. */
+    void touch (GraphType* graph)
+    {
+        recent.removeFirstMatchingValue (graph);
+        recent.insert (0, graph);
+    }
+
+    /** Forget a graph which was removed. */
+    void remove (GraphType* graph) { recent.removeFirstMatchingValue (graph); }
+
+    void clear() { recent.clearQuick(); }
+
+    /** Graphs in order of use, most recent first. */
+    const juce::Array<GraphType*>& getRecent() const noexcept { return recent; }
+
+    /** Returns the graphs to keep loaded, given the graphs in session order
+        and the active one's index. The active graph is touched first.
+
+        Graphs for which canStandby returns false, like ones which render
+        next to the active graph, are always kept and don't count against
+        the standby budget.
+     */
+    template <class Predicate>
+    juce::Array<GraphType*> choose (const juce::Array<GraphType*>& set, int activeIndex, int numStandby, Predicate canStandby)
+    {
+        juce::Array<GraphType*> keep;
+        for (auto* graph : set)
+            if (graph != nullptr && ! canStandby (graph))
+                keep.addIfNotAlreadyThere (graph);
+
+        auto* const active = set[activeIndex];
+        if (active != nullptr && canStandby (active))
+        {
+            touch (active);
+            keep.addIfNotAlreadyThere (active);
+        }
+
+        auto isCandidate = [&] (GraphType* graph) {
+            return graph != nullptr && graph != active && canStandby (graph)
+                   && set.contains (graph) && ! keep.contains (graph);
+        };
+
+        // half the budget for what comes next in the set, the rest for
+        // the graphs used most recently.
+        const int numAhead = juce::jmax (1, numStandby / 2);
+        int numKept = 0;
+        for (int i = activeIndex + 1; i < set.size() && numKept < numAhead; ++i)
+        {
+            if (isCandidate (set.getUnchecked (i)))
+            {
+                keep.add (set.getUnchecked (i));
+                ++numKept;
+            }
+        }
+
+        for (auto* graph : recent)
+        {
+            if (numKept < numStandby && isCandidate (graph))
+            {
+                keep.add (graph);
+                ++numKept;
+            }
+        }
+
+        return keep;
+    }
+
+    /** Returns the graphs to keep loaded when every graph can stand by. */
+    juce::Array<GraphType*> choose (const juce::Array<GraphType*>& set, int activeIndex, int numStandby)
+    {
+        return choose (set, activeIndex, numStandby, [] (GraphType*) { return true; });
+    }
+
+private:
+    juce::Array<GraphType*> recent;
+};
+
+} // namespace element
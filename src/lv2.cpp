@@ -1170,6 +1170,8 @@ public:
     {
         LV2Processor* proc = nullptr;
 
+        // nodes may load on several threads, lilv needs them to take turns
+        const ScopedLock sl (world->getLock());
         if (LV2Module* module = world->createModule (uri))
         {
             Result res (module->instantiate (44100.0));
@@ -1237,6 +1239,25 @@ String LV2NodeProvider::nameForURI (const String& uri) const noexcept
                : String();
 }
 
+String LV2NodeProvider::bundleForURI (const String& uri) const noexcept
+{
+    auto plugin = lv2->world->getPlugin (uri);
+    if (plugin == nullptr)
+        return {};
+
+    String path;
+    if (auto bundle = lilv_plugin_get_bundle_uri (plugin))
+    {
+        if (auto cpath = lilv_file_uri_parse (lilv_node_as_uri (bundle), nullptr))
+        {
+            path = String::fromUTF8 (cpath);
+            lilv_free (cpath);
+        }
+    }
+
+    return path;
+}
+
 } // namespace element
 
 JUCE_END_IGNORE_WARNINGS_GCC_LIKE
@@ -264,6 +264,23 @@ public:
         }
     }
 
+    /** Connect every port to its buffer, done once per instance. */
+    void connectAll (LilvInstance* instance)
+    {
+        connections.clear ((size_t) buffers.size());
+        for (int i = 0; i < buffers.size(); ++i)
+            connect (instance, (uint32) i, buffers.getUnchecked (i)->getPortData());
+    }
+
+    /** Connect a port, skipping the call if it is already connected there. */
+    void connect (LilvInstance* instance, uint32 port, void* data) noexcept
+    {
+        if (connections[port] == data)
+            return;
+        connections[port] = data;
+        lilv_instance_connect_port (instance, port, data);
+    }
+
 private:
     friend class LV2Module;
     LV2Module& owner;
@@ -278,6 +295,12 @@ private:
 
     HeapBlock<float> mins, maxes, defaults, current;
     OwnedArray<PortBuffer> buffers;
+    HeapBlock<void*> connections;
+
+    // built in init() so the realtime loops only visit ports which need it
+    Array<uint32> referredPorts; ///< audio, cv and atom inputs, connected to render buffers
+    Array<uint32> sequenceOutputs; ///< atom outputs, reset every block
+    Array<uint32> controlOutputs; ///< control outputs, checked for changes after run
 
     std::vector<LV2PatchInfo> patchParams;
     uint32_t atomControlInIndex { EL_INVALID_PORT };
@@ -319,6 +342,7 @@ void LV2Module::init()
     priv->maxes.allocate (numPorts, true);
     priv->defaults.allocate (numPorts, true);
     priv->current.allocate (numPorts, true);
+    priv->connections.allocate (numPorts, true);
 
     lilv_plugin_get_port_ranges_float (plugin, priv->mins, priv->maxes, priv->defaults);
 
@@ -385,7 +409,20 @@ void LV2Module::init()
             new PortBuffer (isInput, type, dataType, capacity));
 
         if (type == PortType::Control)
+        {
             buf->setValue (priv->defaults[p]);
+            priv->current[p] = priv->defaults[p];
+            if (! isInput)
+                priv->controlOutputs.add (p);
+        }
+        else if (type == PortType::Audio || type == PortType::CV || (type == PortType::Atom && isInput))
+        {
+            priv->referredPorts.add (p);
+        }
+        else if (type == PortType::Atom)
+        {
+            priv->sequenceOutputs.add (p);
+        }
 
         if (type == PortType::Atom && isInput)
         {
@@ -491,11 +528,23 @@ void LV2Module::setStateString (const String& stateStr)
     auto* const map = (LV2_URID_Map*) world.getFeatures().getFeature (LV2_URID__map)->getFeature()->data;
     auto* const unmap = (LV2_URID_Unmap*) world.getFeatures().getFeature (LV2_URID__unmap)->getFeature()->data;
     lvtk::ignore (unmap);
-    if (auto* state = lilv_state_new_from_string (world.getWorld(), map, stateStr.toRawUTF8()))
+
+    // parsing and freeing use the world, the plugin restores without it so
+    // several plugins can restore at once. SymbolMap locks its own calls.
+    LilvState* state = nullptr;
+    {
+        const ScopedLock sl (world.getLock());
+        state = lilv_state_new_from_string (world.getWorld(), map, stateStr.toRawUTF8());
+    }
+
+    if (state != nullptr)
     {
         const LV2_Feature* const features[] = { nullptr };
         lilv_state_restore (state, instance, Private::setPortValue, priv.get(), LV2_STATE_IS_POD, features);
-        lilv_state_free (state);
+        {
+            const ScopedLock sl (world.getLock());
+            lilv_state_free (state);
+        }
         priv->sendControlValues();
     }
 }
@@ -516,7 +565,7 @@ Result LV2Module::instantiate (double samplerate)
         const LilvNode* node = lilv_nodes_get (nodes, iter);
         if (lilv_node_equals (node, world.work_interface))
         {
-            worker = std::make_unique<WorkerFeature> (world.getWorkThread(), 1);
+            worker = std::make_unique<WorkerFeature> (world.getWorkerPool(), 1);
             features.add (worker->getFeature());
         }
     }
@@ -532,6 +581,8 @@ Result LV2Module::instantiate (double samplerate)
         return Result::fail ("Could not instantiate plugin.");
     }
 
+    priv->connectAll (instance);
+
     if (const void* data = getExtensionData (LV2_WORKER__interface))
     {
         if (worker == nullptr)
@@ -624,7 +675,8 @@ void LV2Module::connectChannel (const PortType type, const int32 channel, void*
 
 void LV2Module::connectPort (uint32 port, void* data)
 {
-    lilv_instance_connect_port (instance, port, data);
+    jassert (port < numPorts);
+    priv->connect (instance, port, data);
 }
 
 String LV2Module::getURI() const { return priv->uri; }
@@ -1054,16 +1106,12 @@ void LV2Module::referBuffers (RenderContext& rc)
     //                                     PortType::Atom, c, false))
     //         ->referTo (nullptr);
 
-    for (int i = priv->buffers.size(); --i >= 0;)
-    {
-        auto buffer = priv->buffers.getUnchecked (i);
-        if (buffer->isSequence() && ! buffer->isInput())
-            buffer->reset();
-        else if (buffer->isControl())
-            priv->current[i] = buffer->getValue();
+    for (const auto port : priv->sequenceOutputs)
+        priv->buffers.getUnchecked ((int) port)->reset();
 
-        lilv_instance_connect_port (instance, static_cast<uint32_t> (i), buffer->getPortData());
-    }
+    // everything else stays connected to the same place
+    for (const auto port : priv->referredPorts)
+        priv->connect (instance, port, priv->buffers.getUnchecked ((int) port)->getPortData());
 }
 
 void LV2Module::processEvents()
@@ -1076,8 +1124,15 @@ void LV2Module::processEvents()
             if (auto* buffer = index < priv->buffers.size() ? priv->buffers.getUnchecked (index) : nullptr)
             {
                 const auto value = juce::readUnaligned<float> (data);
-                if (buffer->getValue() != value)
+                if (buffer->isControl() && buffer->getValue() != value)
+                {
                     buffer->setValue (value);
+
+                    // let the host know the UI changed an input
+                    priv->current[index] = value;
+                    lvtk::MessageHeader notify = { header.portIndex, 0 };
+                    priv->eventsOut.push_message (notify, sizeof (float), &priv->current[index]);
+                }
             }
         }
         else if (auto* atomPort = index < priv->buffers.size() ? priv->buffers.getUnchecked (index) : nullptr)
@@ -1113,14 +1168,14 @@ void LV2Module::run (uint32 nframes)
     if (worker)
         worker->endRun();
 
-    for (int i = priv->buffers.size(); --i >= 0;)
+    for (const auto port : priv->controlOutputs)
     {
-        auto buffer = priv->buffers.getUnchecked (i);
-        if (buffer->isControl() && priv->current[i] != buffer->getValue())
+        const auto value = priv->buffers.getUnchecked ((int) port)->getValue();
+        if (priv->current[port] != value)
         {
-            priv->current[i] = buffer->getValue();
-            lvtk::MessageHeader header = { static_cast<uint32_t> (i), 0 };
-            priv->eventsOut.push_message (header, sizeof (float), &priv->current[i]);
+            priv->current[port] = value;
+            lvtk::MessageHeader header = { port, 0 };
+            priv->eventsOut.push_message (header, sizeof (float), &priv->current[port]);
         }
     }
 
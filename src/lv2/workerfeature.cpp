@@ -23,8 +23,8 @@ static LV2_Worker_Status workRespond (LV2_Worker_Respond_Handle handle, uint32_t
 }
 } // namespace LV2Callbacks
 
-WorkerFeature::WorkerFeature (WorkThread& thread, uint32_t bufsize, LV2_Handle handle, LV2_Worker_Interface* iface)
-    : WorkerBase (thread, bufsize)
+WorkerFeature::WorkerFeature (WorkerPool& pool, uint32_t bufsize, LV2_Handle handle, LV2_Worker_Interface* iface)
+    : WorkerBase (pool, bufsize)
 {
     setInterface (handle, iface);
     uri = LV2_WORKER__schedule;
@@ -17,167 +17,199 @@ using namespace juce;
 
 namespace element {
 
-WorkThread::WorkThread (const String& name, uint32_t bufsize, Thread::Priority priority)
-    : Thread (name)
+//==============================================================================
+class WorkerPool::WorkThread : public Thread
 {
-    nextWorkId = 0;
-    bufferSize = (uint32_t) nextPowerOfTwo (bufsize);
-    requests = std::make_unique<RingBuffer> (bufferSize);
-    startThread (priority);
-}
+public:
+    WorkThread (WorkerPool& p, const String& name)
+        : Thread (name), pool (p) {}
 
-WorkThread::~WorkThread()
-{
-    doExit = true;
-    signalThreadShouldExit();
-    notify();
-    waitForThreadToExit (100);
-    requests = nullptr;
-}
+    void run() override
+    {
+        HeapBlock<uint8_t> buffer;
+        uint32_t bufferSize = 0;
 
-WorkerBase* WorkThread::getWorker (uint32_t workerId) const
-{
-    if (workerId == 0)
-        return nullptr;
+        while (! threadShouldExit() && ! pool.exiting.load())
+        {
+            if (! pool.processNextRequest (buffer, bufferSize))
+                pool.wakeup.wait();
+        }
+    }
 
-    for (int i = 0; i < workers.size(); ++i)
-        if (workers.getUnchecked (i)->workId == workerId)
-            return workers.getUnchecked (i);
+private:
+    WorkerPool& pool;
+};
 
-    return nullptr;
+WorkerPool::WorkerPool (int numThreads, Priority priority)
+{
+    for (int i = 0; i < jmax (1, numThreads); ++i)
+        threads.add (new WorkThread (*this, "lv2_worker_" + String (i + 1)))->startThread (priority);
 }
 
-void WorkThread::addWorker (WorkerBase* worker)
+WorkerPool::~WorkerPool()
 {
-    worker->workId = ++nextWorkId;
-    WORKER_LOG (getThreadName() + " registering worker: " + String (worker->workId));
-    workers.addIfNotAlreadyThere (worker);
+    jassert (workers.isEmpty());
+    exiting.store (true);
+    for (auto* thread : threads)
+        thread->signalThreadShouldExit();
+    for (int i = threads.size(); --i >= 0;)
+        wakeup.post();
+    for (auto* thread : threads)
+        thread->stopThread (1000);
+    threads.clear();
 }
 
-void WorkThread::removeWorker (WorkerBase* worker)
+int WorkerPool::getDefaultNumThreads()
 {
-    WORKER_LOG (getThreadName() + " removing worker: " + String (worker->workId));
-    workers.removeFirstMatchingValue (worker);
-    worker->workId = 0;
+    return jlimit (1, 4, SystemStats::getNumCpus() / 2);
 }
 
-void WorkThread::run()
+void WorkerPool::addWorker (WorkerBase* worker)
 {
-    HeapBlock<uint8> buffer;
-    int32 readBufferSize = 0;
+    const ScopedLock sl (lock);
+    workers.addIfNotAlreadyThere (worker);
+    WORKER_LOG ("registered worker " << workers.size());
+}
 
-    while (true)
+void WorkerPool::removeWorker (WorkerBase* worker)
+{
     {
-        this->wait (-1);
-
-        if (doExit || threadShouldExit())
-            break;
-
-        while (! validateMessage (*requests))
-            Thread::sleep (6);
-
-        if (doExit || threadShouldExit())
-            break;
-
-        uint32_t size = 0;
-        if (requests->read (&size, sizeof (size)) < sizeof (size))
-        {
-            WORKER_LOG ("error reading request: message size");
-            continue;
-        }
+        const ScopedLock sl (lock);
+        workers.removeFirstMatchingValue (worker);
+        WORKER_LOG ("removed worker " << workers.size());
+    }
 
-        uint32_t workId;
-        if (requests->read (&workId, sizeof (workId)) < sizeof (workId))
-        {
-            WORKER_LOG ("error reading request: worker id");
-            continue;
-        }
+    // no thread can pick the worker up now, but one might still be running it
+    while (worker->isWorking())
+        Thread::sleep (1);
+}
 
-        if (workId == 0)
-            continue;
+bool WorkerPool::processNextRequest (HeapBlock<uint8_t>& buffer, uint32_t& bufferSize)
+{
+    WorkerBase* worker = nullptr;
 
-        if (size > static_cast<uint32_t> (readBufferSize))
+    {
+        // start after the last worker served so everybody gets a turn
+        const ScopedLock sl (lock);
+        const int numWorkers = workers.size();
+        for (int i = 0; i < numWorkers; ++i)
         {
-            readBufferSize = nextPowerOfTwo (size);
-            buffer.realloc (readBufferSize);
-        }
+            auto* const w = workers.getUnchecked ((nextWorker + i) % numWorkers);
+            if (! w->flag.setWorking (true))
+                continue;
 
-        if (requests->read (buffer.getData(), size) < size)
-        {
-            WORKER_LOG ("error reading request: message body");
-            continue;
-        }
-
-        {
-            if (WorkerBase* const worker = getWorker (workId))
+            if (w->hasPendingRequests())
             {
-                while (! worker->flag.setWorking (true))
-                {
-                }
-                worker->processRequest (size, buffer.getData());
-                while (! worker->flag.setWorking (false))
-                {
-                }
+                worker = w;
+                nextWorker = (nextWorker + i + 1) % numWorkers;
+                break;
             }
-        }
 
-        if (threadShouldExit() || doExit)
-            break;
+            w->flag.setWorking (false);
+        }
     }
 
-    buffer.free();
-}
-
-bool WorkThread::scheduleWork (WorkerBase* worker, uint32_t size, const void* data)
-{
-    jassert (size > 0 && worker && worker->workId != 0);
-    if (! requests->canWrite (getRequiredSpace (size)))
+    if (worker == nullptr)
         return false;
 
-    if (requests->write (&size, sizeof (size)) < sizeof (uint32_t))
-        return false;
+    // the realtime thread can write after hasPendingRequests, so only read
+    // a request which has fully landed. It wakes the pool again when done.
+    if (! worker->growRequests() && worker->validateMessage (*worker->requests))
+    {
+        auto& ring = *worker->requests;
+        uint32_t size = 0;
+        bool valid = ring.read (&size, sizeof (size)) == sizeof (size);
 
-    if (requests->write (&worker->workId, sizeof (worker->workId)) < sizeof (worker->workId))
-        return false;
+        if (valid && size > bufferSize)
+        {
+            bufferSize = (uint32_t) nextPowerOfTwo ((int) size);
+            buffer.realloc (bufferSize);
+        }
 
-    if (requests->write (data, size) < size)
-        return false;
+        valid = valid && ring.read (buffer.getData(), size) == size;
+        if (valid)
+            worker->processRequest (size, buffer.getData());
+        else
+            WORKER_LOG ("dropped a short request");
+    }
 
-    notify();
+    worker->flag.setWorking (false);
     return true;
 }
 
-bool WorkThread::validateMessage (RingBuffer& ring)
-{
-    uint32_t size = 0;
-    ring.peak (&size, sizeof (size));
-    return ring.canRead (getRequiredSpace (size));
-}
-
-WorkerBase::WorkerBase (WorkThread& thread, uint32_t bufsize)
-    : owner (thread)
+//==============================================================================
+WorkerBase::WorkerBase (WorkerPool& pool, uint32_t bufsize)
+    : owner (pool)
 {
+    requests = std::make_unique<RingBuffer> (4096);
     bufsize = juce::nextPowerOfTwo (bufsize);
     responses = std::make_unique<RingBuffer> (bufsize);
     response.calloc (bufsize);
-    thread.addWorker (this);
+    pool.addWorker (this);
 }
 
 WorkerBase::~WorkerBase()
 {
-    while (flag.isWorking())
-    {
-        Thread::sleep (100);
-    }
-
     owner.removeWorker (this);
+    requests = nullptr;
     responses = nullptr;
     response.free();
 }
 
 bool WorkerBase::scheduleWork (uint32_t size, const void* data)
 {
-    return owner.scheduleWork (this, size, data);
+    jassert (size > 0);
+
+    // only fails while a pool thread is replacing the queue with a bigger one
+    if (requestsLock.exchange (1, std::memory_order_acquire) != 0)
+        return false;
+
+    const auto required = WorkerPool::getRequiredSpace (size);
+    const bool fits = requests->canWrite (required);
+
+    if (fits)
+    {
+        requests->write (&size, sizeof (size));
+        requests->write (data, size);
+    }
+    else if (required > requiredSpace.load (std::memory_order_relaxed))
+    {
+        requiredSpace.store (required, std::memory_order_relaxed);
+    }
+
+    requestsLock.store (0, std::memory_order_release);
+
+    // wake the pool either way, it grows the queue when a request didn't fit
+    owner.wakeup.post();
+    return fits;
+}
+
+bool WorkerBase::hasPendingRequests()
+{
+    return (requiredSpace.load() > 0 && requests->getReadSpace() == 0)
+           || validateMessage (*requests);
+}
+
+bool WorkerBase::growRequests()
+{
+    // drain the old queue first so requests stay in order
+    const auto required = requiredSpace.load();
+    if (required == 0 || requests->getReadSpace() > 0)
+        return false;
+
+    if (requestsLock.exchange (1, std::memory_order_acquire) != 0)
+        return true; // the realtime thread is writing, try again later
+
+    if (requests->getReadSpace() == 0)
+    {
+        const auto newSize = nextPowerOfTwo ((int) jmax ((uint32_t) requests->size() * 2, required + 1));
+        WORKER_LOG ("growing request queue to " << newSize << " bytes");
+        requests = std::make_unique<RingBuffer> (newSize);
+        requiredSpace.store (0);
+    }
+
+    requestsLock.store (0, std::memory_order_release);
+    return true;
 }
 
 bool WorkerBase::respondToWork (uint32_t size, const void* data)
@@ -216,7 +248,8 @@ bool WorkerBase::validateMessage (RingBuffer& ring)
 {
     // the worker only validates message size
     uint32_t size = 0;
-    ring.peak (&size, sizeof (size));
+    if (ring.peak (&size, sizeof (size)) < sizeof (size))
+        return false;
     return ring.canRead (size + sizeof (size));
 }
 
@@ -3,57 +3,61 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 
 #include <element/juce/core.hpp>
 
 #include "ringbuffer.hpp"
+#include "semaphore.hpp"
 
 namespace element {
 
 class WorkerBase;
 
-/** A worker thread
-    Capable of scheduling non-realtime work from a realtime context.
+/** A pool of threads for scheduling non-realtime work from a realtime context.
+
+    Every worker has its own request queue written only by the realtime thread
+    running its plugin, so producers never share a queue. Idle threads take
+    turns over the workers and run one request at a time. A slow worker ties
+    up at most one thread while the others keep serving everybody else, and a
+    worker never runs on two threads at once.
  */
-class WorkThread : public juce::Thread
+class WorkerPool final
 {
 public:
     using Priority = juce::Thread::Priority;
-    WorkThread (const juce::String& name, uint32_t bufsize, Priority priority = Priority::normal);
-    ~WorkThread();
-
-    inline static uint32_t getRequiredSpace (uint32_t msgSize) { return msgSize + (2 * sizeof (uint32_t)); }
-
-protected:
-    friend class WorkerBase;
+    WorkerPool (int numThreads, Priority priority = Priority::normal);
+    ~WorkerPool();
 
-    /** Register a worker for scheduling. Does not take ownership */
-    void addWorker (WorkerBase* worker);
+    /** Returns a sensible number of threads for this machine. */
+    static int getDefaultNumThreads();
 
-    /** Deregister a worker from scheduling. Does not delete the worker */
-    void removeWorker (WorkerBase* worker);
+    /** Returns the number of running threads. */
+    int getNumThreads() const noexcept { return threads.size(); }
 
-    /** Schedule non-realtime work
-        Workers will call this in Worker::scheduleWork */
-    bool scheduleWork (WorkerBase* worker, uint32_t size, const void* data);
+    inline static uint32_t getRequiredSpace (uint32_t msgSize) { return msgSize + sizeof (uint32_t); }
 
 private:
-    uint32_t bufferSize;
+    friend class WorkerBase;
+    class WorkThread;
 
-    WorkerBase* getWorker (uint32_t workerId) const;
-    juce::Array<WorkerBase*, juce::CriticalSection> workers;
+    juce::OwnedArray<WorkThread> threads;
+    juce::CriticalSection lock;
+    juce::Array<WorkerBase*> workers;
+    int nextWorker = 0;
 
-    uint32_t nextWorkId;
-    bool doExit = false;
+    Semaphore wakeup;
+    std::atomic<bool> exiting { false };
 
-    std::unique_ptr<RingBuffer> requests; ///< requests to process
+    /** Register a worker for scheduling. Does not take ownership */
+    void addWorker (WorkerBase* worker);
 
-    /** @internal Validate a ringbuffer for message completeness */
-    bool validateMessage (RingBuffer& ring);
+    /** Deregister a worker and wait for it to finish working. Does not delete the worker */
+    void removeWorker (WorkerBase* worker);
 
-    /** @internal The work thread function */
-    void run();
+    /** @internal Run one pending request, returns false if there was nothing to do */
+    bool processNextRequest (juce::HeapBlock<uint8_t>& buffer, uint32_t& bufferSize);
 };
 
 /** A flag that indicates whether work is happening or not */
@@ -66,24 +70,25 @@ public:
 private:
     juce::Atomic<int32> flag;
     inline bool setWorking (bool status) { return flag.compareAndSetBool (status ? 1 : 0, status ? 0 : 1); }
-    friend class WorkThread;
+    friend class WorkerPool;
 };
 
 class WorkerBase
 {
 public:
     /** Create a new Worker
-        @param thread The WorkThread to use when scheduling
+        @param pool The WorkerPool to use when scheduling
         @param bufsize Size to use for internal response buffers */
-    WorkerBase (WorkThread& thread, uint32_t bufsize);
+    WorkerBase (WorkerPool& pool, uint32_t bufsize);
     virtual ~WorkerBase();
 
     /** Returns true if the worker is currently working */
     inline bool isWorking() const { return flag.isWorking(); }
 
     /** Schedule work (realtime thread).
-        Work will be scheduled, and the thread will call Worker::processRequest
-        when the data is queued */
+        Work will be scheduled, and the pool will call Worker::processRequest
+        when the data is queued. Returns false if the request didn't fit, in
+        which case the queue grows to fit it before the next request. */
     bool scheduleWork (uint32_t size, const void* data);
 
     /** Respond from work (worker thread). Call this during processRequest if you
@@ -107,16 +112,21 @@ protected:
     virtual void processResponse (uint32_t size, const void* data) = 0;
 
 private:
-    WorkThread& owner;
-    uint32_t workId; ///< The thread assigned id for this worker
-    WorkFlag flag; ///< A flag for when work is being processed
+    WorkerPool& owner;
+    WorkFlag flag; ///< Set while a pool thread owns this worker
+
+    std::unique_ptr<RingBuffer> requests; ///< requests to process
+    std::atomic<int> requestsLock { 0 }; ///< held while writing or replacing requests
+    std::atomic<uint32_t> requiredSpace { 0 }; ///< space needed by a request that didn't fit
 
     std::unique_ptr<RingBuffer> responses; ///< responses from work
     juce::HeapBlock<uint8_t> response; ///< buffer to write a response
 
+    bool hasPendingRequests();
+    bool growRequests();
     bool validateMessage (RingBuffer& ring);
 
-    friend class WorkThread;
+    friend class WorkerPool;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WorkerBase)
 };
 
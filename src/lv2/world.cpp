@@ -17,8 +17,9 @@
 #include "lv2/world.hpp"
 #include "lv2/logfeature.hpp"
 
+// number of LV2 worker threads, zero sizes the pool to the machine
 #ifndef EL_LV2_NUM_WORKERS
-#define EL_LV2_NUM_WORKERS 1
+#define EL_LV2_NUM_WORKERS 0
 #endif
 
 namespace element {
@@ -167,12 +168,8 @@ World::World (SymbolMap& s)
                           LV2ModuleUI::portUnsubscribe);
     suil_host_set_touch_func (suil, LV2ModuleUI::touch);
 
-    currentThread = 0;
-    numThreads = EL_LV2_NUM_WORKERS;
-    for (int i = 0; i < numThreads; ++i)
-    {
-        threads.add (new WorkThread ("lv2_worker_" + String (i + 1), EL_LV2_RING_BUFFER_SIZE));
-    }
+    workers = std::make_unique<WorkerPool> (EL_LV2_NUM_WORKERS > 0 ? EL_LV2_NUM_WORKERS
+                                                                  : WorkerPool::getDefaultNumThreads());
 
     addFeature (new GenericFeature (*symbolMap.mapFeature()), false);
     addFeature (new GenericFeature (*symbolMap.unmapFeature()), false);
@@ -300,18 +297,14 @@ const LilvPlugins* World::getAllPlugins() const
     return lilv_world_get_all_plugins (world);
 }
 
-WorkThread& World::getWorkThread()
+WorkerPool& World::getWorkerPool()
 {
-    while (threads.size() < numThreads)
-    {
-        threads.add (new WorkThread ("LV2 Worker " + String (threads.size()), EL_LV2_RING_BUFFER_SIZE));
-    }
-
-    const int threadIndex = currentThread;
-    if (++currentThread >= numThreads)
-        currentThread = 0;
+    return *workers;
+}
 
-    return *threads.getUnchecked (threadIndex);
+int32 World::getNumWorkThreads() const
+{
+    return workers->getNumThreads();
 }
 
 bool World::isFeatureSupported (const String& featureURI) const
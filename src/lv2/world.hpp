@@ -19,7 +19,7 @@
 namespace element {
 
 class LV2Module;
-class WorkThread;
+class WorkerPool;
 
 /** Slim wrapper around LilvWorld.  Publishes commonly used LilvNodes and
     manages heavy weight features (like LV2 Worker)
@@ -107,11 +107,11 @@ public:
         to a plugin instance */
     inline void getFeatures (Array<const LV2_Feature*>& feats) const { features.getFeatures (feats); }
 
-    /** Get a worker thread */
-    WorkThread& getWorkThread();
+    /** Get the pool which runs work scheduled by plugins */
+    WorkerPool& getWorkerPool();
 
     /** Returns the total number of available worker threads */
-    inline int32 getNumWorkThreads() const { return numThreads; }
+    int32 getNumWorkThreads() const;
 
     /** Returns a plugin's name by URI, or empty if not found */
     String getPluginName (const String& uri) const;
@@ -139,15 +139,18 @@ public:
 
     SymbolMap& symbols() noexcept { return symbolMap; }
 
+    /** Lilv's world isn't thread safe. Hold this while using it from a thread
+        other than the message thread, e.g. while loading plugins on a pool. */
+    const CriticalSection& getLock() const noexcept { return lock; }
+
 private:
     LilvWorld* world = nullptr;
     SuilHost* suil = nullptr;
     SymbolMap& symbolMap;
     LV2FeatureArray features;
 
-    // a simple rotating thread pool
-    int currentThread, numThreads;
-    OwnedArray<WorkThread> threads;
+    std::unique_ptr<WorkerPool> workers;
+    CriticalSection lock;
 };
 
 } // namespace element
@@ -7,6 +7,7 @@
 #include <element/script.hpp>
 
 #include "engine/graphmanager.hpp"
+#include "session/sessionfile.hpp"
 #include "scopedflag.hpp"
 
 namespace element {
@@ -282,6 +283,9 @@ ValueTree Node::resetIds (const ValueTree& data)
 ValueTree Node::parse (const File& file)
 {
     ValueTree sessionData = Session::readFromFile (file);
+    if (sessionData.hasType (types::Node))
+        return sessionData; // an exported graph
+
     if (sessionData.isValid())
     {
         const auto graphs = sessionData.getChildWithName (tags::graphs);
@@ -347,6 +351,23 @@ ValueTree Node::parse (const File& file)
 }
 
 void Node::sanitizeProperties (ValueTree node, const bool recursive)
+{
+    sanitizeRuntimeProperties (node, false);
+
+    // state kept as raw bytes gets written as text
+    if (node.hasType (types::Node))
+    {
+        for (const auto& property : { tags::state, tags::programState })
+            if (StateBlob::fromVar (node.getProperty (property)) != nullptr)
+                node.setProperty (property, StateBlob::toBase64 (node.getProperty (property)), nullptr);
+    }
+
+    if (recursive)
+        for (int i = 0; i < node.getNumChildren(); ++i)
+            sanitizeProperties (node.getChild (i), recursive);
+}
+
+void Node::sanitizeRuntimeProperties (ValueTree node, const bool recursive)
 {
     node.removeProperty (tags::updater, nullptr);
     node.removeProperty (tags::object, nullptr);
@@ -362,16 +383,17 @@ void Node::sanitizeProperties (ValueTree node, const bool recursive)
 
     if (recursive)
         for (int i = 0; i < node.getNumChildren(); ++i)
-            sanitizeProperties (node.getChild (i), recursive);
-}
-
-void Node::sanitizeRuntimeProperties (ValueTree node, const bool recursive)
-{
-    Node::sanitizeProperties (node, recursive);
+            sanitizeRuntimeProperties (node.getChild (i), recursive);
 }
 
 bool Node::writeToFile (const File& targetFile) const
 {
+#if EL_SAVE_BINARY_FORMAT
+    // graphs hold many nodes, which often share state
+    if (hasNodeType (types::Graph))
+        return SessionFile::write (objectData, targetFile);
+#endif
+
     ValueTree data = objectData.createCopy();
     sanitizeProperties (data, true);
 
@@ -821,60 +843,68 @@ MidiChannels Node::getMidiChannels() const
     return chans;
 }
 
+Node::PluginState Node::getPluginState() const
+{
+    PluginState saved;
+    saved.program = objectData.getProperty (tags::program, -1);
+    saved.state = StateBlob::decode (getProperty (tags::state));
+    saved.programState = StateBlob::decode (getProperty (tags::programState));
+    return saved;
+}
+
+void Node::PluginState::applyTo (Processor& obj) const
+{
+    if (auto* const proc = obj.getAudioProcessor())
+    {
+        const bool shouldSetProgram = proc->getNumPrograms() > 0 && isPositiveAndBelow (program, proc->getNumPrograms());
+        if (shouldSetProgram)
+            proc->setCurrentProgram (program);
+
+        if (state.getSize() > 0)
+            proc->setStateInformation (state.getData(), (int) state.getSize());
+
+        if (shouldSetProgram && programState.getSize() > 0)
+            proc->setCurrentProgramStateInformation (programState.getData(), (int) programState.getSize());
+    }
+    else
+    {
+        const bool shouldSetProgram = obj.getNumPrograms() > 0 && isPositiveAndBelow (program, obj.getNumPrograms());
+        if (shouldSetProgram)
+            obj.setCurrentProgram (program);
+
+        if (state.getSize() > 0)
+            obj.setState (state.getData(), (int) state.getSize());
+    }
+}
+
 void Node::restorePluginState()
 {
     if (! isValid())
         return;
 
     if (ProcessorPtr obj = getObject())
-    {
-        if (auto* const proc = obj->getAudioProcessor())
-        {
-            const int wantedProgram = objectData.getProperty (tags::program, -1);
-            const bool shouldSetProgram = proc->getNumPrograms() > 0 && isPositiveAndBelow (wantedProgram, proc->getNumPrograms());
-            if (shouldSetProgram)
-                proc->setCurrentProgram (wantedProgram);
+        getPluginState().applyTo (*obj);
 
-            auto data = getProperty (tags::state).toString().trim();
-            if (data.isNotEmpty())
-            {
-                MemoryBlock state;
-                state.fromBase64Encoding (data);
-                if (state.getSize() > 0)
-                {
-                    proc->setStateInformation (state.getData(), (int) state.getSize());
-                }
-            }
+    restoreSettings();
 
-            data = getProperty (tags::programState).toString().trim();
-            if (shouldSetProgram && data.isNotEmpty())
-            {
-                MemoryBlock state;
-                state.fromBase64Encoding (data);
-                if (state.getSize() > 0)
-                {
-                    proc->setCurrentProgramStateInformation (state.getData(),
-                                                             (int) state.getSize());
-                }
-            }
-        }
-        else
-        {
-            const int wantedProgram = objectData.getProperty (tags::program, -1);
-            const bool shouldSetProgram = obj->getNumPrograms() > 0 && isPositiveAndBelow (wantedProgram, obj->getNumPrograms());
-            if (shouldSetProgram)
-                obj->setCurrentProgram (wantedProgram);
+    // this was originally here to help reduce memory usage
+    // need another way to free this property without disturbing
+    // the normal flow of the app.
+    const bool clearStateProperty = false;
+    if (clearStateProperty)
+        objectData.removeProperty (tags::state, 0);
 
-            auto data = getProperty (tags::state).toString().trim();
-            if (data.isNotEmpty())
-            {
-                MemoryBlock state;
-                state.fromBase64Encoding (data);
-                if (state.getSize() > 0)
-                    obj->setState (state.getData(), (int) state.getSize());
-            }
-        }
+    for (int i = 0; i < getNumNodes(); ++i)
+        getNode (i).restorePluginState();
+}
 
+void Node::restoreSettings()
+{
+    if (! isValid())
+        return;
+
+    if (ProcessorPtr obj = getObject())
+    {
         if (hasProperty (tags::bypass))
         {
             obj->suspendProcessing (isBypassed());
@@ -916,23 +946,16 @@ void Node::restorePluginState()
 
         obj->setMuted ((bool) getProperty (tags::mute, obj->isMuted()));
         obj->setMuteInput ((bool) getProperty ("muteInput", obj->isMutingInputs()));
+        obj->setSleepWhenSilent ((bool) getProperty (tags::sleepWhenSilent, obj->sleepsWhenSilent()));
+        obj->setSilenceTail ((double) getProperty (tags::silenceTail, obj->getSilenceTail()));
 
         if (hasProperty (tags::transpose))
             obj->setTransposeOffset (getProperty (tags::transpose));
 
+        obj->setOversamplingQuality ((int) getProperty (tags::oversamplingQuality, 0));
         obj->setOversamplingFactor (jmax (1, (int) getProperty (tags::oversamplingFactor, 1)));
         obj->setDelayCompensation (getProperty (tags::delayCompensation, 0.0));
     }
-
-    // this was originally here to help reduce memory usage
-    // need another way to free this property without disturbing
-    // the normal flow of the app.
-    const bool clearStateProperty = false;
-    if (clearStateProperty)
-        objectData.removeProperty (tags::state, 0);
-
-    for (int i = 0; i < getNumNodes(); ++i)
-        getNode (i).restorePluginState();
 }
 
 void Node::savePluginState()
@@ -950,7 +973,7 @@ void Node::savePluginState()
             proc->getStateInformation (state);
             if (state.getSize() > 0)
             {
-                objectData.setProperty (tags::state, state.toBase64Encoding(), nullptr);
+                StateBlob::set (objectData, tags::state, std::move (state));
             }
             else
             {
@@ -963,7 +986,7 @@ void Node::savePluginState()
             proc->getCurrentProgramStateInformation (state);
             if (state.getSize() > 0)
             {
-                objectData.setProperty (tags::programState, state.toBase64Encoding(), 0);
+                StateBlob::set (objectData, tags::programState, std::move (state));
             }
 
             setProperty (tags::bypass, proc->isSuspended());
@@ -999,7 +1022,7 @@ void Node::savePluginState()
         {
             obj->getState (state);
             if (state.getSize() > 0)
-                objectData.setProperty (tags::state, state.toBase64Encoding(), nullptr);
+                StateBlob::set (objectData, tags::state, std::move (state));
         }
 
         setProperty (tags::midiProgram, obj->getMidiProgram());
@@ -1007,10 +1030,13 @@ void Node::savePluginState()
         setProperty (tags::midiProgramsEnabled, obj->areMidiProgramsEnabled());
         setProperty (tags::mute, obj->isMuted());
         setProperty ("muteInput", obj->isMutingInputs());
+        setProperty (tags::sleepWhenSilent, obj->sleepsWhenSilent());
+        setProperty (tags::silenceTail, obj->getSilenceTail());
         String mps;
         obj->getMidiProgramsState (mps);
         setProperty (tags::midiProgramsState, mps);
         setProperty (tags::oversamplingFactor, obj->getOversamplingFactor());
+        setProperty (tags::oversamplingQuality, obj->getOversamplingQuality());
         setProperty (tags::delayCompensation, obj->getDelayCompensation());
     }
 
@@ -1164,6 +1190,22 @@ void Node::setMuteInput (bool shouldMuteInputs)
         obj->setMuteInput (isMutingInputs());
 }
 
+void Node::setSleepWhenSilent (bool shouldSleep)
+{
+    if (shouldSleep != sleepsWhenSilent())
+        setProperty (tags::sleepWhenSilent, shouldSleep);
+    if (auto* obj = getObject())
+        obj->setSleepWhenSilent (sleepsWhenSilent());
+}
+
+void Node::setSilenceTail (double seconds)
+{
+    if (seconds != getSilenceTail())
+        setProperty (tags::silenceTail, seconds);
+    if (auto* obj = getObject())
+        obj->setSilenceTail (getSilenceTail());
+}
+
 void Node::setCurrentProgram (const int index)
 {
     if (auto* obj = getObject())
@@ -1388,6 +1430,14 @@ void NodeObjectSync::valueTreePropertyChanged (ValueTree& tree, const Identifier
             g->triggerAsyncUpdate();
         }
     }
+    else if (property == tags::sleepWhenSilent)
+    {
+        obj->setSleepWhenSilent ((bool) tree.getProperty (property, false));
+    }
+    else if (property == tags::silenceTail)
+    {
+        obj->setSilenceTail ((double) tree.getProperty (property, -1.0));
+    }
 }
 
 void NodeObjectSync::valueTreeChildAdded (ValueTree& parent, ValueTree& child)
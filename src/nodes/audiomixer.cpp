@@ -1,6 +1,7 @@
 // Copyright 2023 Kushview, LLC <info@kushview.net>
 // SPDX-License-Identifier: GPL3-or-later
 
+#include "engine/bufferkernels.hpp"
 #include "nodes/audiomixer.hpp"
 #include "ui/horizontallistbox.hpp"
 #include <element/ui/style.hpp>
@@ -459,7 +460,7 @@ void AudioMixerProcessor::processBlock (AudioSampleBuffer& audio, MidiBuffer& mi
             for (int c = 0; c < track->numInputs; ++c)
             {
                 rms.getReference (c).set (track->gain * input.getRMSLevel (c, 0, numSamples));
-                tempBuffer.addFromWithRamp (c, 0, input.getReadPointer (c), numSamples, track->lastGain, track->gain);
+                BufferKernels::addWithRamp (tempBuffer.getWritePointer (c), input.getReadPointer (c), track->lastGain, track->gain, numSamples);
             }
         }
 
@@ -478,7 +479,7 @@ void AudioMixerProcessor::processBlock (AudioSampleBuffer& audio, MidiBuffer& mi
     const float gain = Decibels::decibelsToGain ((float) *masterVolume, (float) EL_FADER_MIN_DB);
     if (! *masterMute)
         for (int c = 0; c < output.getNumChannels(); ++c)
-            output.copyFromWithRamp (c, 0, tempBuffer.getReadPointer (c), numSamples, lastGain, gain);
+            BufferKernels::copyWithRamp (output.getWritePointer (c), tempBuffer.getReadPointer (c), lastGain, gain, numSamples);
 
     if (gain != masterMonitor->nextGain.get())
         *masterVolume = Decibels::gainToDecibels (masterMonitor->nextGain.get(), (float) EL_FADER_MIN_DB);
@@ -37,9 +37,14 @@ require ('el.MidiPipe')
 
 namespace element {
 
+// Room for the script, its buffers and the garbage between collections.
+static constexpr size_t scriptPoolSize = 8 * 1024 * 1024;
+
 //=============================================================================
 ScriptNode::ScriptNode() noexcept
-    : Processor (0)
+    : Processor (0),
+      allocator (scriptPoolSize),
+      lua (sol::default_at_panic, LuaAllocator::alloc, &allocator)
 {
     setName ("Script");
     Lua::initializeState (lua);
@@ -86,6 +91,7 @@ ScriptNode::ScriptNode() noexcept
     edCode.replaceAllContent (String::fromUTF8 (
         scripts::ampui_lua, scripts::ampui_luaSize));
     refreshPorts();
+    collector.attach (lua.lua_state(), allocator);
 }
 
 ScriptNode::~ScriptNode()
@@ -123,6 +129,9 @@ Result ScriptNode::loadScript (const String& newCode)
     if (result.failed())
         return result;
 
+    // the state and its pool are shared with render, hold the lock for all
+    // of it. render skips blocks meanwhile instead of waiting.
+    ScopedLock sl (lock);
     ScriptLoader loader (lua);
     loader.load (newCode);
     if (loader.hasError())
@@ -140,7 +149,6 @@ Result ScriptNode::loadScript (const String& newCode)
         if (prepared)
             newScript->prepare (sampleRate, blockSize);
         triggerPortReset();
-        ScopedLock sl (lock);
         if (script != nullptr)
             newScript->copyParameterValues (*script);
         script.swap (newScript);
@@ -177,6 +185,9 @@ void ScriptNode::prepareToRender (double rate, int block)
         return;
     sampleRate = rate;
     blockSize = block;
+    // collect for at most a tenth of a block, after the script has run
+    collector.setBudget (jmax (0.00005, 0.1 * blockSize / sampleRate));
+    ScopedLock sl (lock);
     script->prepare (sampleRate, blockSize);
     prepared = true;
 }
@@ -186,13 +197,35 @@ void ScriptNode::releaseResources()
     if (! prepared)
         return;
     prepared = false;
+    ScopedLock sl (lock);
     script->release();
 }
 
 void ScriptNode::render (RenderContext& rc)
 {
-    ScopedLock sl (lock);
+    ScopedTryLock sl (lock);
+    if (! sl.isLocked())
+    {
+        // the message thread is using the state, skip this block
+        rc.audio.clear();
+        rc.midi.clear();
+        return;
+    }
+
     script->process (rc.audio, rc.midi);
+    collector.step();
+}
+
+ScriptNode::Stats ScriptNode::getStats() const noexcept
+{
+    Stats stats;
+    stats.poolSize = allocator.getPoolSize();
+    stats.bytesUsed = allocator.getBytesUsed();
+    stats.peakBytesUsed = allocator.getPeakBytesUsed();
+    stats.failedAllocations = allocator.getNumFailedAllocations();
+    stats.lastCollectMs = collector.getLastStepTime() * 1000.0;
+    stats.peakCollectMs = collector.getPeakStepTime() * 1000.0;
+    return stats;
 }
 
 void ScriptNode::setState (const void* data, int size)
@@ -212,7 +245,10 @@ void ScriptNode::setState (const void* data, int size)
                 const var& data = state.getProperty ("data");
                 if (data.isBinaryData())
                     if (auto* block = data.getBinaryData())
+                    {
+                        ScopedLock sl (lock);
                         script->restore (block->getData(), block->getSize());
+                    }
             }
         }
 
@@ -227,7 +263,10 @@ void ScriptNode::getState (MemoryBlock& out)
         .setProperty ("editorCode", edCode.getAllContent(), nullptr);
 
     MemoryBlock block;
-    script->save (block);
+    {
+        ScopedLock sl (lock);
+        script->save (block);
+    }
     if (block.getSize() > 0)
         state.setProperty ("data", block, nullptr);
     block.reset();
@@ -5,6 +5,7 @@
 
 #include "nodes/baseprocessor.hpp"
 #include <element/processor.hpp>
+#include "scripting/luaallocator.hpp"
 #include "sol/sol.hpp"
 
 namespace element {
@@ -42,6 +43,20 @@ public:
 
     void refreshPorts() override;
 
+    /** Memory and garbage collection figures for the script's Lua state. */
+    struct Stats
+    {
+        size_t poolSize = 0;
+        size_t bytesUsed = 0;
+        size_t peakBytesUsed = 0;
+        int failedAllocations = 0;
+        double lastCollectMs = 0.0;
+        double peakCollectMs = 0.0;
+    };
+
+    /** Returns the current figures. Safe to call from any thread. */
+    Stats getStats() const noexcept;
+
     void setPlayHead (juce::AudioPlayHead*) override;
 
     //==========================================================================
@@ -56,7 +71,9 @@ protected:
 
 private:
     CriticalSection lock;
+    LuaAllocator allocator; // must outlive the state
     sol::state lua;
+    LuaCollector collector;
     CodeDocument dspCode, edCode;
     std::unique_ptr<DSPScript> script;
     ParameterArray inParams, outParams;
@@ -40,9 +40,12 @@ public:
             fifo.finishedRead (static_cast<int> (bytes));
     }
 
+    // reads and writes keep their positions on the stack so a reader and a
+    // writer can use the buffer from two threads at once.
     inline uint32 read (void* dest, uint32 size, bool advance = true)
     {
-        buffer = block.getData();
+        Vec vec1, vec2;
+        const uint8* const buffer = block.getData();
         fifo.prepareToRead (size, vec1.index, vec1.size, vec2.index, vec2.size);
 
         if (vec1.size > 0)
@@ -70,7 +73,8 @@ public:
 
     inline uint32 write (const void* src, uint32 bytes)
     {
-        buffer = block.getData();
+        Vec vec1, vec2;
+        uint8* const buffer = block.getData();
         fifo.prepareToWrite (bytes, vec1.index, vec1.size, vec2.index, vec2.size);
 
         if (vec1.size > 0)
@@ -102,10 +106,8 @@ private:
         int32 index;
     };
 
-    Vec vec1, vec2;
     juce::AbstractFifo fifo;
     juce::HeapBlock<uint8> block;
-    uint8* buffer;
 };
 
 } // namespace element
@@ -0,0 +1,337 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <bit>
+
+#include <lua.hpp>
+
+#include "scripting/luaallocator.hpp"
+
+namespace element {
+using namespace juce;
+
+//==============================================================================
+struct LuaAllocator::Block
+{
+    Block* prev; // the block before this one in memory, nullptr for the first
+    size_t size; // bytes after the header, the low bit is set while free
+
+    struct Links
+    {
+        Block* next;
+        Block* prev;
+    };
+
+    static constexpr size_t headerSize = alignment;
+    static constexpr size_t minSize = sizeof (Links) > alignment ? sizeof (Links) : alignment;
+
+    size_t getSize() const noexcept { return size & ~(size_t) 1; }
+    bool isFree() const noexcept { return (size & 1) != 0; }
+    void setSize (size_t newSize, bool free) noexcept { size = newSize | (free ? 1 : 0); }
+
+    void* getData() noexcept { return reinterpret_cast<char*> (this) + headerSize; }
+    Links& links() noexcept { return *static_cast<Links*> (getData()); }
+    Block* next() noexcept { return reinterpret_cast<Block*> (static_cast<char*> (getData()) + getSize()); }
+
+    static Block* fromData (void* data) noexcept
+    {
+        return reinterpret_cast<Block*> (static_cast<char*> (data) - headerSize);
+    }
+};
+
+static_assert (sizeof (void*) * 2 <= 16, "block header doesn't fit");
+
+//==============================================================================
+LuaAllocator::LuaAllocator (size_t size)
+{
+    poolSize = size & ~(alignment - 1);
+    jassert (poolSize >= Block::headerSize * 4);
+
+    memory.malloc (poolSize + alignment);
+    std::memset (memory.get(), 0, poolSize + alignment);
+
+    auto* const base = reinterpret_cast<char*> ((reinterpret_cast<uintptr_t> (memory.get()) + alignment - 1) & ~(uintptr_t) (alignment - 1));
+
+    // one free block, then an empty block which is never free so merging
+    // stops at the end of the pool.
+    auto* const first = reinterpret_cast<Block*> (base);
+    first->prev = nullptr;
+    first->setSize (poolSize - Block::headerSize * 2, true);
+
+    auto* const last = first->next();
+    last->prev = first;
+    last->setSize (0, false);
+
+    insert (first);
+}
+
+LuaAllocator::~LuaAllocator() = default;
+
+void* LuaAllocator::alloc (void* ud, void* ptr, size_t, size_t nsize) noexcept
+{
+    auto& self = *static_cast<LuaAllocator*> (ud);
+    if (nsize == 0)
+    {
+        if (ptr != nullptr)
+            self.deallocate (ptr);
+        return nullptr;
+    }
+
+    return ptr != nullptr ? self.reallocate (ptr, nsize) : self.allocate (nsize);
+}
+
+//==============================================================================
+void* LuaAllocator::allocate (size_t size) noexcept
+{
+    size = adjustSize (size);
+    auto* const block = size <= poolSize ? findFree (size) : nullptr;
+    if (block == nullptr)
+    {
+        failures.fetch_add (1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    block->setSize (block->getSize(), false);
+    trim (block, size);
+    addUsed (block->getSize(), 0);
+    return block->getData();
+}
+
+void* LuaAllocator::reallocate (void* ptr, size_t size) noexcept
+{
+    size = adjustSize (size);
+    auto* const block = Block::fromData (ptr);
+    const auto oldSize = block->getSize();
+
+    if (size <= oldSize)
+    {
+        trim (block, size);
+        addUsed (block->getSize(), oldSize);
+        return ptr;
+    }
+
+    // grow into the next block when it's free and big enough
+    auto* const next = block->next();
+    if (next->isFree() && oldSize + Block::headerSize + next->getSize() >= size)
+    {
+        remove (next);
+        block->setSize (oldSize + Block::headerSize + next->getSize(), false);
+        block->next()->prev = block;
+        trim (block, size);
+        addUsed (block->getSize(), oldSize);
+        return ptr;
+    }
+
+    auto* const newPtr = allocate (size);
+    if (newPtr == nullptr)
+        return nullptr;
+
+    std::memcpy (newPtr, ptr, oldSize);
+    deallocate (ptr);
+    return newPtr;
+}
+
+void LuaAllocator::deallocate (void* ptr) noexcept
+{
+    if (ptr == nullptr)
+        return;
+
+    auto* block = Block::fromData (ptr);
+    jassert (! block->isFree());
+    addUsed (0, block->getSize());
+    block->setSize (block->getSize(), true);
+
+    if (auto* const prev = block->prev; prev != nullptr && prev->isFree())
+    {
+        remove (prev);
+        prev->setSize (prev->getSize() + Block::headerSize + block->getSize(), true);
+        block = prev;
+        block->next()->prev = block;
+    }
+
+    if (auto* const next = block->next(); next->isFree())
+    {
+        remove (next);
+        block->setSize (block->getSize() + Block::headerSize + next->getSize(), true);
+        block->next()->prev = block;
+    }
+
+    insert (block);
+}
+
+//==============================================================================
+size_t LuaAllocator::adjustSize (size_t size) noexcept
+{
+    size = (size + alignment - 1) & ~(alignment - 1);
+    return jmax (size, Block::minSize);
+}
+
+void LuaAllocator::mapping (size_t size, int& fl, int& sl) noexcept
+{
+    if (size < smallSize)
+    {
+        fl = 0;
+        sl = (int) (size / (smallSize / numSL));
+    }
+    else
+    {
+        const int msb = (int) std::bit_width (size) - 1;
+        fl = msb - flShift + 1;
+        sl = (int) ((size >> (msb - slLog2)) ^ (size_t) numSL);
+    }
+}
+
+void LuaAllocator::insert (Block* block) noexcept
+{
+    int fl, sl;
+    mapping (block->getSize(), fl, sl);
+    jassert (fl < numFL);
+
+    auto*& head = freeLists[fl][sl];
+    block->links().prev = nullptr;
+    block->links().next = head;
+    if (head != nullptr)
+        head->links().prev = block;
+    head = block;
+
+    flBitmap |= 1u << fl;
+    slBitmaps[fl] |= 1u << sl;
+}
+
+void LuaAllocator::remove (Block* block) noexcept
+{
+    int fl, sl;
+    mapping (block->getSize(), fl, sl);
+
+    auto& links = block->links();
+    if (links.prev != nullptr)
+        links.prev->links().next = links.next;
+    if (links.next != nullptr)
+        links.next->links().prev = links.prev;
+
+    auto*& head = freeLists[fl][sl];
+    if (head == block)
+    {
+        head = links.next;
+        if (head == nullptr)
+        {
+            slBitmaps[fl] &= ~(1u << sl);
+            if (slBitmaps[fl] == 0)
+                flBitmap &= ~(1u << fl);
+        }
+    }
+}
+
+LuaAllocator::Block* LuaAllocator::findFree (size_t size) noexcept
+{
+    // round up to the next list, so any block found is large enough
+    if (size >= smallSize)
+        size += ((size_t) 1 << ((int) std::bit_width (size) - 1 - slLog2)) - 1;
+
+    int fl, sl;
+    mapping (size, fl, sl);
+    if (fl >= numFL)
+        return nullptr;
+
+    auto slMap = slBitmaps[fl] & (~0u << sl);
+    if (slMap == 0)
+    {
+        const auto flMap = fl + 1 < numFL ? flBitmap & (~0u << (fl + 1)) : 0u;
+        if (flMap == 0)
+            return nullptr;
+
+        fl = std::countr_zero (flMap);
+        slMap = slBitmaps[fl];
+    }
+
+    auto* const block = freeLists[fl][std::countr_zero (slMap)];
+    remove (block);
+    return block;
+}
+
+void LuaAllocator::trim (Block* block, size_t size) noexcept
+{
+    jassert (! block->isFree());
+    const auto blockSize = block->getSize();
+    if (blockSize < size + Block::headerSize + Block::minSize)
+        return;
+
+    block->setSize (size, false);
+    auto* const rest = block->next();
+    rest->prev = block;
+    rest->setSize (blockSize - size - Block::headerSize, true);
+
+    if (auto* const next = rest->next(); next->isFree())
+    {
+        remove (next);
+        rest->setSize (rest->getSize() + Block::headerSize + next->getSize(), true);
+    }
+
+    rest->next()->prev = rest;
+    insert (rest);
+}
+
+void LuaAllocator::addUsed (size_t added, size_t removed) noexcept
+{
+    // only one thread writes, relaxed is enough for readers wanting figures
+    const auto now = used.load (std::memory_order_relaxed) + added - removed;
+    used.store (now, std::memory_order_relaxed);
+    if (now > peak.load (std::memory_order_relaxed))
+        peak.store (now, std::memory_order_relaxed);
+}
+
+//==============================================================================
+void LuaCollector::attach (lua_State* state, const LuaAllocator& allocator)
+{
+    L = state;
+    pool = &allocator;
+    // small steps (1 KB of work each) so the budget is checked often
+    lua_gc (L, LUA_GCINC, 0, 0, 10);
+    lua_gc (L, LUA_GCSTOP);
+    collecting = false;
+    threshold = pool->getBytesUsed();
+    if (budgetTicks <= 0)
+        setBudget (0.0005);
+}
+
+void LuaCollector::setBudget (double seconds) noexcept
+{
+    budgetTicks = jmax ((int64) 1, Time::secondsToHighResolutionTicks (seconds));
+}
+
+void LuaCollector::step() noexcept
+{
+    if (L == nullptr)
+        return;
+
+    if (! collecting && pool->getBytesUsed() <= threshold)
+    {
+        lastTime.store (0.0, std::memory_order_relaxed);
+        return;
+    }
+
+    const auto start = Time::getHighResolutionTicks();
+    auto now = start;
+    collecting = true;
+
+    do
+    {
+        if (lua_gc (L, LUA_GCSTEP, 0) != 0)
+        {
+            // the cycle ended. wait for growth of half of what survived,
+            // the same pause Lua uses by default, before starting another.
+            collecting = false;
+            const auto live = pool->getBytesUsed();
+            threshold = live + jmax (live / 2, (size_t) 64 * 1024);
+        }
+
+        now = Time::getHighResolutionTicks();
+    } while (collecting && now - start < budgetTicks);
+
+    const auto elapsed = Time::highResolutionTicksToSeconds (now - start);
+    lastTime.store (elapsed, std::memory_order_relaxed);
+    if (elapsed > peakTime.load (std::memory_order_relaxed))
+        peakTime.store (elapsed, std::memory_order_relaxed);
+}
+
+} // namespace element
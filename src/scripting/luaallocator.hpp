@@ -0,0 +1,113 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <atomic>
+
+#include <element/juce/core.hpp>
+
+struct lua_State;
+
+namespace element {
+
+//==============================================================================
+/** A fixed pool of memory for one Lua state, so a script running on the
+    audio thread never calls the system allocator.
+
+    Blocks are kept in two-level segregated free lists (TLSF), so allocating
+    and freeing take the same time no matter how full or fragmented the pool
+    is. Neighbouring free blocks are merged when freed.
+
+    Like the Lua state it serves, it must only be used by one thread at a
+    time. The statistics can be read from any thread.
+ */
+class LuaAllocator final
+{
+public:
+    /** Create a pool. The memory is written here so the audio thread won't
+        fault pages in later. */
+    explicit LuaAllocator (size_t poolSize);
+    ~LuaAllocator();
+
+    /** A lua_Alloc function. Pass the allocator as its user data. */
+    static void* alloc (void* ud, void* ptr, size_t osize, size_t nsize) noexcept;
+
+    /** Returns nullptr if the pool has no block large enough. */
+    void* allocate (size_t size) noexcept;
+
+    /** Resize a block, in place when possible. Shrinking never fails. */
+    void* reallocate (void* ptr, size_t size) noexcept;
+
+    void deallocate (void* ptr) noexcept;
+
+    //==========================================================================
+    size_t getPoolSize() const noexcept { return poolSize; }
+    size_t getBytesUsed() const noexcept { return used.load (std::memory_order_relaxed); }
+    size_t getPeakBytesUsed() const noexcept { return peak.load (std::memory_order_relaxed); }
+    int getNumFailedAllocations() const noexcept { return failures.load (std::memory_order_relaxed); }
+
+private:
+    struct Block;
+    static constexpr size_t alignment = 16;
+    static constexpr int slLog2 = 4;
+    static constexpr int numSL = 1 << slLog2;
+    static constexpr int flShift = slLog2 + 4; // 4 == log2 (alignment)
+    static constexpr size_t smallSize = (size_t) 1 << flShift;
+    static constexpr int numFL = 32;
+
+    juce::HeapBlock<char> memory;
+    size_t poolSize = 0;
+
+    juce::uint32 flBitmap = 0;
+    juce::uint32 slBitmaps[numFL] = {};
+    Block* freeLists[numFL][numSL] = {};
+
+    std::atomic<size_t> used { 0 }, peak { 0 };
+    std::atomic<int> failures { 0 };
+
+    static size_t adjustSize (size_t size) noexcept;
+    static void mapping (size_t size, int& fl, int& sl) noexcept;
+    void insert (Block*) noexcept;
+    void remove (Block*) noexcept;
+    Block* findFree (size_t size) noexcept;
+    void trim (Block*, size_t size) noexcept;
+    void addUsed (size_t added, size_t removed) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE (LuaAllocator)
+};
+
+//==============================================================================
+/** Runs a Lua state's garbage collector in steps with a time budget, so a
+    collection never lands in the middle of a block.
+ */
+class LuaCollector final
+{
+public:
+    LuaCollector() = default;
+
+    /** Stop the state's automatic collection. From now on the collector only
+        runs in step(), or in an emergency when the pool is full. */
+    void attach (lua_State* state, const LuaAllocator& allocator);
+
+    /** Set the time one step may take. */
+    void setBudget (double seconds) noexcept;
+
+    /** Collect until the budget runs out or a cycle ends (audio thread).
+        Does nothing until memory has grown since the last cycle ended. */
+    void step() noexcept;
+
+    /** Seconds the last step took, and the longest since attaching. */
+    double getLastStepTime() const noexcept { return lastTime.load (std::memory_order_relaxed); }
+    double getPeakStepTime() const noexcept { return peakTime.load (std::memory_order_relaxed); }
+
+private:
+    lua_State* L = nullptr;
+    const LuaAllocator* pool = nullptr;
+    juce::int64 budgetTicks = 0;
+    size_t threshold = 0;
+    bool collecting = false;
+    std::atomic<double> lastTime { 0.0 }, peakTime { 0.0 };
+};
+
+} // namespace element
@@ -14,6 +14,7 @@
 #include "engine/graphmanager.hpp"
 #include "nodes/mididevice.hpp"
 #include "engine/rootgraph.hpp"
+#include "engine/standbygraphs.hpp"
 #include <element/engine.hpp>
 #include <element/ui.hpp>
 
@@ -21,9 +22,10 @@ namespace element {
 
 struct RootGraphHolder
 {
-    RootGraphHolder (const Node& n, Context& world)
-        : plugins (world.plugins()),
-          devices (world.devices()),
+    RootGraphHolder (const Node& n, EngineService& es)
+        : owner (es),
+          plugins (es.context().plugins()),
+          devices (es.context().devices()),
           model (n)
     {
     }
@@ -42,8 +44,11 @@ struct RootGraphHolder
     /** This will create a root graph processor/controller and load it if not
         done already. Properties are set from the model, so make sure they are
         correct before calling this 
+
+        Pass load = false to attach an empty graph, which loads later through
+        EngineService::updateStandbyGraphs.
      */
-    bool attach (AudioEnginePtr engine)
+    bool attach (AudioEnginePtr engine, bool load = true)
     {
         jassert (engine);
         if (! engine)
@@ -87,9 +92,14 @@ struct RootGraphHolder
             if (engine->addGraph (root))
             {
                 controller = std::make_unique<RootGraphManager> (*root, plugins);
+                // reports arrive later, so don't depend on this holder
+                controller->onLoadProgress = [&service = owner, graph = model] (int numLoaded, int numNodes) {
+                    service.sigGraphLoadProgress (graph, numLoaded, numNodes);
+                };
                 model.setProperty (tags::object, node.get());
 
-                controller->setNodeModel (model);
+                if (load)
+                    controller->setNodeModel (model);
             }
             else
             {
@@ -129,6 +139,7 @@ struct RootGraphHolder
 private:
     friend class EngineService;
     friend class EngineService::RootGraphs;
+    EngineService& owner;
     PluginManager& plugins;
     DeviceManager& devices;
     std::unique_ptr<RootGraphManager> controller;
@@ -153,6 +164,7 @@ public:
     void clear()
     {
         detachAll();
+        standby.clear();
         graphs.clear();
     }
 
@@ -239,9 +251,13 @@ public:
     // remove the holder, this will also delete it!
     void remove (RootGraphHolder* g)
     {
+        standby.remove (g);
         graphs.removeObject (g, true);
     }
 
+    /** Which graphs stay loaded in setlist mode */
+    StandbyGraphs<RootGraphHolder>& getStandby() { return standby; }
+
     const OwnedArray<RootGraphHolder>& getGraphs() const { return graphs; }
 
 private:
@@ -249,6 +265,7 @@ private:
     SessionPtr session;
     AudioEnginePtr engine;
     OwnedArray<RootGraphHolder> graphs;
+    StandbyGraphs<RootGraphHolder> standby;
 };
 
 EngineService::EngineService()
@@ -308,7 +325,7 @@ void EngineService::addGraph (const Node& newGraph, bool makeActive)
         return;
     }
 
-    if (auto* holder = graphs->add (new RootGraphHolder (node, context())))
+    if (auto* holder = graphs->add (new RootGraphHolder (node, *this)))
     {
         if (holder->attach (engine))
         {
@@ -701,6 +718,9 @@ void EngineService::activate()
     auto session (globals.session());
     engine->setSession (session);
     engine->activate();
+    activeGraphChangedConnection = engine->activeGraphChanged.connect ([this] (int) {
+        updateStandbyGraphs();
+    });
 
     sessionReloaded();
 }
@@ -719,6 +739,7 @@ void EngineService::deactivate()
         gui->closeAllPluginWindows();
     }
 
+    activeGraphChangedConnection.disconnect();
     session->saveGraphState();
     graphs->clear();
 
@@ -743,7 +764,7 @@ void EngineService::setRootNode (const Node& newRootNode)
     if (! holder)
     {
         jassertfalse; // you should have a root graph registered before calling this.
-        holder = graphs->add (new RootGraphHolder (newRootNode, context()));
+        holder = graphs->add (new RootGraphHolder (newRootNode, *this));
     }
 
     if (! holder)
@@ -808,6 +829,58 @@ void EngineService::setRootNode (const Node& newRootNode)
     }
 
     engine->refreshSession();
+    updateStandbyGraphs();
+}
+
+void EngineService::updateStandbyGraphs()
+{
+    auto session = context().session();
+    auto* const active = graphs->findActive();
+    if (session == nullptr || active == nullptr)
+        return;
+
+    auto& settings = context().settings();
+    const bool setlist = settings.useSetlistMode();
+
+    Array<RootGraphHolder*> set;
+    for (int i = 0; i < session->getNumGraphs(); ++i)
+        set.add (graphs->findFor (session->getGraph (i)));
+    // parallel graphs render next to the active one, so they never stand by
+    const auto keep = graphs->getStandby().choose (
+        set, set.indexOf (active), settings.getNumStandbyGraphs(), [] (RootGraphHolder* h) {
+            auto* const root = h->getRootGraph();
+            return root == nullptr || root->isSingle();
+        });
+
+    auto& devices = context().devices();
+    for (auto* h : graphs->getGraphs())
+    {
+        auto* const controller = h->getController();
+        if (controller == nullptr)
+            continue;
+
+        if (! setlist || keep.contains (h))
+        {
+            if (! controller->isLoaded())
+            {
+                controller->getRootGraph().setPlayConfigFor (devices);
+                controller->setNodeModel (h->model);
+            }
+        }
+        else if (controller->isLoaded())
+        {
+            if (auto* gui = sibling<UI>())
+            {
+                h->model.forEach ([gui] (const ValueTree& tree) {
+                    if (tree.hasType (types::Node))
+                        gui->closePluginWindowsFor (Node (tree, false), false);
+                });
+            }
+
+            controller->unloadGraph();
+            DBG ("[element] graph on standby unloaded: " << h->model.getName());
+        }
+    }
 }
 
 void EngineService::syncModels()
@@ -904,12 +977,14 @@ void EngineService::sessionReloaded()
 
     if (session->getNumGraphs() > 0)
     {
+        // in setlist mode, setRootNode loads the active graph and its standbys
+        const bool loadAll = ! context().settings().useSetlistMode();
         for (int i = 0; i < session->getNumGraphs(); ++i)
         {
             Node rootGraph (session->getGraph (i));
-            if (auto* holder = graphs->add (new RootGraphHolder (rootGraph, context())))
+            if (auto* holder = graphs->add (new RootGraphHolder (rootGraph, *this)))
             {
-                if (! holder->attach (engine))
+                if (! holder->attach (engine, loadAll))
                 {
                     std::clog << "[element] failed attaching root grapn: " << holder->model.getName() << std::endl;
                 }
@@ -267,9 +267,7 @@ void SessionService::loadNewSessionData()
 
     if (file.existsAsFile())
     {
-        ValueTree data;
-        if (auto xml = XmlDocument::parse (file))
-            data = ValueTree::fromXml (*xml);
+        const auto data = Session::readFromFile (file);
         if (data.isValid() && data.hasType (types::Session) && EL_SESSION_VERSION == (int) data.getProperty (tags::version))
             wasLoaded = currentSession->loadData (data);
     }
@@ -11,11 +11,16 @@
 
 #include "nodes/nodetypes.hpp"
 #include "engine/ionode.hpp"
+#include "session/pluginscancache.hpp"
 #include "datapath.hpp"
 #include "utils.hpp"
 
 #define EL_DEAD_AUDIO_PLUGINS_FILENAME "scanner/crashed.txt"
 #define EL_PLUGIN_SCANNER_SLAVE_LIST_PATH "scanner/list.xml"
+#define EL_PLUGIN_SCANNER_WORKER_LIST_FORMAT "scanner/list-%d.xml"
+#define EL_PLUGIN_SCANNER_WORKER_JOURNAL_FORMAT "scanner/journal-%d.txt"
+#define EL_PLUGIN_SCANNER_CACHE_PATH "scanner/cache.xml"
+#define EL_PLUGIN_SCANNER_WORKER_CACHE_FORMAT "scanner/cache-%d.xml"
 #define EL_PLUGIN_SCANNER_WAITING_STATE "waiting"
 #define EL_PLUGIN_SCANNER_READY_STATE "ready"
 
@@ -57,6 +62,33 @@ static File scannerExeFullPath()
     return scannerExe;
 }
 
+/** The list each scanner process writes while scanning. */
+static File workerListFile (int slot)
+{
+    return DataPath::applicationDataDir().getChildFile (
+        String (EL_PLUGIN_SCANNER_WORKER_LIST_FORMAT).replace ("%d", String (slot)));
+}
+
+/** What each scanner process has done since writing its list. */
+static File workerJournalFile (int slot)
+{
+    return DataPath::applicationDataDir().getChildFile (
+        String (EL_PLUGIN_SCANNER_WORKER_JOURNAL_FORMAT).replace ("%d", String (slot)));
+}
+
+/** What every file looked like when it was last scanned. */
+static File scanCacheFile()
+{
+    return DataPath::applicationDataDir().getChildFile (EL_PLUGIN_SCANNER_CACHE_PATH);
+}
+
+/** The files each scanner process has scanned so far. */
+static File workerScanCacheFile (int slot)
+{
+    return DataPath::applicationDataDir().getChildFile (
+        String (EL_PLUGIN_SCANNER_WORKER_CACHE_FORMAT).replace ("%d", String (slot)));
+}
+
 } // namespace detail
 
 //==============================================================================
@@ -64,7 +96,12 @@ class PluginScannerCoordinator : public juce::ChildProcessCoordinator,
                                  public AsyncUpdater
 {
 public:
-    explicit PluginScannerCoordinator (PluginScanner& o) : owner (o) {}
+    /** Create a coordinator for one of several scanner processes.
+        @param slot     Which share of the plugin files this scanner gets.
+        @param numSlots The number of scanners splitting the files.
+     */
+    PluginScannerCoordinator (PluginScanner& o, int slot_, int numSlots_)
+        : owner (o), slot (slot_), numSlots (numSlots_) {}
     ~PluginScannerCoordinator() {}
 
     bool startScanning (const StringArray& names = StringArray())
@@ -76,6 +113,7 @@ public:
             ScopedLock sl (lock);
             slaveState = EL_PLUGIN_SCANNER_WAITING_STATE;
             running = false;
+            finished = false;
             formatNames = names;
         }
 
@@ -86,7 +124,9 @@ public:
             running = res;
         }
 
-        DBG ("[element] scanner launched: " << (isRunning() ? "yes" : "no"));
+        DBG ("[element] scanner " << slot << " launched: " << (isRunning() ? "yes" : "no"));
+        if (! res)
+            setFinished();
         return res;
     }
 
@@ -115,10 +155,12 @@ public:
         }
         else if (type == "progress")
         {
-            float newProgress = (float) var (message);
-            owner.listeners.call (&PluginScanner::Listener::audioPluginScanProgress, newProgress);
-            ScopedLock sl (lock);
-            progress = newProgress;
+            {
+                ScopedLock sl (lock);
+                progress = (float) var (message);
+            }
+
+            owner.workerProgressChanged();
         }
     }
 
@@ -139,7 +181,7 @@ public:
         if (state == "ready" && isRunning())
         {
             String msg = "scan:";
-            msg << formatNames.joinIntoString (",");
+            msg << slot << ":" << numSlots << ":" << formatNames.joinIntoString (",");
             MemoryBlock mb (msg.toRawUTF8(), msg.length());
             sendMessageToWorker (mb);
         }
@@ -148,7 +190,7 @@ public:
             if (! isRunning())
             {
                 DBG ("[element] a plugin crashed or timed out during scan");
-                updateListAndLaunchWorker();
+                relaunchWorker();
             }
             else
             {
@@ -157,7 +199,7 @@ public:
         }
         else if (state == EL_PLUGIN_SCANNER_FINISHED_ID)
         {
-            DBG ("[element] worker finished scanning");
+            DBG ("[element] worker " << slot << " finished scanning");
             sendQuitMessage();
             killWorkerProcess();
 
@@ -167,14 +209,14 @@ public:
                 slaveState = "idle";
             }
 
-            owner.listeners.call (&PluginScanner::Listener::audioPluginScanFinished);
+            setFinished();
         }
         else if (state == EL_PLUGIN_SCANNER_WAITING_STATE)
         {
             if (! isRunning())
             {
                 DBG ("[element] waiting for plugin scanner");
-                updateListAndLaunchWorker();
+                relaunchWorker();
             }
         }
         else if (slaveState == "quitting")
@@ -196,7 +238,13 @@ public:
     float getProgress() const
     {
         ScopedLock sl (lock);
-        return progress;
+        return finished ? 1.f : jmax (0.f, progress);
+    }
+
+    bool isFinished() const
+    {
+        ScopedLock sl (lock);
+        return finished;
     }
 
     bool isRunning() const
@@ -214,9 +262,11 @@ public:
 
 private:
     PluginScanner& owner;
+    const int slot, numSlots;
 
     CriticalSection lock;
     bool running = false;
+    bool finished = false;
     float progress = 0.f;
     String slaveState;
     StringArray formatNames;
@@ -224,14 +274,30 @@ private:
 
     String pluginBeingScanned;
 
-    void updateListAndLaunchWorker()
+    void setFinished()
     {
-        if (auto xml = XmlDocument::parse (PluginScanner::getWorkerPluginListFile()))
-            owner.list.recreateFromXml (*xml);
+        {
+            ScopedLock sl (lock);
+            if (finished)
+                return;
+            finished = true;
+        }
+
+        owner.workerFinished();
+    }
 
+    /** The worker picks up where it left off from its own list and journal.
+        It blacklists the plugin which crashed from the journal. */
+    void relaunchWorker()
+    {
         const bool res = launchScanner();
-        ScopedLock sl (lock);
-        running = res;
+        {
+            ScopedLock sl (lock);
+            running = res;
+        }
+
+        if (! res)
+            setFinished();
     }
 
     void resetScannerVariables()
@@ -267,7 +333,6 @@ class PluginScannerWorker : public juce::ChildProcessWorker,
 public:
     PluginScannerWorker()
     {
-        scanFile = PluginScanner::getWorkerPluginListFile();
         SystemStats::setApplicationCrashHandler (detail::pluginScannerCrashHandler);
         auto logfile = DataPath::applicationDataDir().getChildFile ("log/scanner.log");
         logfile.create();
@@ -296,22 +361,25 @@ public:
 
         if (type == "scan")
         {
-            const auto formats (StringArray::fromTokens (message.trim(), ",", "'"));
-            formatsToScan = formats;
+            // scan:<slot>:<number of slots>:<formats>
+            const auto parts (StringArray::fromTokens (message.trim(), ":", "'"));
+            slot = jmax (0, parts[0].getIntValue());
+            numSlots = jmax (1, parts[1].getIntValue());
+            formatsToScan = StringArray::fromTokens (parts[2], ",", "'");
             triggerAsyncUpdate();
         }
     }
 
     void handleAsyncUpdate() override
     {
-        if (! scanFile.existsAsFile())
-        {
-            sendState ("scanning");
-            sendState (EL_PLUGIN_SCANNER_FINISHED_ID);
-            return;
-        }
+        scanFile = detail::workerListFile (slot);
+        resultsFile = detail::workerScanCacheFile (slot);
+        journalFile = detail::workerJournalFile (slot);
 
-        updateScanFileWithSettings();
+        loadScanCache();
+        loadPluginList();
+        journal = std::make_unique<PluginScanJournal> (journalFile);
+        stamps.clear();
 
         sendState ("scanning");
 
@@ -321,7 +389,6 @@ public:
             scanFor (format);
         }
 
-        settings->saveIfNeeded();
         logger->logMessage ("[scanner] finished");
         sendState (EL_PLUGIN_SCANNER_FINISHED_ID);
     }
@@ -349,17 +416,9 @@ public:
         plugins = std::make_unique<PluginManager>();
         logger->logMessage ("[scanner] created global objects");
 
-        if (! scanFile.existsAsFile())
-            scanFile.create();
-
-        if (auto xml = XmlDocument::parse (scanFile))
-            pluginList.recreateFromXml (*xml);
-
         logger->logMessage ("[scanner] processing blacklist");
-        // This must happen before user settings, PluginManager will delete the deadman file
-        // when restoring user plugins
-        PluginDirectoryScanner::applyBlacklistingsFromDeadMansPedal (
-            pluginList, plugins->getDeadAudioPluginsFile());
+        crashed = StringArray::fromLines (plugins->getDeadAudioPluginsFile().loadFileAsString());
+        crashed.removeEmptyStrings();
 
         logger->logMessage ("[scanner] setting up formats");
         auto& nf = plugins->getNodeFactory();
@@ -367,8 +426,16 @@ public:
         plugins->addDefaultFormats();
         logger->logMessage ("[scanner] restoring plugin list");
         {
+            // read only. the coordinator owns the settings and plugin list
+            // files, and every worker running this at once would race on them.
             juce::MessageManagerLock mml;
-            plugins->restoreUserPlugins (*settings);
+            auto xml = XmlDocument::parse (detail::pluginsXmlFile());
+            if (xml == nullptr)
+                if (auto* props = settings->getUserSettings())
+                    xml = props->getXmlValue (detail::pluginListKey());
+            if (xml != nullptr)
+                plugins->getKnownPlugins().recreateFromXml (*xml);
+            plugins->scanInternalPlugins();
         }
 
         logger->logMessage ("[scanner] scanner notify read!");
@@ -383,31 +450,66 @@ public:
         logger.reset();
         settings = nullptr;
         plugins = nullptr;
-        scanner = nullptr;
         Process::terminate();
     }
 
 private:
     std::unique_ptr<Settings> settings;
     std::unique_ptr<PluginManager> plugins;
-    std::unique_ptr<PluginDirectoryScanner> scanner;
-    String fileOrIdentifier;
     KnownPluginList pluginList;
-    StringArray filesToSkip;
-    File scanFile;
+    File scanFile, resultsFile, journalFile;
     StringArray formatsToScan;
+    StringArray crashed;
+    int slot = 0, numSlots = 1;
+
+    PluginScanCache cache; ///< what the last scan found, read only
+    PluginScanCache results; ///< what this scan has found so far
+    std::unique_ptr<PluginScanJournal> journal;
+    std::map<String, PluginScanCache::Stamp> stamps; ///< per file or bundle, this scan only
 
     std::unique_ptr<juce::FileLogger> logger;
 
-    void applyDeadPlugins()
+    /** Start from the user's list the first time, or restore what an earlier
+        run of this worker already scanned, and blacklist the plugin it crashed
+        on, if any. Nothing gets written after this, only journaled. */
+    void loadPluginList()
     {
-        PluginDirectoryScanner::applyBlacklistingsFromDeadMansPedal (
-            pluginList, plugins->getDeadAudioPluginsFile());
+        if (auto xml = XmlDocument::parse (scanFile))
+        {
+            pluginList.recreateFromXml (*xml);
+        }
+        else
+        {
+            for (const auto& file : crashed)
+                pluginList.addToBlacklist (file);
+            updateScanFileWithSettings();
+        }
+
+        const auto crashedOn = PluginScanJournal::replay (journalFile, pluginList, results);
+        if (crashedOn.isNotEmpty())
+        {
+            crashed.addIfNotAlreadyThere (crashedOn);
+            pluginList.addToBlacklist (crashedOn);
+        }
+    }
+
+    /** Load the last scan's cache. Results start with everything the cache
+        knows about formats which aren't being scanned, unless an earlier run
+        of this worker already saved them. */
+    void loadScanCache()
+    {
+        cache.load (detail::scanCacheFile());
+        if (results.load (resultsFile))
+            return;
+
+        results = cache;
+        for (const auto& format : formatsToScan)
+            results.removeFormat (format);
+        results.save (resultsFile);
     }
 
     bool writePluginListNow()
     {
-        applyDeadPlugins();
         if (auto xml = pluginList.createXml())
         {
             return xml->writeTo (scanFile);
@@ -415,6 +517,127 @@ private:
         return false;
     }
 
+    /** Stamps are kept for the whole scan. An LV2 bundle holding many
+        plugins is walked and hashed once, not once per plugin. */
+    PluginScanCache::Stamp stampFor (const String& path)
+    {
+        if (! File::isAbsolutePath (path))
+            return {};
+
+        auto it = stamps.find (path);
+        if (it == stamps.end())
+            it = stamps.emplace (path, PluginScanCache::stampFor (File (path))).first;
+        return it->second;
+    }
+
+    /** Record what the list holds for a file in the results and journal. */
+    void remember (const String& format, const String& file, const PluginScanCache::Stamp& stamp)
+    {
+        Array<PluginDescription> types;
+        for (const auto& type : pluginList.getTypes())
+            if (type.fileOrIdentifier == file)
+                types.add (type);
+
+        const bool failed = pluginList.getBlacklistedFiles().contains (file);
+        if (stamp.isValid())
+            results.set (format, file, stamp, types, failed);
+        if (journal != nullptr)
+            journal->found (format, file, stamp, types, failed);
+    }
+
+    /** Remove everything the list knows about a file, so it gets scanned again. */
+    void forget (const String& file)
+    {
+        for (const auto& type : pluginList.getTypes())
+            if (type.fileOrIdentifier == file)
+                pluginList.removeType (type);
+        pluginList.removeFromBlacklist (file);
+    }
+
+    /** Remove types of a format whose files aren't in this worker's share,
+        and blacklist entries for files another worker scans. That drops
+        files which are gone, and leaves every other file to the worker
+        scanning it, so the merged lists don't disagree.
+        @param files  This worker's share
+        @param all    Every file of the format, from all the shares
+     */
+    void forgetAllBut (const String& format, const StringArray& files, const StringArray& all)
+    {
+        const auto drop = [this, &format] (const String& file) {
+            results.remove (format, file);
+            if (journal != nullptr)
+                journal->dropped (format, file);
+        };
+
+        for (const auto& type : pluginList.getTypes())
+        {
+            if (type.pluginFormatName == format && ! files.contains (type.fileOrIdentifier))
+            {
+                pluginList.removeType (type);
+                drop (type.fileOrIdentifier);
+            }
+        }
+
+        for (const auto& file : pluginList.getBlacklistedFiles())
+        {
+            if (all.contains (file) && ! files.contains (file))
+            {
+                pluginList.removeFromBlacklist (file);
+                drop (file);
+            }
+        }
+    }
+
+    /** Decide whether a file needs loading. Files which haven't changed since
+        the last scan get what was found then without loading them, and files
+        which have are forgotten so they load again.
+        @param known Whether the list already has an up to date listing, used
+                     for files the cache doesn't know about.
+     */
+    bool needsScanning (const String& format, const String& file,
+                        const PluginScanCache::Stamp& stamp, bool known)
+    {
+        if (crashed.contains (file))
+        {
+            remember (format, file, stamp);
+            return false;
+        }
+
+        Array<PluginDescription> types;
+        bool failed = false;
+        auto result = results.lookup (format, file, stamp, types, failed);
+        if (result != PluginScanCache::unchanged)
+            result = cache.lookup (format, file, stamp, types, failed);
+
+        switch (result)
+        {
+            case PluginScanCache::unchanged: {
+                forget (file);
+                if (failed)
+                    pluginList.addToBlacklist (file);
+                for (const auto& type : types)
+                    pluginList.addType (type);
+                remember (format, file, stamp);
+                return false;
+            }
+
+            case PluginScanCache::changed:
+                forget (file);
+                return true;
+
+            case PluginScanCache::missing:
+                break;
+        }
+
+        if (known || pluginList.getBlacklistedFiles().contains (file))
+        {
+            remember (format, file, stamp);
+            return false;
+        }
+
+        return true;
+    }
+
     bool sendState (const String& state)
     {
         return sendString ("state", state);
@@ -428,22 +651,16 @@ private:
         return sendMessageToCoordinator (mb);
     }
 
-    bool doNextScan()
+    /** Returns this worker's share of the files. Every worker sorts the same
+        list, so the shares don't overlap. Taking every n-th file spreads
+        each vendor's folder over all the workers. */
+    StringArray getFilesForThisWorker (StringArray files) const
     {
-        const auto nextFile = scanner->getNextPluginFileThatWillBeScanned();
-        sendString ("name", nextFile);
-        logger->logMessage (String ("[scanner] scan: ") + nextFile);
-
-        for (const auto& file : scanner->getFailedFiles())
-            pluginList.addToBlacklist (file);
-
-        if (scanner->scanNextFile (true, fileOrIdentifier))
-        {
-            writePluginListNow();
-            return true;
-        }
-
-        return false;
+        files.sort (true);
+        StringArray share;
+        for (int i = slot; i < files.size(); i += numSlots)
+            share.add (files[i]);
+        return share;
     }
 
     void scanFor (const String& formatName)
@@ -467,17 +684,24 @@ private:
         {
             if (p->format() != "LV2")
                 continue;
-            const auto types = p->findTypes();
+            auto* lv2 = dynamic_cast<LV2NodeProvider*> (p);
+            const auto all = p->findTypes();
+            const auto types = getFilesForThisWorker (all);
+            forgetAllBut ("LV2", types, all);
+
             float step = 1.f;
             for (const auto& tp : types)
             {
-                if (! pluginList.getBlacklistedFiles().contains (tp) && pluginList.getTypeForFile (tp) == nullptr)
+                const auto stamp = lv2 != nullptr ? stampFor (lv2->bundleForURI (tp))
+                                                  : PluginScanCache::Stamp();
+                if (needsScanning ("LV2", tp, stamp, pluginList.getTypeForFile (tp) != nullptr))
                 {
                     sendString ("name", tp.trim());
                     logger->logMessage (String ("[scanner] scan: ") + tp);
-                    OwnedArray<PluginDescription> dc;
+
+                    // if this crashes the coordinator restarts us and the journal blacklists it
+                    journal->scanning ("LV2", tp);
                     pluginList.addToBlacklist (tp);
-                    writePluginListNow();
 
                     if (auto inst = p->create (tp))
                     {
@@ -485,8 +709,9 @@ private:
                         PluginDescription desc;
                         inst->getPluginDescription (desc);
                         pluginList.addType (desc);
-                        writePluginListNow();
                     }
+
+                    remember ("LV2", tp, stamp);
                 }
 
                 sendString ("progress", String (step / (float) types.size()));
@@ -502,37 +727,78 @@ private:
 
         const auto key = String (settings->lastPluginScanPathPrefix) + format.getName();
         FileSearchPath path (settings->getUserSettings()->getValue (key));
-        scanner = std::make_unique<PluginDirectoryScanner> (pluginList, format, path, true, plugins->getDeadAudioPluginsFile(), false);
+        const auto all = format.searchPathsForPlugins (path, true, false);
+        const auto files = getFilesForThisWorker (all);
+        forgetAllBut (format.getName(), files, all);
 
-        while (doNextScan())
-            sendString ("progress", String (scanner->getProgress()));
+        for (int i = 0; i < files.size(); ++i)
+        {
+            scanPluginFile (format, files[i]);
+            sendString ("progress", String ((float) (i + 1) / (float) files.size()));
+        }
 
-        writePluginListNow();
 #if JUCE_LINUX
         Thread::sleep (1000);
 #endif
     }
+
+    void scanPluginFile (AudioPluginFormat& format, const String& file)
+    {
+        const auto formatName = format.getName();
+        const auto stamp = stampFor (file);
+        if (! needsScanning (formatName, file, stamp, pluginList.isListingUpToDate (file, format)))
+            return;
+
+        sendString ("name", file);
+        logger->logMessage (String ("[scanner] scan: ") + file);
+
+        // if this crashes the coordinator restarts us and the journal blacklists it
+        journal->scanning (formatName, file);
+        OwnedArray<PluginDescription> found;
+        pluginList.scanAndAddFile (file, true, found, format);
+
+        if (found.isEmpty())
+            pluginList.addToBlacklist (file);
+
+        remember (formatName, file, stamp);
+    }
 };
 
 //==============================================================================
-PluginScanner::PluginScanner (KnownPluginList& listToManage) : list (listToManage) {}
+PluginScanner::PluginScanner (KnownPluginList& listToManage)
+    : list (listToManage),
+      numWorkers (getDefaultNumWorkers()) {}
+
 PluginScanner::~PluginScanner()
 {
     listeners.clear();
-    master.reset();
+    coordinators.clear();
+}
+
+int PluginScanner::getDefaultNumWorkers()
+{
+    return jlimit (1, 8, SystemStats::getNumCpus());
 }
 
 void PluginScanner::cancel()
 {
-    if (master)
+    for (auto* coordinator : coordinators)
     {
-        master->handleUpdateNowIfNeeded();
-        master->sendQuitMessage();
-        master.reset();
+        coordinator->handleUpdateNowIfNeeded();
+        coordinator->sendQuitMessage();
     }
+
+    coordinators.clear();
+    stopTimer();
 }
 
-bool PluginScanner::isScanning() const { return master && master->isRunning(); }
+bool PluginScanner::isScanning() const
+{
+    for (const auto* coordinator : coordinators)
+        if (coordinator->isRunning())
+            return true;
+    return false;
+}
 
 void PluginScanner::scanForAudioPlugins (const juce::String& formatName)
 {
@@ -543,15 +809,121 @@ void PluginScanner::scanForAudioPlugins (const StringArray& formats)
 {
     cancel();
     getWorkerPluginListFile().deleteFile();
-    if (master == nullptr)
-        master.reset (new PluginScannerCoordinator (*this));
-    if (master->isRunning())
-        return;
-    master->startScanning (formats);
+    formatsToScan = formats;
+    retriedSlots.clearQuick();
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        detail::workerListFile (i).deleteFile();
+        detail::workerJournalFile (i).deleteFile();
+        detail::workerScanCacheFile (i).deleteFile();
+        coordinators.add (new PluginScannerCoordinator (*this, i, numWorkers));
+    }
+
+    for (auto* coordinator : coordinators)
+        coordinator->startScanning (formats);
+}
+
+void PluginScanner::workerProgressChanged()
+{
+    float progress = 0.f;
+    for (const auto* coordinator : coordinators)
+        progress += coordinator->getProgress();
+    progress /= (float) jmax (1, coordinators.size());
+    listeners.call (&PluginScanner::Listener::audioPluginScanProgress, progress);
+}
+
+void PluginScanner::workerFinished()
+{
+    for (const auto* coordinator : coordinators)
+        if (! coordinator->isFinished())
+            return;
+
+    // finish from the timer, listeners may delete the coordinators
+    startTimer (1);
 }
 
 void PluginScanner::timerCallback()
 {
+    stopTimer();
+    for (const auto* coordinator : coordinators)
+        if (! coordinator->isFinished())
+            return;
+
+    // a worker which couldn't launch, or kept dying, left no list. scan its
+    // share once more before giving up on it.
+    Array<int> missing;
+    for (int i = 0; i < coordinators.size(); ++i)
+        if (! detail::workerListFile (i).existsAsFile())
+            missing.add (i);
+
+    if (! missing.isEmpty() && retriedSlots.isEmpty())
+    {
+        retriedSlots = missing;
+        for (const auto slot : missing)
+        {
+            Logger::writeToLog ("[element] plugin scanner " + String (slot) + " left no results, scanning its share again");
+            coordinators.getUnchecked (slot)->startScanning (formatsToScan);
+        }
+        return;
+    }
+
+    // compact each worker's list and journal into the final list and cache.
+    // every worker's cache holds the formats it didn't scan as well.
+    KnownPluginList merged;
+    PluginScanCache cache;
+    bool anyResults = false;
+
+    for (int i = 0; i < coordinators.size(); ++i)
+    {
+        auto xml = XmlDocument::parse (detail::workerListFile (i));
+        if (xml == nullptr)
+            continue;
+
+        KnownPluginList results;
+        results.recreateFromXml (*xml);
+        PluginScanCache scanned;
+        const bool hasCache = scanned.load (detail::workerScanCacheFile (i));
+        PluginScanJournal::replay (detail::workerJournalFile (i), results, scanned);
+
+        for (const auto& type : results.getTypes())
+            merged.addType (type);
+        // each worker only keeps blacklist entries for its own share
+        for (const auto& file : results.getBlacklistedFiles())
+            merged.addToBlacklist (file);
+
+        if (hasCache)
+        {
+            cache.addFrom (scanned);
+            anyResults = true;
+        }
+    }
+
+    if (! missing.isEmpty())
+    {
+        // keep what the list had for files no worker reported on, rather than
+        // losing a whole share. they aren't in the cache, so the next scan
+        // loads them again.
+        for (const auto& type : list.getTypes())
+            if (merged.getTypeForFile (type.fileOrIdentifier) == nullptr
+                && ! merged.getBlacklistedFiles().contains (type.fileOrIdentifier))
+                merged.addType (type);
+        for (const auto& file : list.getBlacklistedFiles())
+            if (merged.getTypeForFile (file) == nullptr)
+                merged.addToBlacklist (file);
+
+        const auto message = String (missing.size()) + " of " + String (coordinators.size())
+                             + " plugin scanners failed, some plugins were not rescanned";
+        Logger::writeToLog ("[element] " + message);
+        listeners.call (&PluginScanner::Listener::audioPluginScanFailed, message);
+    }
+
+    if (auto xml = merged.createXml())
+        xml->writeTo (getWorkerPluginListFile());
+    if (anyResults)
+        cache.save (detail::scanCacheFile());
+
+    listeners.call (&PluginScanner::Listener::audioPluginScanFinished);
 }
 
 //==============================================================================
@@ -0,0 +1,277 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include "session/pluginscancache.hpp"
+
+namespace element {
+using namespace juce;
+
+namespace detail {
+static void writeStamp (XmlElement& e, const PluginScanCache::Stamp& stamp)
+{
+    e.setAttribute ("modified", String (stamp.modified));
+    e.setAttribute ("size", String (stamp.size));
+    e.setAttribute ("hash", stamp.hash);
+}
+
+static PluginScanCache::Stamp readStamp (const XmlElement& e)
+{
+    PluginScanCache::Stamp stamp;
+    stamp.modified = e.getStringAttribute ("modified").getLargeIntValue();
+    stamp.size = e.getStringAttribute ("size").getLargeIntValue();
+    stamp.hash = e.getStringAttribute ("hash");
+    return stamp;
+}
+
+static void writeTypes (XmlElement& e, const Array<PluginDescription>& types)
+{
+    for (const auto& desc : types)
+        e.addChildElement (desc.createXml().release());
+}
+
+static Array<PluginDescription> readTypes (const XmlElement& e)
+{
+    Array<PluginDescription> types;
+    for (const auto* t : e.getChildIterator())
+    {
+        PluginDescription desc;
+        if (desc.loadFromXml (*t))
+            types.add (desc);
+    }
+    return types;
+}
+} // namespace detail
+
+PluginScanCache::Stamp PluginScanCache::stampFor (const File& file)
+{
+    Stamp stamp;
+    if (! file.exists())
+        return stamp;
+
+    stamp.modified = file.getLastModificationTime().toMilliseconds();
+
+    if (! file.isDirectory())
+    {
+        stamp.size = file.getSize();
+        return stamp;
+    }
+
+    // the hash covers names, sizes and times, reading contents would cost as
+    // much as loading the plugin.
+    String summary;
+    for (const auto& entry : RangedDirectoryIterator (file, true, "*", File::findFiles))
+    {
+        const auto& child = entry.getFile();
+        summary << child.getRelativePathFrom (file) << ':'
+                << entry.getFileSize() << ':'
+                << entry.getModificationTime().toMilliseconds() << '\n';
+        stamp.size += entry.getFileSize();
+        stamp.modified = jmax (stamp.modified, entry.getModificationTime().toMilliseconds());
+    }
+
+    stamp.hash = String::toHexString (summary.hashCode64());
+    return stamp;
+}
+
+String PluginScanCache::keyFor (const String& format, const String& file)
+{
+    return format + "|" + file;
+}
+
+PluginScanCache::Result PluginScanCache::lookup (const String& format,
+                                                 const String& file,
+                                                 const Stamp& stamp,
+                                                 Array<PluginDescription>& types,
+                                                 bool& failed) const
+{
+    auto iter = entries.find (keyFor (format, file));
+    if (iter == entries.end())
+        return missing;
+
+    const auto& entry = iter->second;
+    if (! stamp.isValid() || entry.stamp != stamp)
+        return changed;
+
+    types = entry.types;
+    failed = entry.failed;
+    return unchanged;
+}
+
+void PluginScanCache::set (const String& format,
+                           const String& file,
+                           const Stamp& stamp,
+                           const Array<PluginDescription>& types,
+                           bool failed)
+{
+    auto& entry = entries[keyFor (format, file)];
+    entry.format = format;
+    entry.file = file;
+    entry.stamp = stamp;
+    entry.failed = failed;
+    entry.types = types;
+}
+
+void PluginScanCache::remove (const String& format, const String& file)
+{
+    entries.erase (keyFor (format, file));
+}
+
+void PluginScanCache::removeFormat (const String& format)
+{
+    for (auto iter = entries.begin(); iter != entries.end();)
+    {
+        if (iter->second.format == format)
+            iter = entries.erase (iter);
+        else
+            ++iter;
+    }
+}
+
+void PluginScanCache::addFrom (const PluginScanCache& other)
+{
+    for (const auto& [key, entry] : other.entries)
+        entries[key] = entry;
+}
+
+bool PluginScanCache::load (const File& file)
+{
+    auto xml = XmlDocument::parse (file);
+    if (xml == nullptr || ! xml->hasTagName ("scancache"))
+        return false;
+
+    entries.clear();
+    for (const auto* e : xml->getChildWithTagNameIterator ("file"))
+    {
+        Entry entry;
+        entry.format = e->getStringAttribute ("format");
+        entry.file = e->getStringAttribute ("path");
+        entry.stamp = detail::readStamp (*e);
+        entry.failed = e->getBoolAttribute ("failed");
+        entry.types = detail::readTypes (*e);
+
+        if (entry.format.isNotEmpty() && entry.file.isNotEmpty())
+            entries[keyFor (entry.format, entry.file)] = entry;
+    }
+
+    return true;
+}
+
+bool PluginScanCache::save (const File& file) const
+{
+    XmlElement xml ("scancache");
+    for (const auto& [key, entry] : entries)
+    {
+        auto* e = xml.createNewChildElement ("file");
+        e->setAttribute ("format", entry.format);
+        e->setAttribute ("path", entry.file);
+        detail::writeStamp (*e, entry.stamp);
+        e->setAttribute ("failed", entry.failed);
+        detail::writeTypes (*e, entry.types);
+    }
+
+    return xml.writeTo (file);
+}
+
+//==============================================================================
+PluginScanJournal::PluginScanJournal (const File& file)
+{
+    out = std::make_unique<FileOutputStream> (file);
+    if (out->failedToOpen())
+        out.reset();
+}
+
+PluginScanJournal::~PluginScanJournal() = default;
+
+bool PluginScanJournal::write (const XmlElement& record)
+{
+    if (out == nullptr)
+        return false;
+
+    const auto line = record.toString (XmlElement::TextFormat().singleLine().withoutHeader());
+    *out << line << "\n";
+    out->flush();
+    return out->getStatus().wasOk();
+}
+
+bool PluginScanJournal::scanning (const String& format, const String& file)
+{
+    XmlElement record ("scanning");
+    record.setAttribute ("format", format);
+    record.setAttribute ("path", file);
+    return write (record);
+}
+
+bool PluginScanJournal::found (const String& format,
+                               const String& file,
+                               const PluginScanCache::Stamp& stamp,
+                               const Array<PluginDescription>& types,
+                               bool failed)
+{
+    XmlElement record ("found");
+    record.setAttribute ("format", format);
+    record.setAttribute ("path", file);
+    detail::writeStamp (record, stamp);
+    record.setAttribute ("failed", failed);
+    detail::writeTypes (record, types);
+    return write (record);
+}
+
+bool PluginScanJournal::dropped (const String& format, const String& file)
+{
+    XmlElement record ("dropped");
+    record.setAttribute ("format", format);
+    record.setAttribute ("path", file);
+    return write (record);
+}
+
+String PluginScanJournal::replay (const File& file, KnownPluginList& list, PluginScanCache& cache)
+{
+    String loading;
+
+    const auto forget = [&list] (const String& path) {
+        for (const auto& type : list.getTypes())
+            if (type.fileOrIdentifier == path)
+                list.removeType (type);
+        list.removeFromBlacklist (path);
+    };
+
+    for (const auto& line : StringArray::fromLines (file.loadFileAsString()))
+    {
+        // the last line is cut short if the process died writing it
+        auto record = line.isNotEmpty() ? parseXML (line) : nullptr;
+        if (record == nullptr)
+            continue;
+
+        const auto path = record->getStringAttribute ("path");
+        if (record->hasTagName ("scanning"))
+        {
+            loading = path;
+        }
+        else if (record->hasTagName ("found"))
+        {
+            const auto stamp = detail::readStamp (*record);
+            const auto types = detail::readTypes (*record);
+            const bool failed = record->getBoolAttribute ("failed");
+
+            forget (path);
+            if (failed)
+                list.addToBlacklist (path);
+            for (const auto& type : types)
+                list.addType (type);
+            if (stamp.isValid())
+                cache.set (record->getStringAttribute ("format"), path, stamp, types, failed);
+
+            if (loading == path)
+                loading = String();
+        }
+        else if (record->hasTagName ("dropped"))
+        {
+            forget (path);
+            cache.remove (record->getStringAttribute ("format"), path);
+        }
+    }
+
+    return loading;
+}
+
+} // namespace element
@@ -0,0 +1,140 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <map>
+#include <memory>
+
+#include <element/juce/audio_processors.hpp>
+
+namespace element {
+
+/** Remembers what scanning each plugin file found, so a rescan only loads
+    plugins which are new or have changed since the last one.
+
+    Entries are keyed by format and file or identifier, and stamped with the
+    modification time and size of the file. Bundles are stamped with a hash of
+    the names, sizes and times of everything inside, so changing any file in a
+    bundle counts as a change.
+ */
+class PluginScanCache final
+{
+public:
+    PluginScanCache() = default;
+
+    /** What a file looked like when it was scanned. */
+    struct Stamp
+    {
+        juce::int64 modified = 0;
+        juce::int64 size = 0;
+        juce::String hash;
+
+        bool isValid() const noexcept { return modified != 0; }
+        bool operator== (const Stamp& o) const noexcept { return modified == o.modified && size == o.size && hash == o.hash; }
+        bool operator!= (const Stamp& o) const noexcept { return ! operator== (o); }
+    };
+
+    /** Returns the stamp of a file or bundle, invalid if it doesn't exist. */
+    static Stamp stampFor (const juce::File& file);
+
+    enum Result
+    {
+        missing, ///< never scanned
+        changed, ///< scanned, but the file has changed since
+        unchanged ///< scanned and still the same, types holds what was found
+    };
+
+    /** Look up a file.
+        @param failed Set to true if the file didn't load last time.
+     */
+    Result lookup (const juce::String& format,
+                   const juce::String& file,
+                   const Stamp& stamp,
+                   juce::Array<juce::PluginDescription>& types,
+                   bool& failed) const;
+
+    /** Record what scanning a file found. */
+    void set (const juce::String& format,
+              const juce::String& file,
+              const Stamp& stamp,
+              const juce::Array<juce::PluginDescription>& types,
+              bool failed);
+
+    /** Remove the entry for a file. */
+    void remove (const juce::String& format, const juce::String& file);
+
+    /** Remove every entry of a format. */
+    void removeFormat (const juce::String& format);
+
+    /** Copy all entries from another cache, replacing any with the same key. */
+    void addFrom (const PluginScanCache& other);
+
+    /** Returns the number of files in the cache. */
+    int size() const noexcept { return (int) entries.size(); }
+
+    /** Remove all entries. */
+    void clear() { entries.clear(); }
+
+    /** Replace the contents with a saved cache. Returns false if the file
+        couldn't be read. */
+    bool load (const juce::File& file);
+
+    /** Save the cache to a file. */
+    bool save (const juce::File& file) const;
+
+private:
+    struct Entry
+    {
+        juce::String format, file;
+        Stamp stamp;
+        bool failed = false;
+        juce::Array<juce::PluginDescription> types;
+    };
+
+    std::map<juce::String, Entry> entries;
+    static juce::String keyFor (const juce::String& format, const juce::String& file);
+};
+
+//==============================================================================
+/** An append only log of what a scanner process did while scanning, so it
+    never has to rewrite the whole plugin list after each plugin.
+
+    A record is written before a plugin loads, and another with what was
+    found once it has. If the process dies in between, replaying the journal
+    reports the file it died on. Records are one line of XML each and get
+    flushed as they're written.
+ */
+class PluginScanJournal final
+{
+public:
+    explicit PluginScanJournal (const juce::File& file);
+    ~PluginScanJournal();
+
+    /** Record that a file is about to be loaded. */
+    bool scanning (const juce::String& format, const juce::String& file);
+
+    /** Record what a file contains, replacing anything known about it. */
+    bool found (const juce::String& format,
+                const juce::String& file,
+                const PluginScanCache::Stamp& stamp,
+                const juce::Array<juce::PluginDescription>& types,
+                bool failed);
+
+    /** Record that a file should be forgotten. */
+    bool dropped (const juce::String& format, const juce::String& file);
+
+    /** Apply a journal, in order, to a plugin list and scan cache.
+        @returns The file which was loading when the journal ended, or an
+                 empty string if every load finished.
+     */
+    static juce::String replay (const juce::File& file,
+                                juce::KnownPluginList& list,
+                                PluginScanCache& cache);
+
+private:
+    std::unique_ptr<juce::FileOutputStream> out;
+    bool write (const juce::XmlElement& record);
+};
+
+} // namespace element
@@ -7,6 +7,7 @@
 #include <element/session.hpp>
 
 #include <element/context.hpp>
+#include "session/sessionfile.hpp"
 #include "tempo.hpp"
 
 namespace element {
@@ -285,25 +286,19 @@ void Session::setActiveGraph (int index)
 
 bool Session::writeToFile (const File& file) const
 {
-    ValueTree saveData = objectData.createCopy();
-    Node::sanitizeProperties (saveData, true);
-    TemporaryFile tempFile (file);
-
-    if (auto fos = tempFile.getFile().createOutputStream())
-    {
-        {
-            GZIPCompressorOutputStream gzip (*fos, 9);
-            saveData.writeToStream (gzip);
-        }
-        fos.reset();
-        return tempFile.overwriteTargetFileWithTemporary();
-    }
-
-    return false;
+    return SessionFile::write (objectData, file);
 }
 
 ValueTree Session::readFromFile (const File& file)
 {
+    if (SessionFile::isSessionFile (file))
+        return SessionFile::read (file);
+
+    // sessions and graphs saved as text
+    if (auto xml = XmlDocument::parse (file))
+        return ValueTree::fromXml (*xml);
+
+    // older sessions are a gzipped tree
     ValueTree data;
     FileInputStream fi (file);
 
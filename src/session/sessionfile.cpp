@@ -0,0 +1,383 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <element/node.hpp>
+#include <element/tags.hpp>
+
+#include "session/sessionfile.hpp"
+
+namespace element {
+using namespace juce;
+
+//==============================================================================
+StateBlob::StateBlob (MemoryBlock data)
+    : owned (std::move (data)),
+      size (owned.getSize()) {}
+
+StateBlob::StateBlob (Storage::Ptr s, size_t o, size_t sz)
+    : storage (s), offset (o), size (sz)
+{
+    jassert (storage != nullptr && offset + size <= storage->getSize());
+}
+
+const void* StateBlob::getData() const noexcept
+{
+    return storage != nullptr ? addBytesToPointer (storage->getData(), offset)
+                              : owned.getData();
+}
+
+StateBlob* StateBlob::fromVar (const var& value) noexcept
+{
+    return dynamic_cast<StateBlob*> (value.getObject());
+}
+
+bool StateBlob::isState (const var& value)
+{
+    if (auto* blob = fromVar (value))
+        return blob->getSize() > 0;
+    return value.isString() && value.toString().trim().isNotEmpty();
+}
+
+MemoryBlock StateBlob::decode (const var& value)
+{
+    if (auto* blob = fromVar (value))
+        return { blob->getData(), blob->getSize() };
+
+    MemoryBlock data;
+    const auto text = value.toString().trim();
+    if (text.isNotEmpty())
+        data.fromBase64Encoding (text);
+    return data;
+}
+
+var StateBlob::toBase64 (const var& value)
+{
+    if (fromVar (value) != nullptr)
+        return decode (value).toBase64Encoding();
+    return value;
+}
+
+void StateBlob::set (ValueTree tree, const Identifier& property, MemoryBlock data)
+{
+    // setting the same bytes again would look like a change to listeners
+    const auto current = tree.getProperty (property);
+    if (auto* blob = fromVar (current))
+    {
+        if (blob->getSize() == data.getSize() && std::memcmp (blob->getData(), data.getData(), data.getSize()) == 0)
+            return;
+    }
+    else if (current.isString() && decode (current) == data)
+    {
+        return;
+    }
+
+    tree.setProperty (property, new StateBlob (std::move (data)), nullptr);
+}
+
+//==============================================================================
+namespace detail {
+
+static constexpr const char* sessionFileMagic = "ELSF";
+static constexpr uint32 sessionFileVersion = 1;
+static constexpr size_t sessionFileHeaderSize = 16;
+static constexpr size_t sessionFileEntrySize = 24;
+static const String sectionPrefix ("section:");
+
+enum SectionType : uint32
+{
+    treeSection = 0x45455254, // "TREE"
+    blobSection = 0x424f4c42 // "BLOB"
+};
+
+static int64 align8 (int64 offset) { return (offset + 7) & ~(int64) 7; }
+
+static const Identifier* stateProperties()
+{
+    static const Identifier properties[] = { tags::state, tags::programState };
+    return properties;
+}
+static constexpr int numStateProperties = 2;
+
+/** FNV-1a, used to find identical state. Matches are compared in full. */
+static uint64 hashBytes (const void* data, size_t size) noexcept
+{
+    auto hash = (uint64) 0xcbf29ce484222325ull;
+    for (auto* b = static_cast<const uint8*> (data); size > 0; --size, ++b)
+        hash = (hash ^ *b) * (uint64) 0x100000001b3ull;
+    return hash;
+}
+
+struct Section
+{
+    uint32 type = blobSection;
+    StateBlob::Ptr blob;
+    MemoryBlock owned;
+
+    const void* getData() const noexcept { return blob != nullptr ? blob->getData() : owned.getData(); }
+    size_t getSize() const noexcept { return blob != nullptr ? blob->getSize() : owned.getSize(); }
+};
+
+/** Collects node state into sections, storing identical state once. */
+class StateWriter
+{
+public:
+    std::vector<Section> sections { 1 };
+
+    /** Move node state out of a tree and into sections. Blobs are shared, not copied. */
+    void extract (ValueTree tree)
+    {
+        if (tree.hasType (types::Node))
+        {
+            for (int i = 0; i < numStateProperties; ++i)
+            {
+                const auto& property = stateProperties()[i];
+                const auto value = tree.getProperty (property);
+                if (StateBlob::isState (value))
+                    tree.setProperty (property, sectionPrefix + String (add (value)), nullptr);
+            }
+        }
+
+        for (int i = 0; i < tree.getNumChildren(); ++i)
+            extract (tree.getChild (i));
+    }
+
+private:
+    std::map<const StateBlob*, int> byBlob;
+    std::multimap<uint64, int> byHash;
+
+    int add (const var& value)
+    {
+        Section section;
+        section.blob = StateBlob::fromVar (value);
+        if (section.blob != nullptr)
+        {
+            // copies of a tree share blobs, no need to look at the bytes
+            auto iter = byBlob.find (section.blob.get());
+            if (iter != byBlob.end())
+                return iter->second;
+        }
+        else
+        {
+            section.owned = StateBlob::decode (value);
+        }
+
+        const auto hash = hashBytes (section.getData(), section.getSize());
+        for (auto [iter, end] = byHash.equal_range (hash); iter != end; ++iter)
+        {
+            const auto& other = sections[(size_t) iter->second];
+            if (other.getSize() == section.getSize()
+                && std::memcmp (other.getData(), section.getData(), section.getSize()) == 0)
+            {
+                return remember (section.blob, iter->second);
+            }
+        }
+
+        const auto index = (int) sections.size();
+        byHash.emplace (hash, index);
+        auto blob = section.blob;
+        sections.push_back (std::move (section));
+        return remember (blob, index);
+    }
+
+    int remember (const StateBlob::Ptr& blob, int index)
+    {
+        if (blob != nullptr)
+            byBlob[blob.get()] = index;
+        return index;
+    }
+};
+
+struct Entry
+{
+    uint32 type = 0, flags = 0;
+    int64 offset = 0, size = 0;
+};
+
+/** Replace section references with blobs pointing into the file. Nodes
+    referring to the same section share one blob. */
+static void resolveState (ValueTree tree,
+                          const Array<Entry>& entries,
+                          StateBlob::Storage::Ptr storage,
+                          std::vector<StateBlob::Ptr>& blobs)
+{
+    if (tree.hasType (types::Node))
+    {
+        for (int i = 0; i < numStateProperties; ++i)
+        {
+            const auto& property = stateProperties()[i];
+            const auto value = tree.getProperty (property).toString();
+            if (! value.startsWith (sectionPrefix))
+                continue;
+
+            const auto index = value.substring (sectionPrefix.length()).getIntValue();
+            if (isPositiveAndBelow (index, entries.size()) && entries.getReference (index).type == blobSection)
+            {
+                auto& blob = blobs[(size_t) index];
+                if (blob == nullptr)
+                {
+                    const auto& entry = entries.getReference (index);
+                    blob = new StateBlob (storage, (size_t) entry.offset, (size_t) entry.size);
+                }
+
+                tree.setProperty (property, blob.get(), nullptr);
+            }
+            else
+            {
+                tree.removeProperty (property, nullptr);
+            }
+        }
+    }
+
+    for (int i = 0; i < tree.getNumChildren(); ++i)
+        resolveState (tree.getChild (i), entries, storage, blobs);
+}
+
+/** A file mapped into memory. */
+class MappedStorage final : public StateBlob::Storage
+{
+public:
+    explicit MappedStorage (const File& file) : map (file, MemoryMappedFile::readOnly) {}
+    const void* getData() const noexcept override { return map.getData(); }
+    size_t getSize() const noexcept override { return map.getSize(); }
+
+private:
+    MemoryMappedFile map;
+};
+
+/** A file read into memory. */
+class LoadedStorage final : public StateBlob::Storage
+{
+public:
+    explicit LoadedStorage (const File& file) { file.loadFileAsData (block); }
+    const void* getData() const noexcept override { return block.getData(); }
+    size_t getSize() const noexcept override { return block.getSize(); }
+
+private:
+    MemoryBlock block;
+};
+
+static StateBlob::Storage::Ptr openStorage (const File& file)
+{
+#if JUCE_WINDOWS
+    // windows can't replace a file which is mapped, and saving over the
+    // session which is open is the common case.
+    StateBlob::Storage::Ptr storage (new LoadedStorage (file));
+#else
+    StateBlob::Storage::Ptr storage (new MappedStorage (file));
+#endif
+    if (storage->getData() == nullptr || storage->getSize() < sessionFileHeaderSize)
+        return nullptr;
+    return storage;
+}
+
+} // namespace detail
+
+//==============================================================================
+bool SessionFile::isSessionFile (const File& file)
+{
+    char magic[4] = {};
+    FileInputStream in (file);
+    return in.openedOk() && in.read (magic, 4) == 4
+           && std::memcmp (magic, detail::sessionFileMagic, 4) == 0;
+}
+
+bool SessionFile::write (const ValueTree& tree, const File& file)
+{
+    using namespace detail;
+
+    ValueTree data = tree.createCopy();
+    StateWriter writer;
+    writer.extract (data);
+    auto& sections = writer.sections;
+    Node::sanitizeProperties (data, true);
+
+    MemoryOutputStream treeData;
+    data.writeToStream (treeData);
+    sections[0].type = treeSection;
+    sections[0].owned = treeData.getMemoryBlock();
+
+    TemporaryFile tempFile (file);
+    auto out = tempFile.getFile().createOutputStream();
+    if (out == nullptr)
+        return false;
+
+    out->write (sessionFileMagic, 4);
+    out->writeInt ((int) sessionFileVersion);
+    out->writeInt ((int) sections.size());
+    out->writeInt (0);
+
+    auto offset = align8 ((int64) (sessionFileHeaderSize + sessionFileEntrySize * sections.size()));
+    for (const auto& section : sections)
+    {
+        out->writeInt ((int) section.type);
+        out->writeInt (0); // flags, reserved for compression
+        out->writeInt64 (offset);
+        out->writeInt64 ((int64) section.getSize());
+        offset = align8 (offset + (int64) section.getSize());
+    }
+
+    for (const auto& section : sections)
+    {
+        const auto padding = align8 (out->getPosition()) - out->getPosition();
+        if (padding > 0)
+            out->writeRepeatedByte (0, (size_t) padding);
+        if (! out->write (section.getData(), section.getSize()))
+            return false;
+    }
+
+    out->flush();
+    const bool ok = out->getStatus().wasOk();
+    out.reset();
+    return ok && tempFile.overwriteTargetFileWithTemporary();
+}
+
+ValueTree SessionFile::read (const File& file)
+{
+    using namespace detail;
+
+    auto storage = openStorage (file);
+    if (storage == nullptr)
+        return {};
+
+    MemoryInputStream in (storage->getData(), storage->getSize(), false);
+    char magic[4] = {};
+    in.read (magic, 4);
+    if (std::memcmp (magic, sessionFileMagic, 4) != 0)
+        return {};
+
+    const auto version = (uint32) in.readInt();
+    const auto numSections = in.readInt();
+    in.readInt();
+    if (version > sessionFileVersion || numSections <= 0
+        || (int64) numSections * (int64) sessionFileEntrySize > in.getNumBytesRemaining())
+        return {};
+
+    Array<Entry> entries;
+    for (int i = 0; i < numSections; ++i)
+    {
+        Entry entry;
+        entry.type = (uint32) in.readInt();
+        entry.flags = (uint32) in.readInt();
+        entry.offset = in.readInt64();
+        entry.size = in.readInt64();
+
+        if (entry.flags != 0 || entry.offset < 0 || entry.size < 0
+            || entry.offset + entry.size > (int64) storage->getSize())
+            return {};
+
+        entries.add (entry);
+    }
+
+    const auto& treeEntry = entries.getReference (0);
+    if (treeEntry.type != treeSection)
+        return {};
+
+    auto tree = ValueTree::readFromData (addBytesToPointer (storage->getData(), treeEntry.offset),
+                                         (size_t) treeEntry.size);
+    std::vector<StateBlob::Ptr> blobs ((size_t) entries.size());
+    if (tree.isValid())
+        resolveState (tree, entries, storage, blobs);
+    return tree;
+}
+
+} // namespace element
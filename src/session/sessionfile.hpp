@@ -0,0 +1,99 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#pragma once
+
+#include <element/juce/core.hpp>
+#include <element/juce/data_structures.hpp>
+
+namespace element {
+
+//==============================================================================
+/** The saved state of a plugin, kept in a node's tree as raw bytes instead of
+    base64 text.
+
+    A blob either owns its bytes or points into a session file which was
+    loaded, in which case the bytes are only read when a node restores.
+    Blobs are immutable, so copies of a tree can share them.
+ */
+class StateBlob : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<StateBlob>;
+
+    /** Keeps the bytes of a loaded session file alive. */
+    class Storage : public juce::ReferenceCountedObject
+    {
+    public:
+        using Ptr = juce::ReferenceCountedObjectPtr<Storage>;
+        virtual ~Storage() = default;
+        virtual const void* getData() const noexcept = 0;
+        virtual size_t getSize() const noexcept = 0;
+    };
+
+    /** Create a blob owning a copy of some bytes. */
+    explicit StateBlob (juce::MemoryBlock data);
+
+    /** Create a blob referring to part of some storage. */
+    StateBlob (Storage::Ptr storage, size_t offset, size_t size);
+
+    const void* getData() const noexcept;
+    size_t getSize() const noexcept { return size; }
+
+    /** Returns the blob held by a property value, or nullptr if it isn't one. */
+    static StateBlob* fromVar (const juce::var& value) noexcept;
+
+    /** Returns true if a property value holds state, either as a blob or as a
+        base64 string from an older file. */
+    static bool isState (const juce::var& value);
+
+    /** Copy the bytes of a state property, either a blob or base64 text. */
+    static juce::MemoryBlock decode (const juce::var& value);
+
+    /** Returns the property as base64 text, for formats which need text. */
+    static juce::var toBase64 (const juce::var& value);
+
+    /** Set a state property, unless it already holds the same bytes. */
+    static void set (juce::ValueTree tree, const juce::Identifier& property, juce::MemoryBlock data);
+
+private:
+    Storage::Ptr storage;
+    juce::MemoryBlock owned;
+    size_t offset = 0, size = 0;
+};
+
+//==============================================================================
+/** A session file made of sections: the tree, and the state of every node
+    in sections of its own. Files are memory mapped when read, so a node's
+    state is only paged in when the node restores. Nothing is compressed, so
+    saving is mostly copying and is cheap enough to run while playing.
+
+    The layout is a header, a table of sections, then the sections 8-byte
+    aligned. Integers are little endian.
+
+        "ELSF"  uint32 version  uint32 numSections  uint32 reserved
+        numSections x { uint32 type, uint32 flags, int64 offset, int64 size }
+
+    The tree is ValueTree's binary format, with each state property replaced
+    by "section:<index>". Identical state is stored once and nodes refer to
+    the same section, which is common with many instances of one plugin on
+    the same preset. Reading gives those nodes one shared blob.
+ */
+class SessionFile final
+{
+public:
+    /** Returns true if a file is in this format. */
+    static bool isSessionFile (const juce::File& file);
+
+    /** Write a tree to a file. Node state may be blobs or base64 text. */
+    static bool write (const juce::ValueTree& tree, const juce::File& file);
+
+    /** Read a tree from a file, with node state as blobs referring to the
+        file. Returns an invalid tree if the file couldn't be read. */
+    static juce::ValueTree read (const juce::File& file);
+
+private:
+    SessionFile() = delete;
+};
+
+} // namespace element
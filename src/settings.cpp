@@ -41,6 +41,9 @@ const char* Settings::updateKeyTypeKey = "updateKeyType";
 const char* Settings::updateKeyKey = "updateKey";
 const char* Settings::updateKeyUserKey = "updateKeyUserKey";
 const char* Settings::transportStartStopContinue = "transportStartStopContinueKey";
+const char* Settings::parallelRenderingKey = "parallelRendering";
+const char* Settings::setlistModeKey = "setlistMode";
+const char* Settings::standbyGraphsKey = "standbyGraphs";
 
 //=============================================================================
 enum OptionsMenuItemId
@@ -524,6 +527,47 @@ bool Settings::transportRespondToStartStopContinue() const
     return false;
 }
 
+//=============================================================================
+bool Settings::useParallelRendering() const
+{
+    if (auto* p = getProps())
+        return p->getBoolValue (parallelRenderingKey, false);
+    return false;
+}
+
+void Settings::setUseParallelRendering (bool shouldUseParallel)
+{
+    if (auto p = getProps())
+        p->setValue (parallelRenderingKey, shouldUseParallel);
+}
+
+//=============================================================================
+bool Settings::useSetlistMode() const
+{
+    if (auto* p = getProps())
+        return p->getBoolValue (setlistModeKey, false);
+    return false;
+}
+
+void Settings::setUseSetlistMode (bool shouldUseSetlist)
+{
+    if (auto p = getProps())
+        p->setValue (setlistModeKey, shouldUseSetlist);
+}
+
+int Settings::getNumStandbyGraphs() const
+{
+    if (auto* p = getProps())
+        return jlimit (1, 64, p->getIntValue (standbyGraphsKey, 4));
+    return 4;
+}
+
+void Settings::setNumStandbyGraphs (int numGraphs)
+{
+    if (auto p = getProps())
+        p->setValue (standbyGraphsKey, jlimit (1, 64, numGraphs));
+}
+
 //=============================================================================
 void Settings::addItemsToMenu (Context& world, PopupMenu& menu)
 {
@@ -5,6 +5,7 @@
 #include <element/context.hpp>
 #include <element/settings.hpp>
 #include <element/devices.hpp>
+#include <element/engine.hpp>
 #include <element/node.hpp>
 #include <element/plugins.hpp>
 #include <element/ui/commands.hpp>
@@ -254,12 +255,21 @@ public:
             }
         }
 
+        if (auto* engine = world.services().find<EngineService>())
+        {
+            graphLoadProgressConnection = engine->sigGraphLoadProgress.connect (
+                [this] (const Node& graph, int numLoaded, int numNodes) {
+                    showLoadProgress (graph, numLoaded, numNodes);
+                });
+        }
+
         startTimer (2000);
         updateLabels();
     }
 
     ~StatusBar()
     {
+        graphLoadProgressConnection.disconnect();
         latencySamplesChangedConnection.disconnect();
         sampleRate.removeListener (this);
         streamingStatus.removeListener (this);
@@ -332,7 +342,11 @@ public:
             statusLabel.setColour (Label::textColourId, Colors::toggleRed);
         }
 
-        if (plugins.isScanningAudioPlugins())
+        if (loadingText.isNotEmpty())
+        {
+            streamingStatusLabel.setText (loadingText, dontSendNotification);
+        }
+        else if (plugins.isScanningAudioPlugins())
         {
             auto text = streamingStatusLabel.getText();
             auto name = plugins.getCurrentlyScannedPluginName();
@@ -354,6 +368,21 @@ private:
     Value sampleRate, streamingStatus, status;
 
     SignalConnection latencySamplesChangedConnection;
+    SignalConnection graphLoadProgressConnection;
+    String loadingText;
+
+    void showLoadProgress (const Node& graph, int numLoaded, int numNodes)
+    {
+        loadingText.clear();
+        if (numLoaded < numNodes)
+        {
+            loadingText << "Loading " << graph.getName() << ": "
+                        << numLoaded << " of " << numNodes << " nodes";
+        }
+
+        updateLabels();
+        repaint();
+    }
 
     friend class Timer;
     void timerCallback() override
@@ -182,6 +182,7 @@ public:
         int index = 30000;
         ProcessorPtr ptr = node.getObject();
         menu.addItem (index++, "Mute input ports", ptr != nullptr, ptr && ptr->isMutingInputs());
+        menu.addItem (index++, "Sleep when input is silent", ptr != nullptr && ! node.isIONode(), ptr && ptr->sleepsWhenSilent());
         addOversamplingSubmenu (menu);
         addSubMenu (TRANS ("Options"), menu, ptr != nullptr);
 #endif
@@ -214,6 +215,13 @@ public:
         osMenu.addItem (index++, "4x", true, ptr->getOversamplingFactor() == 4);
         osMenu.addItem (index++, "8x", true, ptr->getOversamplingFactor() == 8);
 
+        osMenu.addSeparator();
+        index = 41000;
+        const auto quality = ptr->getOversamplingQuality();
+        osMenu.addItem (index++, "Low latency (IIR)", true, quality == 0);
+        osMenu.addItem (index++, "Linear phase (FIR)", true, quality == 1);
+        osMenu.addItem (index++, "Max quality (offline)", true, quality == 2);
+
         menuToAddTo.addSubMenu ("Oversample", osMenu);
     }
 
@@ -333,8 +341,7 @@ public:
                                       : ValueTree();
                 if (n.isValid() && data.isValid() && data.hasProperty (tags::state))
                 {
-                    const String state = data.getProperty (tags::state).toString();
-                    n.data().setProperty (tags::state, state, 0);
+                    n.data().setProperty (tags::state, data.getProperty (tags::state), 0);
                     if (data.hasProperty (tags::programState))
                         n.data().setProperty (tags::programState, data.getProperty (tags::programState), 0);
                     n.restorePluginState();
@@ -355,9 +362,17 @@ public:
                 case 0:
                     node.setMuteInput (! node.isMutingInputs());
                     break;
+                case 1:
+                    node.setSleepWhenSilent (! node.sleepsWhenSilent());
+                    break;
             }
         }
-        else if (result >= 40000 && result < 50000)
+        else if (result >= 41000 && result < 42000)
+        {
+            if (auto gNode = node.getObject())
+                gNode->setOversamplingQuality (result - 41000);
+        }
+        else if (result >= 40000 && result < 41000)
         {
             const int osFactor = (int) powf (2, float (result - 40000));
             if (auto gNode = node.getObject())
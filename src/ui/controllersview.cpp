@@ -476,6 +476,16 @@ private:
                 text = "CC ";
                 text << control.getEventId();
             }
+            else if (control.isController14Event())
+            {
+                text = "CC ";
+                text << control.getEventId() << "/" << (control.getEventId() + 32);
+            }
+            else if (control.isNrpnEvent())
+            {
+                text = "NRPN ";
+                text << control.getEventId();
+            }
 
             status.setText (text, dontSendNotification);
             list.repaintRow (rowNumber);
@@ -862,13 +872,28 @@ public:
                                                   true));
 
             eventType = control.getPropertyAsValue ("eventType");
-            props.add (new ChoicePropertyComponent (eventType, "Event Type", { "Controller", "Note" }, { var ("controller"), var ("note") }));
+            props.add (new ChoicePropertyComponent (eventType, "Event Type", { "Controller", "14-bit Controller", "NRPN", "Note" }, { var ("controller"), var ("controller14"), var ("nrpn"), var ("note") }));
 
             String eventName = "Event ID";
+            double maxEventId = 127.0;
             if (control.isNoteEvent())
+            {
                 eventName = "Note Number";
+            }
             else if (control.isControllerEvent())
+            {
                 eventName = "CC Number";
+            }
+            else if (control.isController14Event())
+            {
+                eventName = "CC Number (MSB)";
+                maxEventId = 31.0;
+            }
+            else if (control.isNrpnEvent())
+            {
+                eventName = "NRPN Number";
+                maxEventId = 16383.0;
+            }
 
             props.add (new ChoicePropertyComponent (control.getPropertyAsValue (tags::midiChannel),
                                                     "Channel",
@@ -876,7 +901,7 @@ public:
                                                     { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 }));
 
             eventId = control.getPropertyAsValue ("eventId");
-            props.add (new SliderPropertyComponent (eventId, eventName, 0.0, 127.0, 1.0));
+            props.add (new SliderPropertyComponent (eventId, eventName, 0.0, maxEventId, 1.0));
 
             if (control.isControllerEvent())
             {
@@ -45,6 +45,7 @@ public:
 
     ~NodeChannelStripComponent()
     {
+        setMeteredObject (nullptr);
         unbindSignals();
     }
 
@@ -147,6 +148,7 @@ public:
         else
         {
             meter.resetPeaks();
+            setMeteredObject (nullptr);
             stopTimer();
         }
 
@@ -194,6 +196,7 @@ public:
         node.getPorts (audioIns, audioOuts, PortType::Audio);
         displayName.referTo (node.getPropertyAsValue (tags::name));
         stabilizeContent();
+        setMeteredObject (node.getObject());
         startTimerHz (meterSpeedHz);
 
         if (onNodeChanged)
@@ -256,6 +259,7 @@ private:
     [[maybe_unused]] bool monoMeter = false;
 
     Value displayName;
+    ProcessorPtr meteredObject;
 
     SignalConnection nodeSelectedConnection;
     SignalConnection volumeChangedConnection;
@@ -264,6 +268,18 @@ private:
     SignalConnection muteChangedConnection;
     std::vector<boost::signals2::connection> _conns;
 
+    /** Levels are only measured while a meter is subscribed to them. */
+    void setMeteredObject (ProcessorPtr object)
+    {
+        if (object == meteredObject)
+            return;
+        if (meteredObject != nullptr)
+            meteredObject->unsubscribeFromLevels();
+        meteredObject = object;
+        if (meteredObject != nullptr)
+            meteredObject->subscribeToLevels();
+    }
+
     inline bool isMonitoringInputs() const { return flowBox.getSelectedId() == 1; }
     inline bool isMonitoringOutputs() const { return flowBox.getSelectedId() == 2; }
 
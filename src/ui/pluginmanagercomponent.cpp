@@ -98,6 +98,7 @@ private:
     AlertWindow pathChooserWindow, progressWindow;
     FileSearchPathListComponent pathList;
     String pluginBeingScanned;
+    String failureMessage;
     double progress;
     [[maybe_unused]] int numThreads;
     [[maybe_unused]] bool allowAsync, finished;
@@ -235,6 +236,9 @@ private:
             failedFiles = scanner->getFailedFiles();
         }
 
+        if (failureMessage.isNotEmpty())
+            AlertWindow::showMessageBoxAsync (AlertWindow::WarningIcon, TRANS ("Scan incomplete"), failureMessage);
+
         owner.scanFinished (failedFiles);
     }
 
@@ -260,6 +264,11 @@ private:
         finished = true;
     }
 
+    void audioPluginScanFailed (const String& message) override
+    {
+        failureMessage = message;
+    }
+
     void audioPluginScanStarted (const String& pluginName) override
     {
         pluginBeingScanned = File::createFileWithoutCheckingPath (pluginName).getFileName();
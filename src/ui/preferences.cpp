@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: GPL3-or-later
 
 #include <element/devices.hpp>
+#include <element/engine.hpp>
 #include <element/plugins.hpp>
 #include <element/context.hpp>
 #include <element/settings.hpp>
@@ -416,6 +417,22 @@ public:
         systray.setToggleState (settings.isSystrayEnabled(), dontSendNotification);
         systray.getToggleStateValue().addListener (this);
 
+        addAndMakeVisible (parallelRenderingLabel);
+        parallelRenderingLabel.setText ("Multi-core graph rendering", dontSendNotification);
+        parallelRenderingLabel.setFont (Font (12.0, Font::bold));
+        addAndMakeVisible (parallelRendering);
+        parallelRendering.setClickingTogglesState (true);
+        parallelRendering.setToggleState (settings.useParallelRendering(), dontSendNotification);
+        parallelRendering.getToggleStateValue().addListener (this);
+
+        addAndMakeVisible (setlistModeLabel);
+        setlistModeLabel.setText ("Keep graphs on standby (setlist)", dontSendNotification);
+        setlistModeLabel.setFont (Font (12.0, Font::bold));
+        addAndMakeVisible (setlistMode);
+        setlistMode.setClickingTogglesState (true);
+        setlistMode.setToggleState (settings.useSetlistMode(), dontSendNotification);
+        setlistMode.getToggleStateValue().addListener (this);
+
         addAndMakeVisible (desktopScaleLabel);
         desktopScaleLabel.setText ("Desktop scale", dontSendNotification);
         desktopScaleLabel.setFont (Font (12.0, Font::bold));
@@ -542,6 +559,8 @@ public:
         mainContentBox.setBounds (r2.withSizeKeepingCentre (r2.getWidth(), settingHeight));
 
         layoutSetting (r, systrayLabel, systray);
+        layoutSetting (r, parallelRenderingLabel, parallelRendering);
+        layoutSetting (r, setlistModeLabel, setlistMode);
         layoutSetting (r, desktopScaleLabel, desktopScale, getWidth() / 4);
         layoutSetting (r, legacyCtlLabel, legacyCtl);
 
@@ -610,6 +629,18 @@ public:
             settings.setSystrayEnabled (systray.getToggleState());
             gui.refreshSystemTray();
         }
+        else if (value.refersToSameSourceAs (parallelRendering.getToggleStateValue()))
+        {
+            settings.setUseParallelRendering (parallelRendering.getToggleState());
+            engine->applySettings (settings);
+        }
+        else if (value.refersToSameSourceAs (setlistMode.getToggleStateValue()))
+        {
+            settings.setUseSetlistMode (setlistMode.getToggleState());
+            engine->applySettings (settings);
+            if (auto* ec = gui.sibling<EngineService>())
+                ec->updateStandbyGraphs();
+        }
         else if (value.refersToSameSourceAs (mainContentBox.getSelectedIdAsValue()))
         {
             auto uitype = settings.getMainContentType();
@@ -671,6 +702,12 @@ private:
     Label systrayLabel;
     SettingButton systray;
 
+    Label parallelRenderingLabel;
+    SettingButton parallelRendering;
+
+    Label setlistModeLabel;
+    SettingButton setlistMode;
+
     Label desktopScaleLabel;
     Slider desktopScale;
 
@@ -31,9 +31,10 @@ Result SessionDocument::loadDocument (const File& file)
         return Result::fail ("No session data target");
 
     String error;
-    if (auto e = XmlDocument::parse (file))
+    ValueTree newData = Session::readFromFile (file);
+
+    if (newData.isValid())
     {
-        ValueTree newData (ValueTree::fromXml (*e));
         if (newData.isValid() && (int) newData.getProperty (tags::version, -1) != EL_SESSION_VERSION)
         {
             std::clog << "[element] migrate session...\n";
@@ -74,15 +75,9 @@ Result SessionDocument::saveDocument (const File& file)
         return Result::fail ("Nil session");
 
     session->saveGraphState();
-    if (auto e = session->createXml())
-    {
-        Result res (e->writeTo (file)
-                        ? Result::ok()
-                        : Result::fail ("Error writing session file"));
-        return res;
-    }
-
-    return Result::fail ("Could not create session data");
+    return session->writeToFile (file)
+               ? Result::ok()
+               : Result::fail ("Error writing session file");
 }
 
 File SessionDocument::getLastDocumentOpened() { return lastSession; }
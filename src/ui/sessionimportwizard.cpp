@@ -153,14 +153,11 @@ void SessionImportWizard::loadSession (const File& file)
 {
     SessionPtr newSession;
     bool loaded = false;
-    if (auto e = XmlDocument::parse (file))
+    const auto newData = Session::readFromFile (file);
+    if (newData.isValid() && newData.hasType (types::Session))
     {
-        ValueTree newData (ValueTree::fromXml (*e));
-        if (newData.isValid() && newData.hasType (types::Session))
-        {
-            newSession = new Session();
-            loaded = newSession->loadData (newData);
-        }
+        newSession = new Session();
+        loaded = newSession->loadData (newData);
     }
 
     if (newSession != nullptr && loaded)
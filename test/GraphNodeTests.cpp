@@ -1,14 +1,169 @@
 #include <boost/test/unit_test.hpp>
 
+#include <element/atombuffer.hpp>
 #include <element/context.hpp>
 
 #include "fixture/PreparedGraph.h"
 #include "fixture/TestNode.h"
 #include "engine/graphnode.hpp"
+#include "engine/ionode.hpp"
+#include "engine/rendersequence.hpp"
 #include "utils.hpp"
 
 using namespace element;
 
+namespace {
+class GainTestNode : public TestNode {
+public:
+    explicit GainTestNode (float g) : TestNode (2, 2, 0, 0), gain (g) {}
+    void render (RenderContext& rc) override { rc.audio.applyGain (gain); }
+
+private:
+    const float gain;
+};
+
+/** Counts blocks rendered and writes a constant, like a synth would. */
+class CountingTestNode : public TestNode {
+public:
+    CountingTestNode() : TestNode (2, 2, 0, 0) {}
+    void render (RenderContext& rc) override
+    {
+        ++numRendered;
+        for (int c = 0; c < rc.audio.getNumChannels(); ++c)
+            FloatVectorOperations::fill (rc.audio.getWritePointer (c), 0.5f, rc.audio.getNumSamples());
+    }
+
+    int numRendered = 0;
+};
+
+/** Counts blocks like CountingTestNode and writes ones to a CV output. */
+class CVSourceTestNode : public CountingTestNode {
+public:
+    CVSourceTestNode() { CVSourceTestNode::refreshPorts(); }
+    void render (RenderContext& rc) override
+    {
+        CountingTestNode::render (rc);
+        FloatVectorOperations::fill (rc.cv.getWritePointer (0), 1.f, rc.cv.getNumSamples());
+    }
+
+    void refreshPorts() override
+    {
+        PortList newPorts;
+        uint32 port = 0;
+        for (int c = 0; c < 2; ++c)
+            newPorts.add (PortType::Audio, port++, c, String ("audio_in_") + String (c + 1), String ("In ") + String (c + 1), true);
+        for (int c = 0; c < 2; ++c)
+            newPorts.add (PortType::Audio, port++, c, String ("audio_out_") + String (c + 1), String ("Out ") + String (c + 1), false);
+        newPorts.add (PortType::CV, port++, 0, "cv_out_1", "CV Out 1", false);
+        setPorts (newPorts);
+    }
+};
+
+/** Remembers the peak of its CV input. */
+class CVProbeTestNode : public TestNode {
+public:
+    CVProbeTestNode() : TestNode (0, 0, 0, 0) { CVProbeTestNode::refreshPorts(); }
+    void render (RenderContext& rc) override { peak = rc.cv.getMagnitude (0, 0, rc.cv.getNumSamples()); }
+
+    void refreshPorts() override
+    {
+        PortList newPorts;
+        newPorts.add (PortType::CV, 0, 0, "cv_in_1", "CV In 1", true);
+        setPorts (newPorts);
+    }
+
+    float peak = -1.f;
+};
+
+/** Passes audio through and reports a fixed latency. */
+class LatentTestNode : public TestNode {
+public:
+    explicit LatentTestNode (int latency) : TestNode (1, 1, 0, 0) { setLatencySamples (latency); }
+    void setLatency (int latency) { setLatencySamples (latency); }
+};
+
+/** Returns the graph's only delay op, or nullptr. */
+static const GraphOp* findDelayOp (const GraphNode& graph)
+{
+    Array<const GraphOp*> ops;
+    graph.getRenderingOps (ops);
+    const GraphOp* found = nullptr;
+    for (auto* op : ops)
+    {
+        if (String (op->traceStep()).startsWith ("DelayChannelOp"))
+        {
+            BOOST_REQUIRE (found == nullptr);
+            found = op;
+        }
+    }
+    return found;
+}
+
+/** Renders one block of ones through an input -> N parallel gains -> output graph. */
+static void renderParallelGains (GraphNode& graph, AudioSampleBuffer& audio, int numBranches)
+{
+    auto* in = graph.addNode (new IONode (IONode::audioInputNode));
+    auto* out = graph.addNode (new IONode (IONode::audioOutputNode));
+    for (int i = 0; i < numBranches; ++i)
+    {
+        auto* node = graph.addNode (new GainTestNode (0.1f * (float) (i + 1)));
+        for (int c = 0; c < 2; ++c)
+        {
+            graph.connectChannels (PortType::Audio, in->nodeId, c, node->nodeId, c);
+            graph.connectChannels (PortType::Audio, node->nodeId, c, out->nodeId, c);
+        }
+    }
+
+    graph.rebuild();
+
+    AudioSampleBuffer cv (1, audio.getNumSamples());
+    MidiBuffer midi;
+    AtomBuffer atom;
+    for (int c = 0; c < audio.getNumChannels(); ++c)
+        FloatVectorOperations::fill (audio.getWritePointer (c), 1.f, audio.getNumSamples());
+    RenderContext rc (audio, cv, midi, atom, audio.getNumSamples());
+    graph.render (rc);
+}
+
+/** A routing op which compiles to a single instruction. */
+class RoutingTestOp : public GraphOp {
+public:
+    RoutingTestOp (RenderInstruction::Code c, int s, int d) : code (c), src (s), dst (d) {}
+    void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>&, const OwnedArray<AtomBuffer>&, int) override {}
+    bool compile (RenderInstruction& ins) const noexcept override
+    {
+        ins.code = code;
+        ins.src = src;
+        ins.dst = dst;
+        return true;
+    }
+
+private:
+    const RenderInstruction::Code code;
+    const int src, dst;
+};
+
+/** Adds a chain of gain nodes where each new node feeds the one added before it,
+    which is the worst case for ordering by insertion. Every fourth node also
+    feeds the head of the chain. */
+static void addReversedChain (GraphNode& graph, int numNodes)
+{
+    Processor* last = nullptr;
+    Processor* first = nullptr;
+    for (int i = 0; i < numNodes; ++i)
+    {
+        auto* node = graph.addNode (new GainTestNode (1.f));
+        if (last != nullptr)
+            graph.connectChannels (PortType::Audio, node->nodeId, 0, last->nodeId, 0);
+        if (first != nullptr && first != last && i % 4 == 0)
+            graph.connectChannels (PortType::Audio, node->nodeId, 1, first->nodeId, 1);
+        if (first == nullptr)
+            first = node;
+        last = node;
+    }
+}
+} // namespace
+
 BOOST_AUTO_TEST_SUITE (GraphNodeTests)
 
 BOOST_AUTO_TEST_CASE (IO)
@@ -77,4 +232,304 @@ BOOST_AUTO_TEST_CASE (AddRemove)
     BOOST_REQUIRE (graph.removeNode (node->nodeId));
 }
 
+BOOST_AUTO_TEST_CASE (ParallelRender)
+{
+    AudioSampleBuffer serial (2, 512), parallel (2, 512);
+
+    {
+        PreparedGraph fix;
+        renderParallelGains (fix.graph, serial, 16);
+    }
+
+    {
+        PreparedGraph fix;
+        fix.graph.setParallelRendering (true);
+        BOOST_REQUIRE (fix.graph.isRenderingInParallel());
+        renderParallelGains (fix.graph, parallel, 16);
+    }
+
+    for (int c = 0; c < 2; ++c)
+    {
+        BOOST_REQUIRE_CLOSE (serial.getSample (c, 0), 13.6f, 0.001f);
+        for (int i = 0; i < 512; ++i)
+            BOOST_REQUIRE_CLOSE (serial.getSample (c, i), parallel.getSample (c, i), 0.001f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (OrderedNodes)
+{
+    PreparedGraph fix;
+    auto& graph = fix.graph;
+    addReversedChain (graph, 64);
+
+    ReferenceCountedArray<Processor> ordered;
+    graph.getOrderedNodes (ordered);
+    BOOST_REQUIRE_EQUAL (ordered.size(), graph.getNumNodes());
+
+    for (int i = 0; i < graph.getNumConnections(); ++i)
+    {
+        const auto* c = graph.getConnection (i);
+        BOOST_REQUIRE (ordered.indexOf (graph.getNodeForId (c->sourceNode))
+                       < ordered.indexOf (graph.getNodeForId (c->destNode)));
+    }
+}
+
+BOOST_AUTO_TEST_CASE (LevelSubscription)
+{
+    PreparedGraph fix;
+    auto& graph = fix.graph;
+    AudioSampleBuffer audio (2, 512);
+    renderParallelGains (graph, audio, 2);
+
+    Processor* first = nullptr;
+    Processor* second = nullptr;
+    for (int i = 0; i < graph.getNumNodes(); ++i)
+    {
+        auto* node = graph.getNode (i);
+        if (dynamic_cast<GainTestNode*> (node) == nullptr)
+            continue;
+        if (first == nullptr)
+            first = node;
+        else
+            second = node;
+    }
+
+    BOOST_REQUIRE (first != nullptr && second != nullptr);
+    first->subscribeToLevels();
+    BOOST_REQUIRE (first->isMeteringLevels());
+    BOOST_REQUIRE (! second->isMeteringLevels());
+
+    AudioSampleBuffer cv (1, 512);
+    MidiBuffer midi;
+    AtomBuffer atom;
+    for (int c = 0; c < audio.getNumChannels(); ++c)
+        FloatVectorOperations::fill (audio.getWritePointer (c), 1.f, audio.getNumSamples());
+    RenderContext rc (audio, cv, midi, atom, audio.getNumSamples());
+    graph.render (rc);
+
+    BOOST_REQUIRE_CLOSE (first->getOutputRMS (0), 0.1f, 0.001f);
+    BOOST_REQUIRE_EQUAL (second->getOutputRMS (0), 0.f);
+
+    first->unsubscribeFromLevels();
+    BOOST_REQUIRE (! first->isMeteringLevels());
+    BOOST_REQUIRE_EQUAL (first->getOutputRMS (0), 0.f);
+}
+
+BOOST_AUTO_TEST_CASE (SleepWhenSilent)
+{
+    PreparedGraph fix;
+    auto& graph = fix.graph;
+    auto* in = graph.addNode (new IONode (IONode::audioInputNode));
+    auto* out = graph.addNode (new IONode (IONode::audioOutputNode));
+    auto* node = new CountingTestNode();
+    graph.addNode (node);
+    for (int c = 0; c < 2; ++c)
+    {
+        graph.connectChannels (PortType::Audio, in->nodeId, c, node->nodeId, c);
+        graph.connectChannels (PortType::Audio, node->nodeId, c, out->nodeId, c);
+    }
+    graph.rebuild();
+
+    // two blocks of tail, then sleep
+    node->setSleepWhenSilent (true);
+    node->setSilenceTail (1024.0 / graph.getSampleRate());
+    BOOST_REQUIRE_EQUAL (node->getSilenceTailSamples(), 1024);
+
+    AudioSampleBuffer audio (2, 512), cv (1, 512);
+    MidiBuffer midi;
+    AtomBuffer atom;
+    auto renderBlock = [&] (float input) {
+        for (int c = 0; c < audio.getNumChannels(); ++c)
+            FloatVectorOperations::fill (audio.getWritePointer (c), input, audio.getNumSamples());
+        RenderContext rc (audio, cv, midi, atom, audio.getNumSamples());
+        graph.render (rc);
+    };
+
+    for (int i = 0; i < 4; ++i)
+        renderBlock (0.f);
+    BOOST_REQUIRE_EQUAL (node->numRendered, 2);
+    BOOST_REQUIRE_EQUAL (audio.getMagnitude (0, 512), 0.f);
+
+    renderBlock (1.f);
+    BOOST_REQUIRE_EQUAL (node->numRendered, 3);
+    BOOST_REQUIRE_EQUAL (audio.getSample (0, 0), 0.5f);
+
+    // input woke it up, so the tail starts over
+    for (int i = 0; i < 4; ++i)
+        renderBlock (0.f);
+    BOOST_REQUIRE_EQUAL (node->numRendered, 5);
+
+    node->setSleepWhenSilent (false);
+    renderBlock (0.f);
+    BOOST_REQUIRE_EQUAL (node->numRendered, 6);
+}
+
+BOOST_AUTO_TEST_CASE (SleepClearsCVOutputs)
+{
+    PreparedGraph fix;
+    auto& graph = fix.graph;
+    auto* in = graph.addNode (new IONode (IONode::audioInputNode));
+    auto* source = new CVSourceTestNode();
+    auto* probe = new CVProbeTestNode();
+    graph.addNode (source);
+    graph.addNode (probe);
+    for (int c = 0; c < 2; ++c)
+        graph.connectChannels (PortType::Audio, in->nodeId, c, source->nodeId, c);
+    graph.connectChannels (PortType::CV, source->nodeId, 0, probe->nodeId, 0);
+    graph.rebuild();
+
+    source->setSleepWhenSilent (true);
+    source->setSilenceTail (0.0);
+
+    AudioSampleBuffer audio (2, 512), cv (1, 512);
+    MidiBuffer midi;
+    AtomBuffer atom;
+    auto renderBlock = [&] (float input) {
+        for (int c = 0; c < audio.getNumChannels(); ++c)
+            FloatVectorOperations::fill (audio.getWritePointer (c), input, audio.getNumSamples());
+        RenderContext rc (audio, cv, midi, atom, audio.getNumSamples());
+        graph.render (rc);
+    };
+
+    renderBlock (1.f);
+    BOOST_REQUIRE_EQUAL (source->numRendered, 1);
+    BOOST_REQUIRE_EQUAL (probe->peak, 1.f);
+
+    // asleep, the probe must not see the last block's CV again
+    renderBlock (0.f);
+    BOOST_REQUIRE_EQUAL (source->numRendered, 1);
+    BOOST_REQUIRE_EQUAL (probe->peak, 0.f);
+}
+
+BOOST_AUTO_TEST_CASE (RebuildKeepsEquivalentOps)
+{
+    PreparedGraph fix;
+    auto& graph = fix.graph;
+    auto* in = graph.addNode (new IONode (IONode::audioInputNode));
+    auto* latent = new LatentTestNode (64);
+    graph.addNode (latent);
+    auto* out = graph.addNode (new IONode (IONode::audioOutputNode));
+
+    // channel two bypasses the latent node, so it gets delayed to match
+    graph.connectChannels (PortType::Audio, in->nodeId, 0, latent->nodeId, 0);
+    graph.connectChannels (PortType::Audio, latent->nodeId, 0, out->nodeId, 0);
+    graph.connectChannels (PortType::Audio, in->nodeId, 1, out->nodeId, 1);
+    graph.rebuild();
+
+    AudioSampleBuffer audio (2, 512), cv (1, 512);
+    MidiBuffer midi;
+    AtomBuffer atom;
+    auto renderBlock = [&] (float input) {
+        for (int c = 0; c < audio.getNumChannels(); ++c)
+            FloatVectorOperations::fill (audio.getWritePointer (c), input, audio.getNumSamples());
+        RenderContext rc (audio, cv, midi, atom, audio.getNumSamples());
+        graph.render (rc);
+    };
+
+    const auto* delay = findDelayOp (graph);
+    BOOST_REQUIRE (delay != nullptr);
+    renderBlock (1.f);
+    BOOST_REQUIRE_EQUAL (audio.getSample (1, 63), 0.f);
+    BOOST_REQUIRE_EQUAL (audio.getSample (1, 64), 1.f);
+
+    // an unrelated edit keeps the delay op and the samples it holds
+    graph.addNode (new TestNode (0, 0, 0, 0));
+    graph.rebuild();
+    BOOST_REQUIRE (findDelayOp (graph) == delay);
+    renderBlock (0.f);
+    BOOST_REQUIRE_EQUAL (audio.getSample (1, 0), 1.f);
+    BOOST_REQUIRE_EQUAL (audio.getSample (1, 63), 1.f);
+    BOOST_REQUIRE_EQUAL (audio.getSample (1, 64), 0.f);
+
+    // a different delay length can't be reused
+    latent->setLatency (128);
+    graph.rebuild();
+    const auto* longer = findDelayOp (graph);
+    BOOST_REQUIRE (longer != nullptr && longer != delay);
+    BOOST_REQUIRE (String (longer->traceStep()).endsWith (" by 128 samples"));
+}
+
+BOOST_AUTO_TEST_CASE (RenderProgramFusion)
+{
+    OwnedArray<GraphOp> owned;
+    owned.add (new RoutingTestOp (RenderInstruction::clearAudio, 2, 2));
+    owned.add (new RoutingTestOp (RenderInstruction::addAudio, 1, 3));
+    owned.add (new RoutingTestOp (RenderInstruction::addAudio, 1, 2));
+    owned.add (new RoutingTestOp (RenderInstruction::addAudio, 3, 2));
+
+    Array<void*> ops;
+    for (auto* op : owned)
+        ops.add (op);
+
+    RenderProgram program;
+    program.compile (ops);
+    BOOST_REQUIRE_EQUAL (program.size(), 3);
+    BOOST_REQUIRE_EQUAL ((int) program[1].code, (int) RenderInstruction::copyAudio);
+    BOOST_REQUIRE_EQUAL ((int) program[2].code, (int) RenderInstruction::addAudio);
+
+    AudioSampleBuffer audio (4, 16);
+    audio.clear();
+    FloatVectorOperations::fill (audio.getWritePointer (1), 1.f, 16);
+    FloatVectorOperations::fill (audio.getWritePointer (2), 5.f, 16);
+    FloatVectorOperations::fill (audio.getWritePointer (3), 2.f, 16);
+    OwnedArray<MidiBuffer> midi;
+    OwnedArray<AtomBuffer> atom;
+    program.run (audio, midi, atom, 16);
+    BOOST_REQUIRE_CLOSE (audio.getSample (3, 0), 3.f, 0.001f);
+    BOOST_REQUIRE_CLOSE (audio.getSample (2, 15), 4.f, 0.001f);
+}
+
+BOOST_AUTO_TEST_CASE (ReclaimInOrder)
+{
+    struct WatchedOp : public GraphOp
+    {
+        explicit WatchedOp (std::atomic<bool>& d) : deleted (d) {}
+        ~WatchedOp() override { deleted = true; }
+        void perform (AudioSampleBuffer&, const OwnedArray<MidiBuffer>&, const OwnedArray<AtomBuffer>&, const int) override {}
+        std::atomic<bool>& deleted;
+    };
+
+    // the second sequence took over an op from the first, which is still rendering
+    std::atomic<bool> deleted { false };
+    auto* const older = new RenderSequence();
+    auto* const newer = new RenderSequence();
+    auto* const op = new WatchedOp (deleted);
+    older->ops.add (op);
+    older->released.add (0);
+    newer->ops.add (op);
+
+    RenderSequenceReclaimer reclaimer;
+    std::atomic<RenderSequence*> hazard { older };
+    reclaimer.retire (older, hazard);
+    reclaimer.retire (newer, hazard);
+
+    Thread::sleep (200);
+    BOOST_REQUIRE (! deleted.load());
+
+    RenderSequence::release (hazard);
+    reclaimer.reclaim (hazard);
+    BOOST_REQUIRE (deleted.load());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// Timings only. Disabled so a plain run stays fast, run with `meson test --benchmark`
+BOOST_AUTO_TEST_SUITE (GraphNodeBenchmarks, *boost::unit_test::disabled())
+
+BOOST_AUTO_TEST_CASE (RebuildBenchmark)
+{
+    for (const int numNodes : { 100, 500, 2000 })
+    {
+        PreparedGraph fix;
+        addReversedChain (fix.graph, numNodes);
+
+        const auto start = Time::getMillisecondCounterHiRes();
+        fix.graph.rebuild();
+        const auto elapsed = Time::getMillisecondCounterHiRes() - start;
+
+        BOOST_TEST_MESSAGE ("rebuild " << numNodes << " nodes: " << elapsed << " ms");
+        BOOST_REQUIRE_EQUAL (fix.graph.getNumNodes(), numNodes);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,3 +1,5 @@
+#include <thread>
+
 #include <boost/test/unit_test.hpp>
 #include "fixture/PreparedGraph.h"
 #include "fixture/TestNode.h"
@@ -46,6 +48,41 @@ BOOST_AUTO_TEST_CASE (Enablement)
     node = nullptr;
 }
 
+BOOST_AUTO_TEST_CASE (EnablementOffMessageThread)
+{
+    PreparedGraph fix;
+    ProcessorPtr node = fix.graph.addNode (new TestNode());
+    int numChanges = 0;
+    auto changed = node->enablementChanged.connect ([&numChanges] (Processor*) { ++numChanges; });
+
+    auto toggle = [&node] (bool enable) {
+        std::thread thread ([&node, enable]() { node->setEnabled (enable); });
+        thread.join();
+    };
+
+    // disabling stops rendering before the message thread runs
+    toggle (false);
+    BOOST_REQUIRE (! node->isEnabled());
+    BOOST_REQUIRE (! node->isEnabledRequested());
+
+    // a second toggle sees the first, enabling waits for the message thread
+    toggle (true);
+    BOOST_REQUIRE (node->isEnabledRequested());
+    BOOST_REQUIRE (! node->isEnabled());
+
+    juce::MessageManager::getInstance()->runDispatchLoopUntil (20);
+    BOOST_REQUIRE (node->isEnabled());
+    BOOST_REQUIRE_EQUAL (numChanges, 0);
+
+    toggle (false);
+    juce::MessageManager::getInstance()->runDispatchLoopUntil (20);
+    BOOST_REQUIRE (! node->isEnabled());
+    BOOST_REQUIRE_EQUAL (numChanges, 1);
+
+    changed.disconnect();
+    node = nullptr;
+}
+
 BOOST_AUTO_TEST_CASE (PortChannelMapping)
 {
     PreparedGraph fix;
@@ -73,4 +73,22 @@ BOOST_AUTO_TEST_CASE (HiddenBlockPorts)
     BOOST_REQUIRE_MESSAGE (! port.isHiddenOnBlock(), "Modified should not be hidden on block");
 }
 
+BOOST_AUTO_TEST_CASE (PluginStateCopy)
+{
+    Node node (types::Node);
+    auto saved = node.getPluginState();
+    BOOST_REQUIRE_EQUAL (saved.program, -1);
+    BOOST_REQUIRE_EQUAL (saved.state.getSize(), (size_t) 0);
+
+    const char data[] = "plugin state";
+    MemoryBlock block (data, sizeof (data));
+    node.setProperty (tags::state, block.toBase64Encoding());
+    node.setProperty (tags::program, 3);
+
+    saved = node.getPluginState();
+    BOOST_REQUIRE_EQUAL (saved.program, 3);
+    BOOST_REQUIRE (saved.state == block);
+    BOOST_REQUIRE_EQUAL (saved.programState.getSize(), (size_t) 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -30,4 +30,27 @@ BOOST_AUTO_TEST_CASE (Basics)
     os.reset();
 }
 
+BOOST_AUTO_TEST_CASE (Quality)
+{
+    Oversampler<float> os;
+    BOOST_REQUIRE (os.getQuality() == Oversampler<float>::lowLatency);
+    os.prepare (2, 512);
+    const auto iirLatency = os.getLatencySamples (0);
+
+    os.setQuality (Oversampler<float>::linearPhase);
+    os.prepare (2, 512);
+    const auto firLatency = os.getLatencySamples (0);
+
+    os.setQuality (Oversampler<float>::maxQuality);
+    os.prepare (2, 512);
+    const auto maxLatency = os.getLatencySamples (0);
+
+    // latency is whole samples so graphs can compensate it exactly
+    for (auto latency : { iirLatency, firLatency, maxLatency })
+        BOOST_REQUIRE_EQUAL (latency, std::floor (latency));
+
+    BOOST_REQUIRE_LT (iirLatency, firLatency);
+    BOOST_REQUIRE_LE (firLatency, maxLatency);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,144 @@
+#include <boost/test/unit_test.hpp>
+
+#include "session/pluginscancache.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+PluginDescription makeType (const String& file)
+{
+    PluginDescription desc;
+    desc.name = "Test";
+    desc.pluginFormatName = "VST3";
+    desc.fileOrIdentifier = file;
+    desc.uniqueId = 1234;
+    return desc;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (PluginScanCacheTests)
+
+BOOST_AUTO_TEST_CASE (DetectsChanges)
+{
+    TemporaryFile tmp;
+    const auto& file = tmp.getFile();
+    BOOST_REQUIRE (file.replaceWithText ("plugin"));
+
+    PluginScanCache cache;
+    Array<PluginDescription> types;
+    bool failed = false;
+    const auto stamp = PluginScanCache::stampFor (file);
+    BOOST_REQUIRE (stamp.isValid());
+    BOOST_REQUIRE_EQUAL (cache.lookup ("VST3", file.getFullPathName(), stamp, types, failed), PluginScanCache::missing);
+
+    cache.set ("VST3", file.getFullPathName(), stamp, { makeType (file.getFullPathName()) }, false);
+    BOOST_REQUIRE_EQUAL (cache.lookup ("VST3", file.getFullPathName(), stamp, types, failed), PluginScanCache::unchanged);
+    BOOST_REQUIRE_EQUAL (types.size(), 1);
+    BOOST_REQUIRE (! failed);
+
+    BOOST_REQUIRE (file.replaceWithText ("a bigger plugin"));
+    const auto newStamp = PluginScanCache::stampFor (file);
+    BOOST_REQUIRE_EQUAL (cache.lookup ("VST3", file.getFullPathName(), newStamp, types, failed), PluginScanCache::changed);
+}
+
+BOOST_AUTO_TEST_CASE (BundlesHashContents)
+{
+    const auto dir = File::createTempFile ("bundle");
+    BOOST_REQUIRE (dir.createDirectory());
+    BOOST_REQUIRE (dir.getChildFile ("manifest.ttl").replaceWithText ("manifest"));
+    const auto stamp = PluginScanCache::stampFor (dir);
+    BOOST_REQUIRE (stamp.hash.isNotEmpty());
+
+    BOOST_REQUIRE (dir.getChildFile ("plugin.ttl").replaceWithText ("plugin"));
+    BOOST_REQUIRE (PluginScanCache::stampFor (dir) != stamp);
+    dir.deleteRecursively();
+}
+
+BOOST_AUTO_TEST_CASE (SaveAndLoad)
+{
+    PluginScanCache cache;
+    PluginScanCache::Stamp stamp;
+    stamp.modified = 100;
+    stamp.size = 200;
+    stamp.hash = "abc";
+    cache.set ("VST3", "/a.vst3", stamp, { makeType ("/a.vst3") }, false);
+    cache.set ("VST3", "/b.vst3", stamp, {}, true);
+    cache.set ("LV2", "urn:test", stamp, {}, false);
+
+    TemporaryFile tmp;
+    BOOST_REQUIRE (cache.save (tmp.getFile()));
+
+    PluginScanCache loaded;
+    BOOST_REQUIRE (loaded.load (tmp.getFile()));
+    BOOST_REQUIRE_EQUAL (loaded.size(), 3);
+
+    Array<PluginDescription> types;
+    bool failed = false;
+    BOOST_REQUIRE_EQUAL (loaded.lookup ("VST3", "/a.vst3", stamp, types, failed), PluginScanCache::unchanged);
+    BOOST_REQUIRE_EQUAL (types.size(), 1);
+    BOOST_REQUIRE (types.getReference (0).isDuplicateOf (makeType ("/a.vst3")));
+    BOOST_REQUIRE_EQUAL (loaded.lookup ("VST3", "/b.vst3", stamp, types, failed), PluginScanCache::unchanged);
+    BOOST_REQUIRE (failed);
+
+    loaded.removeFormat ("VST3");
+    BOOST_REQUIRE_EQUAL (loaded.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE (JournalReplay)
+{
+    TemporaryFile tmp;
+    PluginScanCache::Stamp stamp;
+    stamp.modified = 100;
+
+    {
+        PluginScanJournal journal (tmp.getFile());
+        BOOST_REQUIRE (journal.scanning ("VST3", "/a.vst3"));
+        BOOST_REQUIRE (journal.found ("VST3", "/a.vst3", stamp, { makeType ("/a.vst3") }, false));
+        BOOST_REQUIRE (journal.found ("VST3", "/gone.vst3", stamp, { makeType ("/gone.vst3") }, false));
+        BOOST_REQUIRE (journal.dropped ("VST3", "/gone.vst3"));
+        BOOST_REQUIRE (journal.scanning ("VST3", "/crashes.vst3"));
+    }
+
+    KnownPluginList list;
+    PluginScanCache cache;
+    const auto crashed = PluginScanJournal::replay (tmp.getFile(), list, cache);
+    BOOST_REQUIRE_EQUAL (crashed.toStdString(), "/crashes.vst3");
+    BOOST_REQUIRE_EQUAL (list.getNumTypes(), 1);
+    BOOST_REQUIRE (list.getTypeForFile ("/a.vst3") != nullptr);
+    BOOST_REQUIRE_EQUAL (cache.size(), 1);
+    Array<PluginDescription> types;
+    bool failed = false;
+    BOOST_REQUIRE (cache.lookup ("VST3", "/gone.vst3", stamp, types, failed) == PluginScanCache::missing);
+
+    // a second run appends to the same journal
+    {
+        PluginScanJournal journal (tmp.getFile());
+        BOOST_REQUIRE (journal.found ("VST3", "/crashes.vst3", stamp, {}, true));
+    }
+
+    KnownPluginList relaunched;
+    BOOST_REQUIRE (PluginScanJournal::replay (tmp.getFile(), relaunched, cache).isEmpty());
+    BOOST_REQUIRE (relaunched.getBlacklistedFiles().contains ("/crashes.vst3"));
+}
+
+BOOST_AUTO_TEST_CASE (JournalDropsOtherSharesBlacklist)
+{
+    // a worker starts from the user's blacklist, then drops the entries
+    // for files another worker scans
+    TemporaryFile tmp;
+    {
+        PluginScanJournal journal (tmp.getFile());
+        BOOST_REQUIRE (journal.dropped ("VST3", "/other.vst3"));
+    }
+
+    KnownPluginList list;
+    list.addToBlacklist ("/other.vst3");
+    list.addToBlacklist ("/mine.vst3");
+    PluginScanCache cache;
+    BOOST_REQUIRE (PluginScanJournal::replay (tmp.getFile(), list, cache).isEmpty());
+    BOOST_REQUIRE (! list.getBlacklistedFiles().contains ("/other.vst3"));
+    BOOST_REQUIRE (list.getBlacklistedFiles().contains ("/mine.vst3"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
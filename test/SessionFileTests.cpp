@@ -0,0 +1,136 @@
+#include <boost/test/unit_test.hpp>
+
+#include <element/graph.hpp>
+#include <element/node.hpp>
+#include <element/session.hpp>
+#include <element/tags.hpp>
+
+#include "session/sessionfile.hpp"
+#include "ui/sessionimportwizard.hpp"
+#include "testutil.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+MemoryBlock makeState (int size, uint8 seed)
+{
+    MemoryBlock block ((size_t) size);
+    for (int i = 0; i < size; ++i)
+        block[i] = (char) (seed + i);
+    return block;
+}
+
+/** Saves the test context's session with one graph in it. */
+void writeSession (const File& file, bool asXml)
+{
+    auto session = element::test::context()->session();
+    session->clear();
+    session->setName ("Saved");
+    session->addGraph (Graph::create ("Saved Graph", 2, 2, true, true), true);
+    if (asXml)
+        BOOST_REQUIRE (session->createXml()->writeTo (file));
+    else
+        BOOST_REQUIRE (session->writeToFile (file));
+    session->clear();
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (SessionFileTests)
+
+BOOST_AUTO_TEST_CASE (RoundTrip)
+{
+    ValueTree session (types::Session);
+    ValueTree graph (types::Node);
+    ValueTree plugin (types::Node);
+    plugin.setProperty (tags::name, "Plugin", nullptr);
+    StateBlob::set (plugin, tags::state, makeState (1000, 1));
+    plugin.setProperty (tags::programState, makeState (33, 7).toBase64Encoding(), nullptr);
+    graph.appendChild (plugin, nullptr);
+    session.appendChild (graph, nullptr);
+
+    TemporaryFile tmp (".els");
+    BOOST_REQUIRE (SessionFile::write (session, tmp.getFile()));
+    BOOST_REQUIRE (SessionFile::isSessionFile (tmp.getFile()));
+
+    const auto loaded = SessionFile::read (tmp.getFile());
+    BOOST_REQUIRE (loaded.isValid());
+    const auto node = loaded.getChild (0).getChild (0);
+    BOOST_REQUIRE_EQUAL (node.getProperty (tags::name).toString(), String ("Plugin"));
+    BOOST_REQUIRE (StateBlob::fromVar (node.getProperty (tags::state)) != nullptr);
+    BOOST_REQUIRE (StateBlob::decode (node.getProperty (tags::state)) == makeState (1000, 1));
+    BOOST_REQUIRE (StateBlob::decode (node.getProperty (tags::programState)) == makeState (33, 7));
+}
+
+BOOST_AUTO_TEST_CASE (SharesIdenticalState)
+{
+    ValueTree graph (types::Node);
+    for (int i = 0; i < 4; ++i)
+    {
+        ValueTree plugin (types::Node);
+        if (i == 3)
+            plugin.setProperty (tags::state, makeState (4096, 1).toBase64Encoding(), nullptr);
+        else
+            StateBlob::set (plugin, tags::state, makeState (4096, 1));
+        graph.appendChild (plugin, nullptr);
+    }
+
+    TemporaryFile tmp (".elg");
+    BOOST_REQUIRE (SessionFile::write (graph, tmp.getFile()));
+    BOOST_REQUIRE_LT (tmp.getFile().getSize(), 2 * 4096);
+
+    const auto loaded = SessionFile::read (tmp.getFile());
+    BOOST_REQUIRE_EQUAL (loaded.getNumChildren(), 4);
+    auto* first = StateBlob::fromVar (loaded.getChild (0).getProperty (tags::state));
+    BOOST_REQUIRE (first != nullptr);
+    for (int i = 1; i < 4; ++i)
+        BOOST_REQUIRE (StateBlob::fromVar (loaded.getChild (i).getProperty (tags::state)) == first);
+    BOOST_REQUIRE (StateBlob::decode (first) == makeState (4096, 1));
+}
+
+BOOST_AUTO_TEST_CASE (TextCopiesUseBase64)
+{
+    ValueTree node (types::Node);
+    StateBlob::set (node, tags::state, makeState (16, 3));
+    Node::sanitizeProperties (node);
+    BOOST_REQUIRE (node.getProperty (tags::state).isString());
+    BOOST_REQUIRE (StateBlob::decode (node.getProperty (tags::state)) == makeState (16, 3));
+}
+
+BOOST_AUTO_TEST_CASE (RejectsOtherFiles)
+{
+    TemporaryFile tmp (".els");
+    BOOST_REQUIRE (tmp.getFile().replaceWithText ("<SESSION/>"));
+    BOOST_REQUIRE (! SessionFile::isSessionFile (tmp.getFile()));
+    BOOST_REQUIRE (! SessionFile::read (tmp.getFile()).isValid());
+}
+
+BOOST_AUTO_TEST_CASE (ReadsEveryFormat)
+{
+    for (const bool asXml : { false, true })
+    {
+        TemporaryFile tmp (".els");
+        writeSession (tmp.getFile(), asXml);
+        BOOST_REQUIRE_EQUAL (SessionFile::isSessionFile (tmp.getFile()), ! asXml);
+
+        const auto data = Session::readFromFile (tmp.getFile());
+        BOOST_REQUIRE (data.hasType (types::Session));
+        BOOST_REQUIRE_EQUAL ((int) data.getProperty (tags::version), EL_SESSION_VERSION);
+        BOOST_REQUIRE_EQUAL (data.getChildWithName (tags::graphs).getNumChildren(), 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (ImportsBinarySession)
+{
+    TemporaryFile tmp (".els");
+    writeSession (tmp.getFile(), false);
+
+    SessionImportWizard wizard;
+    wizard.loadSession (tmp.getFile());
+    auto imported = wizard.session();
+    BOOST_REQUIRE (imported != nullptr);
+    BOOST_REQUIRE_EQUAL (imported->getNumGraphs(), 1);
+    BOOST_REQUIRE_EQUAL (imported->getGraph (0).getName(), String ("Saved Graph"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
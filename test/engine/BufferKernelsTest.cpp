@@ -0,0 +1,123 @@
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <element/juce/core.hpp>
+
+#include "engine/bufferkernels.hpp"
+
+using namespace element;
+
+namespace {
+/** Runs the same operation with both kernel sets and returns the largest difference. */
+static float maxDifference (const std::function<void (float*, const float*, int)>& fast,
+                            const std::function<void (float*, const float*, int)>& scalar,
+                            int numSamples)
+{
+    std::vector<float> src ((size_t) numSamples), a ((size_t) numSamples), b ((size_t) numSamples);
+    for (int i = 0; i < numSamples; ++i)
+    {
+        src[(size_t) i] = std::sin ((float) i * 0.01f);
+        a[(size_t) i] = b[(size_t) i] = std::cos ((float) i * 0.03f);
+    }
+
+    fast (a.data(), src.data(), numSamples);
+    scalar (b.data(), src.data(), numSamples);
+
+    float diff = 0.f;
+    for (int i = 0; i < numSamples; ++i)
+        diff = std::max (diff, std::abs (a[(size_t) i] - b[(size_t) i]));
+    return diff;
+}
+
+/** Returns the time in ms to run an operation over a block many times. */
+static double timeKernel (const std::function<void (float*, const float*, int)>& kernel, int numSamples)
+{
+    std::vector<float> src ((size_t) numSamples, 0.5f), dst ((size_t) numSamples, 0.25f);
+    const auto start = juce::Time::getMillisecondCounterHiRes();
+    for (int i = 0; i < 20000; ++i)
+        kernel (dst.data(), src.data(), numSamples);
+    return juce::Time::getMillisecondCounterHiRes() - start;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (BufferKernelsTest)
+
+BOOST_AUTO_TEST_CASE (MatchesScalar)
+{
+    using K = BufferKernels;
+    using S = BufferKernels::Scalar;
+
+    for (const int n : { 0, 1, 3, 4, 7, 8, 15, 16, 31, 512, 1001 })
+    {
+        BOOST_REQUIRE_SMALL (maxDifference (K::copy, S::copy, n), 1.0e-6f);
+        BOOST_REQUIRE_SMALL (maxDifference (K::add, S::add, n), 1.0e-6f);
+
+        BOOST_REQUIRE_SMALL (maxDifference ([] (float* d, const float* s, int num) { K::addWithGain (d, s, 0.7f, num); },
+                                            [] (float* d, const float* s, int num) { S::addWithGain (d, s, 0.7f, num); },
+                                            n),
+                             1.0e-6f);
+        BOOST_REQUIRE_SMALL (maxDifference ([] (float* d, const float* s, int num) { K::addWithRamp (d, s, 0.1f, 0.9f, num); },
+                                            [] (float* d, const float* s, int num) { S::addWithRamp (d, s, 0.1f, 0.9f, num); },
+                                            n),
+                             1.0e-5f);
+        BOOST_REQUIRE_SMALL (maxDifference ([] (float* d, const float* s, int num) { K::copyWithRamp (d, s, 1.f, 0.f, num); },
+                                            [] (float* d, const float* s, int num) { S::copyWithRamp (d, s, 1.f, 0.f, num); },
+                                            n),
+                             1.0e-5f);
+        BOOST_REQUIRE_SMALL (maxDifference ([] (float* d, const float*, int num) { K::applyRamp (d, 0.f, 1.f, num); },
+                                            [] (float* d, const float*, int num) { S::applyRamp (d, 0.f, 1.f, num); },
+                                            n),
+                             1.0e-5f);
+        BOOST_REQUIRE_SMALL (maxDifference ([] (float* d, const float*, int num) { K::fillRamp (d, -1.f, 1.f, num); },
+                                            [] (float* d, const float*, int num) { S::fillRamp (d, -1.f, 1.f, num); },
+                                            n),
+                             1.0e-5f);
+
+        std::vector<float> quiet ((size_t) n, 1.0e-7f);
+        BOOST_REQUIRE (K::isSilent (quiet.data(), 1.0e-6f, n));
+        for (int i = 0; i < n; ++i)
+        {
+            quiet[(size_t) i] = -0.5f;
+            BOOST_REQUIRE (! K::isSilent (quiet.data(), 1.0e-6f, n));
+            quiet[(size_t) i] = 0.f;
+        }
+
+        std::vector<float> a ((size_t) n, 0.5f), b ((size_t) n, 0.5f);
+        const float fast = K::applyRampAndSumSquares (a.data(), 0.25f, 1.f, n);
+        const float scalar = S::applyRampAndSumSquares (b.data(), 0.25f, 1.f, n);
+        BOOST_REQUIRE_SMALL (fast - scalar, 1.0e-3f);
+        BOOST_REQUIRE_SMALL (maxDifference ([] (float* d, const float*, int num) { K::applyRampAndSumSquares (d, 0.5f, 0.f, num); },
+                                            [] (float* d, const float*, int num) { S::applyRampAndSumSquares (d, 0.5f, 0.f, num); },
+                                            n),
+                             1.0e-5f);
+    }
+}
+
+BOOST_AUTO_TEST_CASE (Benchmark)
+{
+    using K = BufferKernels;
+    using S = BufferKernels::Scalar;
+    const int n = 512;
+    BOOST_REQUIRE (K::getInstructionSet() != nullptr);
+
+    const auto report = [n] (const char* name, double fast, double scalar) {
+        BOOST_TEST_MESSAGE (name << " (" << n << " samples, " << K::getInstructionSet() << "): "
+                                 << fast << " ms vs scalar " << scalar << " ms");
+    };
+
+    report ("add", timeKernel (K::add, n), timeKernel (S::add, n));
+    report ("addWithRamp",
+            timeKernel ([] (float* d, const float* s, int num) { K::addWithRamp (d, s, 0.f, 1.f, num); }, n),
+            timeKernel ([] (float* d, const float* s, int num) { S::addWithRamp (d, s, 0.f, 1.f, num); }, n));
+    report ("applyRamp",
+            timeKernel ([] (float* d, const float*, int num) { K::applyRamp (d, 0.999f, 1.001f, num); }, n),
+            timeKernel ([] (float* d, const float*, int num) { S::applyRamp (d, 0.999f, 1.001f, num); }, n));
+    report ("fillRamp",
+            timeKernel ([] (float* d, const float*, int num) { K::fillRamp (d, 0.f, 1.f, num); }, n),
+            timeKernel ([] (float* d, const float*, int num) { S::fillRamp (d, 0.f, 1.f, num); }, n));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,52 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/midiinputqueue.hpp"
+
+using namespace element;
+using namespace juce;
+
+BOOST_AUTO_TEST_SUITE (MidiInputQueueTest)
+
+static MidiMessage noteAt (int note, double time)
+{
+    auto msg = MidiMessage::noteOn (1, note, 0.5f);
+    msg.setTimeStamp (time);
+    return msg;
+}
+
+BOOST_AUTO_TEST_CASE (SampleOffsets)
+{
+    const double rate = 48000.0, period = 512.0 / rate, start = 100.0;
+    MidiInputQueue queue (8);
+    queue.prepare (rate);
+
+    BOOST_REQUIRE (queue.push (noteAt (60, start - period * 0.5)));
+    BOOST_REQUIRE (queue.push (noteAt (61, start + 0.001)));
+
+    MidiBuffer midi;
+    queue.render (midi, 512, start);
+    BOOST_REQUIRE_EQUAL (midi.getNumEvents(), 1);
+    BOOST_REQUIRE_LE (std::abs (midi.getFirstEventTime() - 256), 1);
+
+    // the second note arrived during the next period
+    midi.clear();
+    queue.render (midi, 512, start + period);
+    BOOST_REQUIRE_EQUAL (midi.getNumEvents(), 1);
+    BOOST_REQUIRE_LE (std::abs (midi.getFirstEventTime() - 48), 1);
+    for (auto m : midi)
+        BOOST_REQUIRE_EQUAL (m.getMessage().getNoteNumber(), 61);
+}
+
+BOOST_AUTO_TEST_CASE (RejectsWhatDoesNotFit)
+{
+    MidiInputQueue queue (2);
+    queue.prepare (44100.0);
+
+    uint8 sysex[MidiInputQueue::maxMessageSize] = {};
+    BOOST_REQUIRE (! queue.push (MidiMessage::createSysExMessage (sysex, MidiInputQueue::maxMessageSize)));
+
+    BOOST_REQUIRE (queue.push (noteAt (60, 0.0)));
+    BOOST_REQUIRE (queue.push (noteAt (61, 0.0)));
+    BOOST_REQUIRE (! queue.push (noteAt (62, 0.0)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
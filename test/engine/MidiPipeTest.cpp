@@ -0,0 +1,39 @@
+#include <boost/test/unit_test.hpp>
+#include <element/midipipe.hpp>
+
+using namespace element;
+using namespace juce;
+
+BOOST_AUTO_TEST_SUITE (MidiPipeTest)
+
+BOOST_AUTO_TEST_CASE (ScaleTimestamps)
+{
+    MidiBuffer a, b;
+    a.addEvent (MidiMessage::noteOn (1, 60, 0.5f), 0);
+    a.addEvent (MidiMessage::programChange (1, 3), 7); // 2 bytes
+    a.addEvent (MidiMessage::noteOff (1, 60), 31);
+    const uint8 sysex[] = { 1, 2, 3, 4, 5 };
+    b.addEvent (MidiMessage::createSysExMessage (sysex, 5), 5);
+
+    MidiBuffer* buffers[] = { &a, &b };
+    MidiPipe pipe (buffers, 2);
+    const auto bytes = a.data;
+
+    pipe.scaleTimestamps (4, 1);
+    BOOST_REQUIRE_EQUAL (a.getFirstEventTime(), 0);
+    BOOST_REQUIRE_EQUAL (a.getLastEventTime(), 124);
+    BOOST_REQUIRE_EQUAL (b.getFirstEventTime(), 20);
+
+    Array<int> times;
+    for (auto m : a)
+        times.add (m.samplePosition);
+    BOOST_REQUIRE (times == Array<int> ({ 0, 28, 124 }));
+
+    pipe.scaleTimestamps (1, 4);
+    BOOST_REQUIRE (a.data == bytes);
+    BOOST_REQUIRE_EQUAL (b.getFirstEventTime(), 5);
+    for (auto m : b)
+        BOOST_REQUIRE (m.getMessage().isSysEx());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
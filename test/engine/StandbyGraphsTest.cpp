@@ -0,0 +1,133 @@
+#include <boost/test/unit_test.hpp>
+#include "engine/standbygraphs.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+struct FakeGraph
+{
+    int index = 0;
+    bool loaded = false;
+    bool parallel = false;
+};
+
+/** A set of graphs which loads and unloads like EngineService does. */
+struct FakeSet
+{
+    FakeSet (int numGraphs)
+    {
+        for (int i = 0; i < numGraphs; ++i)
+            graphs.add (new FakeGraph())->index = i;
+        for (auto* g : graphs)
+            order.add (g);
+    }
+
+    void activate (int index, int numStandby)
+    {
+        loads.clearQuick();
+        unloads.clearQuick();
+        const auto keep = standby.choose (order, index, numStandby, [] (FakeGraph* g) {
+            return ! g->parallel;
+        });
+        for (auto* g : graphs)
+        {
+            if (keep.contains (g) && ! g->loaded)
+                loads.add (g->index);
+            else if (! keep.contains (g) && g->loaded)
+                unloads.add (g->index);
+            g->loaded = keep.contains (g);
+        }
+    }
+
+    Array<int> getLoaded() const
+    {
+        Array<int> result;
+        for (auto* g : graphs)
+            if (g->loaded)
+                result.add (g->index);
+        return result;
+    }
+
+    OwnedArray<FakeGraph> graphs;
+    Array<FakeGraph*> order;
+    StandbyGraphs<FakeGraph> standby;
+    Array<int> loads, unloads;
+};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (StandbyGraphsTest)
+
+BOOST_AUTO_TEST_CASE (KeepsNextAndRecent)
+{
+    // two standbys: one for the next graph, one for the most recent
+    FakeSet set (6);
+
+    set.activate (0, 2);
+    BOOST_REQUIRE (set.getLoaded() == Array<int> ({ 0, 1 }));
+
+    set.activate (3, 2);
+    BOOST_REQUIRE (set.getLoaded() == Array<int> ({ 0, 3, 4 }));
+    BOOST_REQUIRE (set.loads == Array<int> ({ 3, 4 }));
+    BOOST_REQUIRE (set.unloads == Array<int> ({ 1 }));
+
+    // nothing follows the last graph, recent ones fill the standbys
+    set.activate (5, 2);
+    BOOST_REQUIRE (set.getLoaded() == Array<int> ({ 0, 3, 5 }));
+    BOOST_REQUIRE (set.loads == Array<int> ({ 5 }));
+    BOOST_REQUIRE (set.unloads == Array<int> ({ 4 }));
+
+    // the least recently used graph is unloaded first
+    set.activate (0, 2);
+    BOOST_REQUIRE (set.getLoaded() == Array<int> ({ 0, 1, 5 }));
+    BOOST_REQUIRE (set.loads == Array<int> ({ 1 }));
+    BOOST_REQUIRE (set.unloads == Array<int> ({ 3 }));
+}
+
+BOOST_AUTO_TEST_CASE (ReactivatingKeepsLoaded)
+{
+    FakeSet set (4);
+    set.activate (1, 2);
+    const auto loaded = set.getLoaded();
+    set.activate (1, 2);
+    BOOST_REQUIRE (set.getLoaded() == loaded);
+    BOOST_REQUIRE (set.loads.isEmpty());
+    BOOST_REQUIRE (set.unloads.isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE (ForgetsRemovedGraphs)
+{
+    FakeSet set (4);
+    set.activate (2, 2);
+    set.activate (0, 2);
+    BOOST_REQUIRE (set.standby.getRecent() == Array<FakeGraph*> ({ set.order[0], set.order[2] }));
+
+    set.standby.remove (set.order[2]);
+    BOOST_REQUIRE (set.standby.getRecent() == Array<FakeGraph*> ({ set.order[0] }));
+    BOOST_REQUIRE (set.standby.choose (set.order, 0, 2) == Array<FakeGraph*> ({ set.order[0], set.order[1] }));
+}
+
+BOOST_AUTO_TEST_CASE (ParallelGraphsStayLoaded)
+{
+    // graphs 1 and 4 always render, the budget goes to the others
+    FakeSet set (6);
+    set.graphs[1]->parallel = set.graphs[4]->parallel = true;
+
+    set.activate (0, 2);
+    BOOST_REQUIRE (set.getLoaded() == Array<int> ({ 0, 1, 2, 4 }));
+
+    set.activate (3, 2);
+    BOOST_REQUIRE (set.getLoaded() == Array<int> ({ 0, 1, 3, 4, 5 }));
+    BOOST_REQUIRE (set.unloads == Array<int> ({ 2 }));
+
+    set.activate (5, 2);
+    BOOST_REQUIRE (set.getLoaded() == Array<int> ({ 0, 1, 3, 4, 5 }));
+    BOOST_REQUIRE (set.unloads.isEmpty());
+
+    set.activate (2, 2);
+    BOOST_REQUIRE (set.getLoaded() == Array<int> ({ 1, 2, 3, 4, 5 }));
+    BOOST_REQUIRE (set.unloads == Array<int> ({ 0 }));
+    BOOST_REQUIRE (! set.standby.getRecent().contains (set.order[1]));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,106 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lv2/workthread.hpp"
+
+using namespace element;
+using namespace juce;
+
+namespace {
+class TestWorker : public WorkerBase {
+public:
+    TestWorker (WorkerPool& pool, int sleepMs = 0)
+        : WorkerBase (pool, 1024), delay (sleepMs) {}
+
+    void processRequest (uint32_t size, const void* data) override
+    {
+        if (delay > 0)
+            Thread::sleep (delay);
+        // requests are filled with their size, so a partial read shows
+        auto* const bytes = static_cast<const uint8*> (data);
+        for (uint32_t i = 0; i < size; ++i)
+            if (bytes[i] != (uint8) size)
+            {
+                ++numCorrupt;
+                break;
+            }
+        lastSize.set ((int) size);
+        ++numProcessed;
+    }
+
+    void processResponse (uint32_t, const void*) override {}
+
+    Atomic<int> numProcessed { 0 };
+    Atomic<int> lastSize { 0 };
+    Atomic<int> numCorrupt { 0 };
+
+private:
+    const int delay;
+};
+
+static bool waitFor (std::function<bool()> condition, int timeoutMs)
+{
+    const auto end = Time::getMillisecondCounter() + (uint32) timeoutMs;
+    while (! condition())
+    {
+        if (Time::getMillisecondCounter() > end)
+            return false;
+        Thread::sleep (1);
+    }
+    return true;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE (WorkerPoolTest)
+
+BOOST_AUTO_TEST_CASE (SlowWorkerDoesNotBlockOthers)
+{
+    WorkerPool pool (2);
+    TestWorker slow (pool, 1000), fast (pool);
+    const uint32_t request = 0;
+
+    BOOST_REQUIRE (slow.scheduleWork (sizeof (request), &request));
+    BOOST_REQUIRE (waitFor ([&] { return slow.isWorking(); }, 1000));
+
+    for (int i = 0; i < 10; ++i)
+        BOOST_REQUIRE (fast.scheduleWork (sizeof (request), &request));
+    BOOST_REQUIRE (waitFor ([&] { return fast.numProcessed.get() == 10; }, 500));
+    BOOST_REQUIRE_EQUAL (slow.numProcessed.get(), 0);
+
+    // let it finish before the workers go away
+    BOOST_REQUIRE (waitFor ([&] { return slow.numProcessed.get() == 1 && ! slow.isWorking(); }, 2000));
+}
+
+BOOST_AUTO_TEST_CASE (GrowsForLargeRequests)
+{
+    WorkerPool pool (1);
+    TestWorker worker (pool);
+    HeapBlock<uint8> request (16384, true);
+
+    // doesn't fit the first time, but the queue grows so the retry does
+    BOOST_REQUIRE (! worker.scheduleWork (16384, request.getData()));
+    BOOST_REQUIRE (waitFor ([&] { return worker.scheduleWork (16384, request.getData()); }, 1000));
+    BOOST_REQUIRE (waitFor ([&] { return worker.numProcessed.get() == 1; }, 1000));
+    BOOST_REQUIRE_EQUAL (worker.lastSize.get(), 16384);
+}
+
+BOOST_AUTO_TEST_CASE (ReadsWholeRequestsWhileGrowing)
+{
+    WorkerPool pool (2);
+    TestWorker worker (pool);
+    HeapBlock<uint8> request (8192);
+    int numScheduled = 0;
+
+    // keep writing while big requests make the queue grow
+    for (int i = 0; i < 2000; ++i)
+    {
+        const auto size = (uint32_t) (i % 50 == 49 ? 6000 + i : 1 + (i % 200));
+        std::memset (request.getData(), (uint8) size, size);
+        if (worker.scheduleWork (size, request.getData()))
+            ++numScheduled;
+    }
+
+    BOOST_REQUIRE (waitFor ([&] { return worker.numProcessed.get() == numScheduled; }, 5000));
+    BOOST_REQUIRE_EQUAL (worker.numCorrupt.get(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
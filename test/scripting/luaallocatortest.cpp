@@ -0,0 +1,78 @@
+// Copyright 2023 Kushview, LLC <info@kushview.net>
+// SPDX-License-Identifier: GPL3-or-later
+
+#include <boost/test/unit_test.hpp>
+
+#include <lua.hpp>
+
+#include "scripting/luaallocator.hpp"
+
+using namespace element;
+
+BOOST_AUTO_TEST_SUITE (LuaAllocatorTest)
+
+BOOST_AUTO_TEST_CASE (AllocateAndFree)
+{
+    LuaAllocator pool (64 * 1024);
+    auto* a = pool.allocate (100);
+    auto* b = pool.allocate (1000);
+    BOOST_REQUIRE (a != nullptr && b != nullptr);
+    BOOST_REQUIRE_EQUAL ((uintptr_t) a % 16, (uintptr_t) 0);
+    BOOST_REQUIRE_GE (pool.getBytesUsed(), (size_t) 1100);
+
+    b = pool.reallocate (b, 10);
+    BOOST_REQUIRE (b != nullptr);
+    a = pool.reallocate (a, 4000);
+    BOOST_REQUIRE (a != nullptr);
+
+    pool.deallocate (a);
+    pool.deallocate (b);
+    BOOST_REQUIRE_EQUAL (pool.getBytesUsed(), (size_t) 0);
+    BOOST_REQUIRE_GE (pool.getPeakBytesUsed(), (size_t) 4000);
+}
+
+BOOST_AUTO_TEST_CASE (MergesFreeBlocks)
+{
+    LuaAllocator pool (64 * 1024);
+    void* blocks[8];
+    for (auto& block : blocks)
+        BOOST_REQUIRE ((block = pool.allocate (6000)) != nullptr);
+    BOOST_REQUIRE (pool.allocate (32 * 1024) == nullptr);
+    BOOST_REQUIRE_EQUAL (pool.getNumFailedAllocations(), 1);
+
+    for (auto* block : blocks)
+        pool.deallocate (block);
+    auto* large = pool.allocate (32 * 1024);
+    BOOST_REQUIRE (large != nullptr);
+    pool.deallocate (large);
+}
+
+BOOST_AUTO_TEST_CASE (RunsLua)
+{
+    LuaAllocator pool (4 * 1024 * 1024);
+    auto* L = lua_newstate (LuaAllocator::alloc, &pool);
+    BOOST_REQUIRE (L != nullptr);
+    luaL_openlibs (L);
+
+    LuaCollector collector;
+    collector.attach (L, pool);
+    collector.setBudget (0.001);
+
+    const char* code = "function garbage() local t = {} for i = 1, 1000 do t[i] = { i } end end";
+    BOOST_REQUIRE_EQUAL (luaL_dostring (L, code), LUA_OK);
+    for (int i = 0; i < 500; ++i)
+    {
+        lua_getglobal (L, "garbage");
+        BOOST_REQUIRE_EQUAL (lua_pcall (L, 0, 0, 0), LUA_OK);
+        collector.step();
+    }
+
+    // without the collector steps this would have filled the pool
+    BOOST_REQUIRE_EQUAL (pool.getNumFailedAllocations(), 0);
+    BOOST_REQUIRE_LT (pool.getPeakBytesUsed(), pool.getPoolSize() / 2);
+
+    lua_close (L);
+    BOOST_REQUIRE_EQUAL (pool.getBytesUsed(), (size_t) 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,76 @@
+local AudioBuffer = require ('el.AudioBuffer')
+
+local function near (a, b)
+    return math.abs (a - b) < 1.0e-5
+end
+
+local a = AudioBuffer.new (2, 64)
+local b = AudioBuffer.new (2, 64)
+for i = 1, 64 do
+    a:set (1, i, 0.5)
+    b:set (1, i, 0.25)
+    b:set (2, i, i / 64)
+end
+
+a:copy (2, a, 1)
+BOOST_REQUIRE (near (a:get (2, 64), 0.5))
+
+a:add (1, b, 1)
+BOOST_REQUIRE (near (a:get (1, 1), 0.75))
+a:add (1, b, 1, -1.0, 33, 32)
+BOOST_REQUIRE (near (a:get (1, 32), 0.75))
+BOOST_REQUIRE (near (a:get (1, 33), 0.5))
+
+a:clear (1)
+a:mix (1, b, 1, 0.0, 1.0)
+BOOST_REQUIRE (near (a:get (1, 1), 0.0))
+BOOST_REQUIRE (a:get (1, 64) > 0.24)
+
+a:multiply (2, b, 2)
+BOOST_REQUIRE (near (a:get (2, 64), 0.5))
+BOOST_REQUIRE (near (a:get (2, 32), 0.25))
+
+BOOST_REQUIRE (near (b:peakall(), 1.0))
+BOOST_REQUIRE (near (b:peakall (1, 32), 0.5))
+BOOST_REQUIRE (near (b:peakall (33), 1.0))
+BOOST_REQUIRE (near (b:peak (1), 0.25))
+BOOST_REQUIRE (near (b:peak (2, 1, 32), 0.5))
+BOOST_REQUIRE (near (b:peak (2, 33), 1.0))
+BOOST_REQUIRE (near (b:peak (2, 64, 1), 1.0))
+BOOST_REQUIRE (near (b:rms (1), 0.25))
+BOOST_REQUIRE (near (b:rms (1, 33), 0.25))
+BOOST_REQUIRE (near (b:rms (2, 64, 1), 1.0))
+BOOST_REQUIRE (near (b:rmsall (1, 1), math.sqrt ((0.25 * 0.25 + (1 / 64) * (1 / 64)) / 2)))
+BOOST_REQUIRE (not pcall (b.peak, b))
+BOOST_REQUIRE (not pcall (b.rms, b, 3))
+
+-- channels are checked against the buffer they index
+local mono = AudioBuffer.new (1, 16)
+BOOST_REQUIRE (not pcall (a.copy, a, 3, b, 1))
+BOOST_REQUIRE (not pcall (a.copy, a, 1, mono, 2))
+BOOST_REQUIRE (not pcall (a.add, a, 0, b, 1))
+BOOST_REQUIRE (not pcall (a.mix, a, 1, mono, 2, 0.0, 1.0))
+BOOST_REQUIRE (not pcall (a.multiply, a, 1, b, 5))
+BOOST_REQUIRE (not pcall (a.biquad, a, 3, { b0 = 1 }))
+BOOST_REQUIRE (not pcall (a.onepole, a, -1, { a = 0.5 }))
+BOOST_REQUIRE (not pcall (a.raw, a, 3))
+
+-- ranges past the end of a shorter source do nothing
+a:clear()
+a:copy (1, mono, 1, 33)
+BOOST_REQUIRE (near (a:peak (1), 0.0))
+
+-- unity gain biquad keeps the signal, state carries over blocks
+local pass = { b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0, z1 = 0, z2 = 0 }
+b:biquad (1, pass)
+BOOST_REQUIRE (near (b:get (1, 10), 0.25))
+
+local lp = { a = 0.5, z = 0 }
+a:clear()
+a:set (1, 1, 1.0)
+a:onepole (1, lp)
+BOOST_REQUIRE (near (a:get (1, 1), 0.5))
+BOOST_REQUIRE (near (a:get (1, 2), 0.25))
+BOOST_REQUIRE (lp.z > 0.0)
+
+BOOST_REQUIRE (type (a:raw (1)) == 'userdata')